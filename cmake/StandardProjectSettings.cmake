@@ -32,3 +32,5 @@ if(ENABLE_IPO)
     message(SEND_ERROR "IPO is not supported: ${output}")
   endif()
 endif()
+
+option(ENABLE_AVX "Build the SIMD kernels in util with AVX instead of SSE2" OFF)
@@ -0,0 +1,257 @@
+#include <SDL.h>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/buffer_arena.hpp"
+#include "util/frame_constants.hpp"
+#include "util/gl_state.hpp"
+#include "util/shader.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
+
+namespace {
+
+///
+/// Box of `size` centered on `center`, positions only.
+///
+auto add_box(std::vector<GLfloat>& vertices,
+             std::vector<std::uint32_t>& indices,
+             glm::vec3 const& center,
+             glm::vec3 const& size) -> void
+{
+    glm::vec3 const half = size * 0.5F;
+
+    for(int corner = 0; corner < 8; ++corner) {
+        glm::vec3 const sign{ (corner & 1) != 0 ? 1.0F : -1.0F,
+                              (corner & 2) != 0 ? 1.0F : -1.0F,
+                              (corner & 4) != 0 ? 1.0F : -1.0F };
+        glm::vec3 const p = center + sign * half;
+        vertices.insert(vertices.end(), { p.x, p.y, p.z });
+    }
+
+    // Two triangles per face, counter-clockwise seen from outside
+    indices.insert(indices.end(), { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,   // NOLINT
+                                    2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 }); // NOLINT
+}
+
+///
+/// Square based pyramid standing on `base`, positions only.
+///
+auto add_pyramid(std::vector<GLfloat>& vertices,
+                 std::vector<std::uint32_t>& indices,
+                 glm::vec3 const& base,
+                 float const width,
+                 float const height) -> void
+{
+    float const half = width * 0.5F;
+
+    vertices.insert(vertices.end(),
+                    { base.x - half, base.y, base.z - half, base.x + half, base.y, base.z - half, // NOLINT
+                      base.x + half, base.y, base.z + half, base.x - half, base.y, base.z + half, // NOLINT
+                      base.x,        base.y + height, base.z });                                  // NOLINT
+
+    indices.insert(indices.end(), { 0, 1, 2, 0, 2, 3, 0, 4, 1, 1, 4, 2, 2, 4, 3, 3, 4, 0 }); // NOLINT
+}
+
+} // namespace
+
+auto sdl_error(std::string const& msg) -> void
+{
+    spdlog::error("[SDL2] <<{}>>: {}!", msg, SDL_GetError());
+    std::exit(EXIT_FAILURE);
+}
+
+struct color
+{
+    GLfloat r = 0.0F;
+    GLfloat g = 0.0F;
+    GLfloat b = 0.0F;
+    GLfloat a = 1.0F;
+};
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept -> int
+{
+    spdlog::info("Hello triangle!");
+
+    auto sdl_window_deleter = [](SDL_Window* w) noexcept {
+        SDL_DestroyWindow(w);
+        SDL_Quit();
+    };
+    auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
+
+    using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
+    using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
+
+    constexpr int window_width = 1280;
+    constexpr int window_height = 720;
+
+    if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+        sdl_error("Couldn't initialize SDL");
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+    window_t window{ SDL_CreateWindow("HelloTriangle!",
+                                      SDL_WINDOWPOS_CENTERED,
+                                      SDL_WINDOWPOS_CENTERED,
+                                      window_width,
+                                      window_height,
+                                      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE),
+                     sdl_window_deleter };
+
+    if(window == nullptr) {
+        sdl_error("Couldn't create a window");
+    }
+
+    renderer_t renderer{ SDL_CreateRenderer(window.get(), -1, SDL_RENDERER_ACCELERATED), sdl_renderer_deleter };
+
+    if(renderer == nullptr) {
+        sdl_error("Couldn't create a renderer");
+    }
+
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ SDL_GL_CreateContext(window.get()), sdl_context_deleter };
+
+    if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
+        spdlog::error("[glad] Failed to initialize OpenGL context");
+        std::exit(EXIT_FAILURE);
+    }
+
+    spdlog::info("[OpenGL] Context created! Version {}.{}", GLVersion.major, GLVersion.minor);
+
+    int num_attributes = 0;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &num_attributes);
+    spdlog::info("[OpenGL] Max number of vertex attributes: {}", num_attributes);
+
+    // A grid of small meshes, each with its own vertex and index range of
+    // the same two buffers and drawn together with one multi-draw call
+    using position_layout = vertex_layout<attr<0, vertex_format::vec3>>;
+
+    constexpr std::size_t arena_vertices = 16 * 1024;
+    constexpr std::size_t arena_indices = 64 * 1024;
+    buffer_arena meshes{ position_layout::stride, arena_vertices, arena_indices };
+    position_layout::apply(meshes.vao(), meshes.vertex_buffer());
+    vertex_array::unbind();
+
+    constexpr int grid_side = 20;
+    constexpr float spacing = 2.0F;
+    std::mt19937 rng{ 1337 }; // NOLINT
+    std::uniform_real_distribution<float> extent{ 0.3F, 1.5F };
+
+    auto const cell_center = [](int const i) {
+        float const offset = (static_cast<float>(grid_side) - 1.0F) * spacing * 0.5F;
+        return glm::vec3{ static_cast<float>(i % grid_side) * spacing - offset,
+                          0.0F,
+                          static_cast<float>(i / grid_side) * spacing - offset };
+    };
+
+    std::vector<GLfloat> vertices{};
+    std::vector<std::uint32_t> indices{};
+    std::vector<mesh_range> ranges{};
+
+    for(int i = 0; i < grid_side * grid_side; ++i) {
+        glm::vec3 const size{ extent(rng), extent(rng), extent(rng) };
+        vertices.clear();
+        indices.clear();
+        add_box(vertices, indices, cell_center(i) + glm::vec3{ 0.0F, size.y * 0.5F, 0.0F }, size);
+        ranges.push_back(meshes.add(vertices.data(), vertices.size() / 3, indices));
+    }
+
+    meshes.report("boxes");
+
+    // Swap every third box for a smaller pyramid, which leaves holes behind
+    // that the allocator merges and hands out again
+    for(std::size_t i = 0; i < ranges.size(); i += 3) {
+        meshes.remove(ranges[i]);
+
+        vertices.clear();
+        indices.clear();
+        float const width = extent(rng);
+        float const height = extent(rng) * 2.0F;
+        add_pyramid(vertices, indices, cell_center(static_cast<int>(i)), width, height);
+        ranges[i] = meshes.add(vertices.data(), vertices.size() / 3, indices);
+    }
+
+    meshes.report("boxes and pyramids");
+
+    shader shader_program{ "shader.vs.glsl", "shader.fs.glsl" };
+
+    constexpr float fov = 45.0F;
+    constexpr float near = 0.1F;
+    constexpr float far = 200.0F;
+
+    frame_constants_buffer frame_buffer{};
+    frame_constants frame{};
+    frame.projection = glm::perspective(
+        glm::radians(fov), static_cast<float>(window_width) / static_cast<float>(window_height), near, far);
+
+    bool window_should_close = false;
+    constexpr color clear_color{ 0.0F, 0.0F, 0.0F, 1.0F };
+
+    gl_state::current().set_enabled(GL_DEPTH_TEST, true);
+
+    while(!window_should_close) {
+        SDL_Event e;
+        while(SDL_PollEvent(&e) != 0) {
+            switch(e.type) {
+            case SDL_QUIT: {
+                window_should_close = true;
+                break;
+            }
+            case SDL_WINDOWEVENT: {
+                if(e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    glViewport(0, 0, e.window.data1, e.window.data2);
+                    frame.projection = glm::perspective(
+                        glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far);
+                }
+                break;
+            }
+            case SDL_KEYDOWN: {
+                if(e.key.keysym.sym == SDLK_ESCAPE) {
+                    window_should_close = true;
+                }
+                break;
+            }
+            default: {
+                break;
+            }
+            }
+        }
+
+        glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        constexpr float to_seconds = 5'000.0F;
+        constexpr float radius = 40.0F;
+        constexpr float camera_height = 20.0F;
+        float const angle = static_cast<float>(SDL_GetTicks()) / to_seconds;
+        frame.view = glm::lookAt(glm::vec3{ std::sin(angle) * radius, camera_height, std::cos(angle) * radius },
+                                 glm::vec3{ 0.0F, 0.0F, 0.0F },
+                                 glm::vec3{ 0.0F, 1.0F, 0.0F });
+        frame_buffer.update(frame);
+
+        shader_program.use();
+        meshes.draw(ranges);
+
+        SDL_GL_SwapWindow(window.get());
+    }
+
+    spdlog::info("[GL State] {} call(s) issued, {} redundant call(s) skipped",
+                 gl_state::current().stats().issued,
+                 gl_state::current().stats().skipped);
+}
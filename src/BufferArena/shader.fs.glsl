@@ -0,0 +1,12 @@
+#version 330 core
+
+in vec3 worldPos;
+
+out vec4 fragColor;
+
+void main() {
+    // Flat shaded from the screen space derivatives, meshes have no normals
+    vec3 normal = normalize(cross(dFdx(worldPos), dFdy(worldPos)));
+    float light = 0.3 + 0.7 * max(dot(normal, normalize(vec3(0.4, 1.0, 0.6))), 0.0);
+    fragColor = vec4(vec3(0.9, 0.6, 0.3) * light, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+layout(location = 0) in vec3 pos;
+
+out vec3 worldPos;
+
+layout(std140) uniform frame_constants {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+};
+
+void main() {
+    worldPos = pos;
+    gl_Position = view_projection * vec4(pos, 1.0);
+}
@@ -0,0 +1,102 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "util/bvh.hpp"
+#include "util/frustum.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+template<typename F>
+[[nodiscard]] auto milliseconds(F&& fn) -> double
+{
+    auto const start = clock_type::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+auto run(std::size_t const count) -> void
+{
+    // Same density whatever the count, like a bigger world rather than a more crowded one
+    float const extent = 25.0F * std::cbrt(static_cast<float>(count));
+    constexpr float radius = 0.8660254F;
+
+    std::mt19937 rng{ 1337 }; // NOLINT
+    std::uniform_real_distribution<float> coord{ -extent, extent };
+
+    std::vector<glm::vec3> centers{};
+    centers.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        centers.emplace_back(coord(rng), coord(rng), coord(rng));
+    }
+
+    bvh tree{};
+    double const build = milliseconds([&] { tree.build(centers, radius); });
+
+    std::uniform_real_distribution<float> jitter{ -0.1F, 0.1F };
+    for(std::size_t i = 0; i < count; ++i) {
+        tree.update(i, aabb::around(centers[i] + glm::vec3{ jitter(rng), jitter(rng), jitter(rng) }, radius));
+    }
+    double const refit = milliseconds([&] { tree.refit(); });
+
+    frustum_culler culler{};
+    culler.reserve(count);
+    for(auto const& center : centers) {
+        culler.add_sphere(center, radius);
+    }
+
+    // A camera in the middle of the scene with the usual 45 degree view
+    glm::mat4 const projection = glm::perspective(glm::radians(45.0F), 16.0F / 9.0F, 0.1F, 100.0F); // NOLINT
+    glm::mat4 const view = glm::lookAt(glm::vec3{ 0.0F }, glm::vec3{ 0.0F, 0.0F, -1.0F }, glm::vec3{ 0.0F, 1.0F, 0.0F });
+    frustum const f = frustum::from_matrix(projection * view);
+
+    std::vector<std::uint32_t> visible{};
+    double const linear = milliseconds([&] { culler.cull(f, visible); });
+    double const hierarchical = milliseconds([&] { tree.query(f, visible); });
+    bvh::stats const query_stats = tree.last_stats();
+
+    constexpr std::size_t num_rays = 1'000;
+    std::size_t hits = 0;
+    std::uniform_real_distribution<float> direction{ -1.0F, 1.0F };
+    double const rays = milliseconds([&] {
+        for(std::size_t i = 0; i < num_rays; ++i) {
+            glm::vec3 const d{ direction(rng), direction(rng), direction(rng) };
+            if(tree.raycast(glm::vec3{ 0.0F }, d, extent).has_value()) {
+                ++hits;
+            }
+        }
+    });
+
+    spdlog::info("[BVH] {:>8} objects: build {:8.2f} ms, refit {:6.2f} ms, {} node(s)",
+                 count,
+                 build,
+                 refit,
+                 tree.nodes().size());
+    spdlog::info("[BVH] {:>8} objects: {} visible, linear cull {:7.3f} ms, BVH query {:7.3f} ms "
+                 "({} node(s) visited, {} item(s) tested)",
+                 count,
+                 visible.size(),
+                 linear,
+                 hierarchical,
+                 query_stats.nodes_visited,
+                 query_stats.items_tested);
+    spdlog::info("[BVH] {:>8} objects: {} ray(s) in {:.3f} ms, {} hit(s)", count, num_rays, rays, hits);
+}
+
+} // namespace
+
+auto main() -> int
+{
+    for(std::size_t const count : { std::size_t{ 10'000 }, std::size_t{ 100'000 }, std::size_t{ 1'000'000 } }) {
+        run(count);
+    }
+}
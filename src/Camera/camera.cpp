@@ -6,19 +6,26 @@
 #include <glm/gtx/quaternion.hpp>
 #include <spdlog/spdlog.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <memory>
-#include <numeric>
 #include <string>
 #include <vector>
 
+#include "util/frame_constants.hpp"
+#include "util/gl_state.hpp"
+#include "util/instance_buffer.hpp"
+#include "util/mesh_optimizer.hpp"
 #include "util/shader.hpp"
+#include "util/texture_cache.hpp"
+#include "util/texture_streamer.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
+#include "util/vertex_quantization.hpp"
+#include "util/worker_pool.hpp"
 
 auto sdl_error(std::string const& msg) -> void
 {
@@ -43,9 +50,11 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         SDL_Quit();
     };
     auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
 
     using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
     using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
 
     constexpr int window_width = 1280;
     constexpr int window_height = 720;
@@ -76,7 +85,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         sdl_error("Couldn't create a renderer");
     }
 
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window.get());
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ SDL_GL_CreateContext(window.get()), sdl_context_deleter };
 
     if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
         spdlog::error("[glad] Failed to initialize OpenGL context");
@@ -109,86 +119,52 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -0.5f, 0.5f,  0.5f,  0.0f, 0.0f, -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f  // NOLINT
     };
 
-    constexpr std::size_t num_verts = 36;
-    std::vector<unsigned int> indices;
-    indices.resize(num_verts);
-    std::iota(indices.begin(), indices.end(), 0);
+    // Position followed by texture coordinates
+    using cube_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec2>>;
+
+    // Welded, reordered for the vertex cache and drawn with 16 bit indices
+    mesh const cube = optimize_mesh(mesh{ vertices, cube_layout::stride / sizeof(GLfloat) }, "cube");
+    packed_indices const indices = pack_indices(cube);
 
-    unsigned int vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    // 12 bytes a vertex instead of 20, decoded by the QUANTIZED path of shader.vs.glsl
+    quantized_mesh const quantized_cube =
+        quantize_mesh(cube, quantize_attributes{ 0, cube_layout::offset_of<1>() / sizeof(GLfloat) }, "cube");
+
+    vertex_array vao{};
+    vao.bind();
 
     unsigned int vbo = 0;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr); // NOLINT
-    glEnableVertexAttribArray(0);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(quantized_cube.vertices.size()),
+                 quantized_cube.vertices.data(),
+                 GL_STATIC_DRAW);
 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat))); // NOLINT
-    glEnableVertexAttribArray(1);
+    quantized_layout<0, 1>::apply(vao, vbo);
 
-    shader shader_program{ "shader.vs.glsl", "shader.fs.glsl" };
+    shader shader_program{ "shader.vs.glsl", "shader.fs.glsl", { "QUANTIZED" } };
 
     unsigned int ibo = 0;
     glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    int tex_width = 0;
-    int tex_height = 0;
-    int tex_num_channels = 0;
-    unsigned char* data = stbi_load("container.jpg", &tex_width, &tex_height, &tex_num_channels, 0);
-
-    if(data == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: container.jpg!");
-    }
-
-    unsigned int texture = 0;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tex_width, tex_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    int tex2_width = 0;
-    int tex2_height = 0;
-    int tex2_num_channels = 0;
-    stbi_set_flip_vertically_on_load(1);
-    unsigned char* data2 = stbi_load("awesomeface.png", &tex2_width, &tex2_height, &tex2_num_channels, 0);
-
-    if(data2 == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: awesomeface.png!");
-    }
-
-    unsigned int texture2 = 0;
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex2_width, tex2_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data2);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data2);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(indices.bytes.size()),
+                 indices.bytes.data(),
+                 GL_STATIC_DRAW);
+
+    // Decoded on the workers and uploaded a bit every frame, the cubes show a
+    // grey placeholder until their images arrive
+    worker_pool pool{};
+    texture_cache images{};
+    texture_streamer streamer{ pool, images };
+    texture_streamer::handle const texture1 = streamer.request("container.jpg");
+    texture_streamer::handle const texture2 = streamer.request("awesomeface.png", image_params{ true });
+    auto const streaming_start = std::chrono::steady_clock::now();
+    bool streaming_reported = false;
+
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+    vertex_array::unbind();
 
     glm::vec3 camera_pos{ 0.0F, 0.0F, 3.0F }; // NOLINT
     glm::vec3 camera_target{ 0.0F, 0.0F, 0.0F };
@@ -210,6 +186,10 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
     constexpr float far = 100.0F;
     glm::mat4 projection = glm::perspective(glm::radians(fov), width / height, near, far);
 
+    frame_constants_buffer frame_buffer{};
+    frame_constants frame{};
+    frame.projection = projection;
+
     constexpr int num_cubes = 10;
     std::array<glm::vec3, num_cubes> positions = {
         glm::vec3{ 0.0f, 0.0f, 0.0f },    glm::vec3{ 2.0f, 5.0f, -15.0f },   // NOLINT
@@ -219,16 +199,22 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glm::vec3{ 1.5f, 0.2f, -1.5f },   glm::vec3{ -1.3f, 1.0f, -1.5f }    // NOLINT
     };
 
+    // One matrix per cube, drawn with a single instanced call
+    instance_buffer cube_instances{ positions.size() };
+    cube_instances.attach(vao, 2);
+    vertex_array::unbind();
+    std::vector<glm::mat4> models(positions.size());
+
     shader_program.use();
     shader_program.set_int("texture1", 0);
     shader_program.set_int("texture2", 1);
-    shader_program.set_mat4("projection", projection);
+    set_quantization_uniforms(shader_program, quantized_cube);
     shader::unbind();
 
     bool window_should_close = false;
     constexpr color clear_color{ 0.0F, 0.0F, 0.0F, 1.0F };
 
-    glEnable(GL_DEPTH_TEST);
+    gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 
     while(!window_should_close) {
         SDL_Event e;
@@ -241,12 +227,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
             case SDL_WINDOWEVENT: {
                 if(e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
                     glViewport(0, 0, e.window.data1, e.window.data2);
-                    shader_program.use();
-                    shader_program.set_mat4(
-                        "projection",
-                        glm::perspective(
-                            glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far));
-                    shader::unbind();
+                    frame.projection = glm::perspective(
+                        glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far);
                 }
                 break;
             }
@@ -265,10 +247,20 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+        // Redundant binds are filtered by gl_state, no need to unbind after drawing
+        streamer.update();
+        streamer.get(texture1).bind(0);
+        streamer.get(texture2).bind(1);
+
+        if(!streaming_reported && streamer.pending() == 0) {
+            using ms = std::chrono::duration<double, std::milli>;
+            spdlog::info("[Texture Streamer] {} texture(s) in {:.1f} ms, {} through the staging buffer, {} failed",
+                         streamer.stats().uploaded,
+                         ms{ std::chrono::steady_clock::now() - streaming_start }.count(),
+                         streamer.stats().staged,
+                         streamer.stats().failed);
+            streaming_reported = true;
+        }
 
         constexpr float to_seconds = 1'000.0F;
         constexpr float radius = 10.0F;
@@ -277,29 +269,31 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glm::mat4 view = glm::lookAt(
             glm::vec3{ cam_x, 0.0F, cam_z }, glm::vec3{ 0.0F, 0.0F, 0.0F }, glm::vec3{ 0.0F, 1.0F, 0.0F }); // NOLINT
 
-        shader_program.use();
-        shader_program.set_mat4("view", view);
-        glBindVertexArray(vao);
+        frame.view = view;
+        frame_buffer.update(frame);
+
         for(std::size_t i = 0; i < positions.size(); ++i) {
             glm::mat4 model{ 1.0F };
             model = glm::translate(model, positions[i]);
             float angle = i * 20.0F * (SDL_GetTicks() / to_seconds);                                         // NOLINT
             model = model * glm::toMat4(glm::angleAxis(glm::radians(angle), glm::vec3{ 1.0F, 0.3F, 0.5F })); // NOLINT
-            shader_program.set_mat4("model", model);
-
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+            models[i] = model;
         }
+        cube_instances.upload(models.data(), models.size());
 
-        glBindVertexArray(0);
-        shader::unbind();
-        glBindTexture(GL_TEXTURE_2D, 0);
+        shader_program.use();
+        vao.bind();
+        glDrawElementsInstanced(GL_TRIANGLES,
+                                static_cast<GLsizei>(indices.count),
+                                indices.type,
+                                nullptr,
+                                static_cast<GLsizei>(cube_instances.count()));
 
         SDL_GL_SwapWindow(window.get());
     }
 
-    glDeleteVertexArrays(1, &vao);
+    gl_state::current().forget_buffer(vbo);
+    gl_state::current().forget_buffer(ibo);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ibo);
-
-    SDL_GL_DeleteContext(gl_context);
 }
@@ -6,20 +6,29 @@
 #include <glm/gtx/quaternion.hpp>
 #include <spdlog/spdlog.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <algorithm>
 #include <array>
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <memory>
-#include <numeric>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "util/frame_constants.hpp"
+#include "util/gl_state.hpp"
+#include "util/instance_buffer.hpp"
+#include "util/mesh_optimizer.hpp"
 #include "util/shader.hpp"
+#include "util/task_graph.hpp"
+#include "util/texture_array.hpp"
+#include "util/texture_cache.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
+#include "util/vertex_quantization.hpp"
+#include "util/worker_pool.hpp"
 
 auto sdl_error(std::string const& msg) -> void
 {
@@ -44,54 +53,68 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         SDL_Quit();
     };
     auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
 
     using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
     using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
 
     int window_width = 1280; // NOLINT
     int window_height = 720; // NOLINT
 
-    if(SDL_Init(SDL_INIT_VIDEO) != 0) {
-        sdl_error("Couldn't initialize SDL");
-    }
+    window_t window{ nullptr, sdl_window_deleter };
+    renderer_t renderer{ nullptr, sdl_renderer_deleter };
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ nullptr, sdl_context_deleter };
+
+    // Images are read and decoded on the pool while SDL and the context come
+    // up, everything touching GL runs on this thread once its inputs are ready
+    worker_pool pool{};
+    task_graph startup{};
+    using runs_on = task_graph::runs_on;
+
+    task_graph::task_id const context_task = startup.add("context", runs_on::gl, [&] {
+        if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+            sdl_error("Couldn't initialize SDL");
+        }
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
-    window_t window{ SDL_CreateWindow("HelloTriangle!",
+        window.reset(SDL_CreateWindow("HelloTriangle!",
                                       SDL_WINDOWPOS_CENTERED,
                                       SDL_WINDOWPOS_CENTERED,
                                       window_width,
                                       window_height,
-                                      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE),
-                     sdl_window_deleter };
+                                      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE));
 
-    if(window == nullptr) {
-        sdl_error("Couldn't create a window");
-    }
+        if(window == nullptr) {
+            sdl_error("Couldn't create a window");
+        }
 
-    renderer_t renderer{ SDL_CreateRenderer(window.get(), -1, SDL_RENDERER_ACCELERATED), sdl_renderer_deleter };
+        renderer.reset(SDL_CreateRenderer(window.get(), -1, SDL_RENDERER_ACCELERATED));
 
-    if(renderer == nullptr) {
-        sdl_error("Couldn't create a renderer");
-    }
+        if(renderer == nullptr) {
+            sdl_error("Couldn't create a renderer");
+        }
 
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window.get());
+        gl_context.reset(SDL_GL_CreateContext(window.get()));
 
-    if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
-        spdlog::error("[glad] Failed to initialize OpenGL context");
-        std::exit(EXIT_FAILURE);
-    }
+        if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
+            spdlog::error("[glad] Failed to initialize OpenGL context");
+            std::exit(EXIT_FAILURE);
+        }
 
-    SDL_SetRelativeMouseMode(SDL_TRUE);
-    SDL_CaptureMouse(SDL_TRUE);
+        SDL_SetRelativeMouseMode(SDL_TRUE);
+        SDL_CaptureMouse(SDL_TRUE);
 
-    spdlog::info("[OpenGL] Context created! Version {}.{}", GLVersion.major, GLVersion.minor);
+        spdlog::info("[OpenGL] Context created! Version {}.{}", GLVersion.major, GLVersion.minor);
 
-    int num_attributes = 0;
-    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &num_attributes);
-    spdlog::info("[OpenGL] Max number of vertex attributes: {}", num_attributes);
+        int num_attributes = 0;
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &num_attributes);
+        spdlog::info("[OpenGL] Max number of vertex attributes: {}", num_attributes);
+    });
 
     std::vector<GLfloat> const vertices = {
         -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.5f,  -0.5f, -0.5f, 1.0f, 0.0f, 0.5f,  0.5f,  -0.5f, 1.0f, 1.0f, // NOLINT
@@ -113,86 +136,89 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -0.5f, 0.5f,  0.5f,  0.0f, 0.0f, -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f  // NOLINT
     };
 
-    constexpr std::size_t num_verts = 36;
-    std::vector<unsigned int> indices;
-    indices.resize(num_verts);
-    std::iota(indices.begin(), indices.end(), 0);
-
-    unsigned int vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    unsigned int vbo = 0;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr); // NOLINT
-    glEnableVertexAttribArray(0);
+    // Position followed by texture coordinates
+    using cube_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec2>>;
 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat))); // NOLINT
-    glEnableVertexAttribArray(1);
+    // Welded, reordered for the vertex cache and drawn with 16 bit indices
+    mesh const cube = optimize_mesh(mesh{ vertices, cube_layout::stride / sizeof(GLfloat) }, "cube");
+    packed_indices const indices = pack_indices(cube);
 
-    shader shader_program{ "shader.vs.glsl", "shader.fs.glsl" };
+    // 12 bytes a vertex instead of 20, decoded by the QUANTIZED path of shader.vs.glsl
+    quantized_mesh const quantized_cube =
+        quantize_mesh(cube, quantize_attributes{ 0, cube_layout::offset_of<1>() / sizeof(GLfloat) }, "cube");
 
+    std::optional<vertex_array> vao{};
+    unsigned int vbo = 0;
     unsigned int ibo = 0;
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    int tex_width = 0;
-    int tex_height = 0;
-    int tex_num_channels = 0;
-    unsigned char* data = stbi_load("container.jpg", &tex_width, &tex_height, &tex_num_channels, 0);
-
-    if(data == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: container.jpg!");
-    }
 
-    unsigned int texture = 0;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tex_width, tex_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    int tex2_width = 0;
-    int tex2_height = 0;
-    int tex2_num_channels = 0;
-    stbi_set_flip_vertically_on_load(1);
-    unsigned char* data2 = stbi_load("awesomeface.png", &tex2_width, &tex2_height, &tex2_num_channels, 0);
-
-    if(data2 == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: awesomeface.png!");
+    startup.add(
+        "geometry",
+        runs_on::gl,
+        [&] {
+            vao.emplace();
+            vao->bind();
+
+            glGenBuffers(1, &vbo);
+            gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER,
+                         static_cast<GLsizeiptr>(quantized_cube.vertices.size()),
+                         quantized_cube.vertices.data(),
+                         GL_STATIC_DRAW);
+
+            quantized_layout<0, 1>::apply(*vao, vbo);
+
+            glGenBuffers(1, &ibo);
+            gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                         static_cast<GLsizeiptr>(indices.bytes.size()),
+                         indices.bytes.data(),
+                         GL_STATIC_DRAW);
+
+            gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+            vertex_array::unbind();
+        },
+        { context_task });
+
+    std::optional<shader> shader_program{};
+    startup.add(
+        "shader",
+        runs_on::gl,
+        [&] { shader_program.emplace("shader.vs.glsl", "shader.fs.glsl", std::vector<std::string>{ "QUANTIZED" }); },
+        { context_task });
+
+    // Every image in one array texture, so the cubes can use different ones
+    // and still be drawn with a single bind and draw call
+    texture_cache images{};
+    constexpr std::array<char const*, 3> image_files{ "container.jpg", "wall.jpg", "awesomeface.png" };
+    std::array<image, 3> decoded{};
+    std::vector<task_graph::task_id> array_inputs{ context_task };
+
+    for(std::size_t i = 0; i < image_files.size(); ++i) {
+        array_inputs.push_back(startup.add(fmt::format("decode {}", image_files[i]), runs_on::worker, [&, i] {
+            if(!images.load_image(image_files[i], image_params{ i == 2 }, decoded[i])) {
+                decoded[i] = image{ 1, 1, 3, { 255, 0, 255 } }; // NOLINT
+            }
+        }));
     }
 
-    unsigned int texture2 = 0;
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    texture_array_builder builder{};
+    std::array<std::size_t, 3> layers{};
+    std::optional<texture_array> textures{};
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex2_width, tex2_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data2);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data2);
+    startup.add(
+        "texture array",
+        runs_on::gl,
+        [&] {
+            for(std::size_t i = 0; i < decoded.size(); ++i) {
+                layers[i] = builder.add(std::move(decoded[i]));
+            }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+            textures.emplace(builder.build());
+        },
+        array_inputs);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    startup.start(pool);
+    startup.finish();
 
     glm::vec3 camera_pos{ 0.0F, 0.0F, 3.0F }; // NOLINT
     glm::vec3 camera_front{ 0.0F, 0.0F, -1.0F };
@@ -205,6 +231,10 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
     constexpr float far = 100.0F;
     glm::mat4 projection = glm::perspective(glm::radians(fov), fwidth / fheight, near, far);
 
+    frame_constants_buffer frame_buffer{};
+    frame_constants frame{};
+    frame.projection = projection;
+
     constexpr int num_cubes = 10;
     std::array<glm::vec3, num_cubes> positions = {
         glm::vec3{ 0.0f, 0.0f, 0.0f },    glm::vec3{ 2.0f, 5.0f, -15.0f },   // NOLINT
@@ -214,10 +244,36 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glm::vec3{ 1.5f, 0.2f, -1.5f },   glm::vec3{ -1.3f, 1.0f, -1.5f }    // NOLINT
     };
 
-    shader_program.use();
-    shader_program.set_int("texture1", 0);
-    shader_program.set_int("texture2", 1);
-    shader_program.set_mat4("projection", projection);
+    // One matrix per cube, drawn with a single instanced call
+    instance_buffer cube_instances{ positions.size() };
+    cube_instances.attach(*vao, 2);
+    vertex_array::unbind();
+    std::vector<glm::mat4> models(positions.size());
+
+    // Per-instance layer, alternating between the container and the wall
+    std::vector<array_layer> cube_layers(positions.size());
+    for(std::size_t i = 0; i < cube_layers.size(); ++i) {
+        cube_layers[i] = builder.layer(layers[i % 2]);
+    }
+
+    unsigned int layer_vbo = 0;
+    glGenBuffers(1, &layer_vbo);
+    vao->bind();
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, layer_vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(cube_layers.size() * sizeof(array_layer)),
+                 cube_layers.data(),
+                 GL_STATIC_DRAW);
+    vertex_layout<attr<6, vertex_format::vec3>>::apply(*vao, layer_vbo, 1); // NOLINT
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+    vertex_array::unbind();
+
+    array_layer const face = builder.layer(layers[2]);
+
+    shader_program->use();
+    shader_program->set_int("textures", 0);
+    set_quantization_uniforms(*shader_program, quantized_cube);
+    shader_program->set_vec4("face", glm::vec4{ face.uv_scale.x, face.uv_scale.y, face.index, 0.0F });
     shader::unbind();
 
     bool window_should_close = false;
@@ -229,9 +285,10 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
     float yaw = -90.0F; // NOLINT
     float pitch = 0.0F;
 
-    glEnable(GL_DEPTH_TEST);
+    gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 
     auto start = std::chrono::steady_clock::now();
+    bool first_frame = true;
 
     while(!window_should_close) {
         using namespace std::chrono;
@@ -251,12 +308,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
                     window_width = e.window.data1;
                     window_height = e.window.data2;
                     glViewport(0, 0, e.window.data1, e.window.data2);
-                    shader_program.use();
-                    shader_program.set_mat4(
-                        "projection",
-                        glm::perspective(
-                            glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far));
-                    shader::unbind();
+                    frame.projection = glm::perspective(
+                        glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far);
                 }
                 break;
             }
@@ -312,9 +365,7 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
                     float const a = static_cast<float>(window_width) / static_cast<float>(window_height);
                     glm::mat4 proj = glm::perspective(glm::radians(fov), a, near, far);
 
-                    shader_program.use();
-                    shader_program.set_mat4("projection", proj);
-                    shader::unbind();
+                    frame.projection = proj;
                 }
                 break;
             }
@@ -360,37 +411,43 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+        textures->bind(0);
 
         constexpr float to_seconds = 1'000.0F;
         glm::mat4 view = glm::lookAt(camera_pos, camera_pos + camera_front, camera_up);
 
-        shader_program.use();
-        shader_program.set_mat4("view", view);
-        glBindVertexArray(vao);
+        frame.view = view;
+        frame_buffer.update(frame);
+
         for(std::size_t i = 0; i < positions.size(); ++i) {
             glm::mat4 model{ 1.0F };
             model = glm::translate(model, positions[i]);
             float angle = i * 20.0F * (SDL_GetTicks() / to_seconds);                                         // NOLINT
             model = model * glm::toMat4(glm::angleAxis(glm::radians(angle), glm::vec3{ 1.0F, 0.3F, 0.5F })); // NOLINT
-            shader_program.set_mat4("model", model);
-
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+            models[i] = model;
         }
+        cube_instances.upload(models.data(), models.size());
 
-        glBindVertexArray(0);
-        shader::unbind();
-        glBindTexture(GL_TEXTURE_2D, 0);
+        shader_program->use();
+        vao->bind();
+        glDrawElementsInstanced(GL_TRIANGLES,
+                                static_cast<GLsizei>(indices.count),
+                                indices.type,
+                                nullptr,
+                                static_cast<GLsizei>(cube_instances.count()));
 
         SDL_GL_SwapWindow(window.get());
+
+        if(first_frame) {
+            startup.report();
+            first_frame = false;
+        }
     }
 
-    glDeleteVertexArrays(1, &vao);
+    gl_state::current().forget_buffer(layer_vbo);
+    glDeleteBuffers(1, &layer_vbo);
+    gl_state::current().forget_buffer(vbo);
+    gl_state::current().forget_buffer(ibo);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ibo);
-
-    SDL_GL_DeleteContext(gl_context);
 }
@@ -3,10 +3,14 @@
 out vec4 fragColor;
 
 in vec2 texCoord;
+flat in vec3 texLayer;
 
-uniform sampler2D texture1;
-uniform sampler2D texture2;
+uniform sampler2DArray textures;
+// Layer drawn over every cube, same layout as texLayer
+uniform vec4 face;
 
 void main() {
-    fragColor = mix(texture(texture1, texCoord), texture(texture2, texCoord), 0.3);
+    vec4 material = texture(textures, vec3(texCoord * texLayer.xy, texLayer.z));
+    vec4 overlay = texture(textures, vec3(texCoord * face.xy, face.z));
+    fragColor = mix(material, overlay, 0.3);
 }
@@ -2,14 +2,53 @@
 
 layout(location = 0) in vec3 pos;
 layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in mat4 model;
+// uv scale, array layer
+layout(location = 6) in vec3 layer;
 
 out vec2 texCoord;
+flat out vec3 texLayer;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform frame_constants {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+};
+
+#ifdef QUANTIZED
+// snorm16 positions and unorm16 texture coordinates relative to the mesh's
+// bounds, see util/vertex_quantization.hpp
+uniform vec4 quantized_position_scale;
+uniform vec4 quantized_position_offset;
+uniform vec4 quantized_uv_transform;
+
+vec3 decode_position(vec3 p) {
+    return p * quantized_position_scale.xyz + quantized_position_offset.xyz;
+}
+
+vec2 decode_uv(vec2 uv) {
+    return uv * quantized_uv_transform.xy + quantized_uv_transform.zw;
+}
+
+// Normals are snorm16x2, octahedral encoded, for meshes that have them
+vec3 decode_octahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#else
+vec3 decode_position(vec3 p) {
+    return p;
+}
+
+vec2 decode_uv(vec2 uv) {
+    return uv;
+}
+#endif
 
 void main() {
-    gl_Position = projection * view * model * vec4(pos.xyz, 1.0);
-    texCoord = inTexCoord;
+    gl_Position = view_projection * model * vec4(decode_position(pos), 1.0);
+    texCoord = decode_uv(inTexCoord);
+    texLayer = layer;
 }
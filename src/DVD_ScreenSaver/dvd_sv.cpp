@@ -6,9 +6,6 @@
 #include <glm/gtx/quaternion.hpp>
 #include <spdlog/spdlog.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <chrono>
 #include <cmath>
 #include <cstdlib>
@@ -17,7 +14,11 @@
 #include <string>
 #include <vector>
 
+#include "util/gl_state.hpp"
 #include "util/shader.hpp"
+#include "util/texture_cache.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
 
 auto sdl_error(std::string const& msg) -> void
 {
@@ -40,9 +41,11 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         SDL_Quit();
     };
     auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
 
     using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
     using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
 
     constexpr int window_width = 1280;
     constexpr int window_height = 720;
@@ -73,7 +76,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         sdl_error("Couldn't create a renderer");
     }
 
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window.get());
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ SDL_GL_CreateContext(window.get()), sdl_context_deleter };
 
     if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
         spdlog::error("[glad] Failed to initialize OpenGL context");
@@ -92,56 +96,34 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
 
     std::vector<unsigned int> indices = { 0, 1, 3, 1, 2, 3 };
 
-    unsigned int vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    vertex_array vao{};
+    vao.bind();
 
     unsigned int vbo = 0;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr); // NOLINT
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat))); // NOLINT
-    glEnableVertexAttribArray(1);
+    // Position followed by texture coordinates
+    using quad_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec2>>;
+    quad_layout::apply(vao, vbo);
 
     shader shader_program{ "shader.vs.glsl", "shader.fs.glsl" };
 
     unsigned int ibo = 0;
     glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
-    int tex_width = 0;
-    int tex_height = 0;
-    int tex_num_channels = 0;
-    stbi_set_flip_vertically_on_load(1);
-    unsigned char* data = stbi_load("DVD_ScrrenSaver2.png", &tex_width, &tex_height, &tex_num_channels, 0);
+    texture_cache images{};
+    auto const texture1 = images.load("DVD_ScrrenSaver2.png", image_params{ true });
 
-    if(data == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: DVD_ScrrenSaver2.png!");
+    if(texture1 == nullptr) {
+        return EXIT_FAILURE;
     }
 
-    unsigned int texture = 0;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex_width, tex_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+    vertex_array::unbind();
 
     constexpr float to_seconds = 1'000.0F;
     float translate_x = 0.5F;  // NOLINT
@@ -212,8 +194,7 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        texture1->bind(0);
 
         shader_program.use();
 
@@ -227,19 +208,14 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         }
 
         shader_program.set_mat4("transform", transf);
-        glBindVertexArray(vao);
+        vao.bind();
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
 
-        glBindVertexArray(0);
-        shader::unbind();
-        glBindTexture(GL_TEXTURE_2D, 0);
-
         SDL_GL_SwapWindow(window.get());
     }
 
-    glDeleteVertexArrays(1, &vao);
+    gl_state::current().forget_buffer(vbo);
+    gl_state::current().forget_buffer(ibo);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ibo);
-
-    SDL_GL_DeleteContext(gl_context);
 }
@@ -0,0 +1,20 @@
+#version 330 core
+
+// Drawn flat in place of the cubes' program while it's still compiling
+
+layout(location = 0) in vec3 pos;
+layout(location = 2) in mat4 model;
+
+layout(std140) uniform frame_constants {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+};
+
+uniform vec4 quantized_position_scale;
+uniform vec4 quantized_position_offset;
+
+void main() {
+    vec3 p = pos * quantized_position_scale.xyz + quantized_position_offset.xyz;
+    gl_Position = view_projection * model * vec4(p, 1.0);
+}
@@ -6,20 +6,31 @@
 #include <glm/gtx/quaternion.hpp>
 #include <spdlog/spdlog.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <algorithm>
-#include <array>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
-#include <numeric>
 #include <string>
 #include <vector>
 
+#include "util/bvh.hpp"
+#include "util/frame_constants.hpp"
+#include "util/frustum.hpp"
+#include "util/gl_state.hpp"
+#include "util/instance_buffer.hpp"
+#include "util/mesh_optimizer.hpp"
+#include "util/program_cache.hpp"
 #include "util/shader.hpp"
+#include "util/shader_compiler.hpp"
+#include "util/texture.hpp"
+#include "util/texture_residency.hpp"
+#include "util/transform_batch.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
+#include "util/vertex_quantization.hpp"
+#include "util/worker_pool.hpp"
 
 auto sdl_error(std::string const& msg) -> void
 {
@@ -118,9 +129,11 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         SDL_Quit();
     };
     auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
 
     using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
     using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
 
     int window_width = 1280; // NOLINT
     int window_height = 720; // NOLINT
@@ -151,7 +164,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         sdl_error("Couldn't create a renderer");
     }
 
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window.get());
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ SDL_GL_CreateContext(window.get()), sdl_context_deleter };
 
     if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
         spdlog::error("[glad] Failed to initialize OpenGL context");
@@ -184,86 +198,56 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -0.5f, 0.5f,  0.5f,  0.0f, 0.0f, -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f  // NOLINT
     };
 
-    constexpr std::size_t num_verts = 36;
-    std::vector<unsigned int> indices;
-    indices.resize(num_verts);
-    std::iota(indices.begin(), indices.end(), 0);
-
-    unsigned int vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    unsigned int vbo = 0;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), nullptr); // NOLINT
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat))); // NOLINT
-    glEnableVertexAttribArray(1);
-
-    shader shader_program{ "shader.vs.glsl", "shader.fs.glsl" };
-
-    unsigned int ibo = 0;
-    glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    int tex_width = 0;
-    int tex_height = 0;
-    int tex_num_channels = 0;
-    unsigned char* data = stbi_load("container.jpg", &tex_width, &tex_height, &tex_num_channels, 0);
-
-    if(data == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: container.jpg!");
-    }
-
-    unsigned int texture = 0;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    // Position followed by texture coordinates
+    using textured_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec2>>;
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Welded, reordered for the vertex cache and drawn with 16 bit indices
+    mesh const cube = optimize_mesh(mesh{ vertices, textured_layout::stride / sizeof(GLfloat) }, "cube");
+    packed_indices const indices = pack_indices(cube);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tex_width, tex_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // 12 bytes a vertex instead of 20, decoded by the QUANTIZED path of shader.vs.glsl
+    quantized_mesh const quantized_cube =
+        quantize_mesh(cube, quantize_attributes{ 0, textured_layout::offset_of<1>() / sizeof(GLfloat) }, "cube");
 
-    stbi_image_free(data);
+    // Compile in the background while the textures get decoded, and keep
+    // compiling during the first frames, which draw flat until it's done
+    program_cache cache{ "shader_cache" };
+    shader_compiler compiler{ &cache };
+    compiler.set_fallback(shader{ "fallback.vs.glsl", "fallback.fs.glsl" });
+    auto const cube_program = compiler.submit("shader.vs.glsl", "shader.fs.glsl", { "QUANTIZED" });
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Baked with their mipmaps and block compressed at build time. Only the
+    // levels the closest visible cube needs are resident, within a budget
+    // small enough that flying up to a cube has to give up some detail
+    constexpr std::size_t texture_budget = 384 * 1024;
+    worker_pool pool{};
+    texture_residency textures{ pool, texture_budget };
+    texture_residency::handle const texture1 = textures.add("container.btex");
+    texture_residency::handle const texture2 = textures.add("awesomeface.btex");
 
-    int tex2_width = 0;
-    int tex2_height = 0;
-    int tex2_num_channels = 0;
-    stbi_set_flip_vertically_on_load(1);
-    unsigned char* data2 = stbi_load("awesomeface.png", &tex2_width, &tex2_height, &tex2_num_channels, 0);
-
-    if(data2 == nullptr) {
-        spdlog::error("[STB_Image] Couldn't load file: awesomeface.png!");
-    }
+    vertex_array vao{};
+    vao.bind();
 
-    unsigned int texture2 = 0;
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex2_width, tex2_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data2);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    unsigned int vbo = 0;
+    glGenBuffers(1, &vbo);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(quantized_cube.vertices.size()),
+                 quantized_cube.vertices.data(),
+                 GL_STATIC_DRAW);
 
-    stbi_image_free(data2);
+    quantized_layout<0, 1>::apply(vao, vbo);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    unsigned int ibo = 0;
+    glGenBuffers(1, &ibo);
+    gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(indices.bytes.size()),
+                 indices.bytes.data(),
+                 GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+    vertex_array::unbind();
 
     glm::vec3 camera_pos{ 0.0F, 0.0F, 3.0F }; // NOLINT
     glm::vec3 camera_front{ 0.0F, 0.0F, -1.0F };
@@ -279,8 +263,11 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
     constexpr float far = 100.0F;
     glm::mat4 projection = glm::perspective(glm::radians(fov), fwidth / fheight, near, far);
 
-    constexpr int num_cubes = 10;
-    std::array<glm::vec3, num_cubes> positions = {
+    frame_constants_buffer frame_buffer{};
+    frame_constants frame{};
+    frame.projection = projection;
+
+    std::vector<glm::vec3> positions = {
         glm::vec3{ 0.0f, 0.0f, 0.0f },    glm::vec3{ 2.0f, 5.0f, -15.0f },   // NOLINT
         glm::vec3{ -1.5f, -2.2f, -2.5f }, glm::vec3{ -3.8f, -2.0f, -12.3f }, // NOLINT
         glm::vec3{ 2.4f, -0.4f, -3.5f },  glm::vec3{ -1.7f, 3.0f, -7.5f },   // NOLINT
@@ -288,11 +275,33 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glm::vec3{ 1.5f, 0.2f, -1.5f },   glm::vec3{ -1.3f, 1.0f, -1.5f }    // NOLINT
     };
 
-    shader_program.use();
-    shader_program.set_int("texture1", 0);
-    shader_program.set_int("texture2", 1);
-    shader_program.set_mat4("projection", projection);
-    shader::unbind();
+    // One matrix per cube, drawn with a single instanced call
+    instance_buffer cube_instances{ positions.size() };
+    cube_instances.attach(vao, 2);
+    vertex_array::unbind();
+
+    // Rotations are computed a few cubes at a time with SIMD, spread over the pool
+    transform_batch cubes{};
+    cubes.reserve(positions.size());
+    for(std::size_t i = 0; i < positions.size(); ++i) {
+        float const angular_speed = glm::radians(static_cast<float>(i) * 20.0F); // NOLINT
+        cubes.add(positions[i], glm::vec3{ 1.0F, 0.3F, 0.5F }, angular_speed);   // NOLINT
+    }
+
+    // Cubes spin in place, so a sphere around the unit cube bounds them at any angle
+    constexpr float cube_radius = 0.8660254F; // sqrt(3) / 2
+    bvh scene{};
+    scene.build(positions, cube_radius);
+
+    std::vector<std::uint32_t> visible{};
+    std::size_t total_tested = 0;
+    std::size_t total_visible = 0;
+
+    std::vector<glm::mat4> models{};
+
+    // Set once per program, on the first frame it's ready
+    bool programs_done = false;
+    bool cube_ready = false;
 
     bool window_should_close = false;
     constexpr color clear_color{ 0.0F, 0.0F, 0.0F, 1.0F };
@@ -305,7 +314,7 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
 
     bool dragging = false;
 
-    glEnable(GL_DEPTH_TEST);
+    gl_state::current().set_enabled(GL_DEPTH_TEST, true);
 
     auto start = std::chrono::steady_clock::now();
 
@@ -327,12 +336,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
                     window_width = e.window.data1;
                     window_height = e.window.data2;
                     glViewport(0, 0, e.window.data1, e.window.data2);
-                    shader_program.use();
-                    shader_program.set_mat4(
-                        "projection",
-                        glm::perspective(
-                            glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far));
-                    shader::unbind();
+                    frame.projection = glm::perspective(
+                        glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far);
                 }
                 break;
             }
@@ -410,9 +415,7 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
                     float const a = static_cast<float>(window_width) / static_cast<float>(window_height);
                     glm::mat4 proj = glm::perspective(glm::radians(fov), a, near, far);
 
-                    shader_program.use();
-                    shader_program.set_mat4("projection", proj);
-                    shader::unbind();
+                    frame.projection = proj;
                 }
                 break;
             }
@@ -445,37 +448,111 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
-
         constexpr float to_seconds = 1'000.0F;
         glm::mat4 view = cam.view();
 
-        shader_program.use();
-        shader_program.set_mat4("view", view);
-        glBindVertexArray(vao);
-        for(std::size_t i = 0; i < positions.size(); ++i) {
-            glm::mat4 model{ 1.0F };
-            model = glm::translate(model, positions[i]);
-            float angle = i * 20.0F * (SDL_GetTicks() / to_seconds);                                         // NOLINT
-            model = model * glm::toMat4(glm::angleAxis(glm::radians(angle), glm::vec3{ 1.0F, 0.3F, 0.5F })); // NOLINT
-            shader_program.set_mat4("model", model);
-
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+        frame.view = view;
+        frame_buffer.update(frame);
+
+        if(!programs_done && compiler.poll() == 0) {
+            programs_done = true;
+            spdlog::info("[Program Cache] {} hit(s), {} miss(es), {} rejected",
+                         cache.stats().hits,
+                         cache.stats().misses,
+                         cache.stats().rejected);
+        }
+
+        if(!cube_ready && compiler.ready(cube_program)) {
+            shader const& program = compiler.get(cube_program);
+            program.use();
+            program.set_int("texture1", 0);
+            program.set_int("texture2", 1);
+            set_quantization_uniforms(program, quantized_cube);
+            cube_ready = true;
+        }
+
+        float const time = static_cast<float>(SDL_GetTicks()) / to_seconds;
+
+        // Only cubes touching the view get a matrix and get drawn
+        std::size_t const num_visible = scene.query(frustum::from_matrix(frame.projection * view), visible);
+        total_tested += scene.last_stats().items_tested;
+        total_visible += num_visible;
+
+        // Both textures cover every cube, so the closest one decides their detail
+        if(num_visible > 0) {
+            float closest = far;
+            for(std::size_t i = 0; i < num_visible; ++i) {
+                closest = std::min(closest, glm::length(positions[visible[i]] - cam.position()));
+            }
+
+            float const pixels_per_unit =
+                static_cast<float>(window_height) / (2.0F * std::tan(glm::radians(fov) / 2.0F) * std::max(closest, near));
+            textures.request(texture1, pixels_per_unit);
+            textures.request(texture2, pixels_per_unit);
         }
 
-        glBindVertexArray(0);
-        shader::unbind();
-        glBindTexture(GL_TEXTURE_2D, 0);
+        // Redundant binds are filtered by gl_state, no need to unbind after drawing
+        textures.update();
+        textures.get(texture1).bind(0);
+        textures.get(texture2).bind(1);
+
+        // Written straight into the instance buffer, falling back to a copy if it can't be mapped
+        if(glm::mat4* const mapped = cube_instances.map(num_visible); mapped != nullptr) {
+            cubes.compute(time, visible.data(), num_visible, mapped, &pool);
+
+            if(!cube_instances.unmap()) {
+                spdlog::warn("[Instances] Buffer contents lost while mapped, skipping this frame's update!");
+            }
+        }
+        else if(num_visible > 0) {
+            models.resize(num_visible);
+            cubes.compute(time, visible.data(), num_visible, models.data(), &pool);
+            cube_instances.upload(models.data(), models.size());
+        }
+
+        if(num_visible > 0) {
+            shader const& program = compiler.get(cube_program);
+            program.use();
+
+            // The fallback needs the cube's quantization until the real program is ready
+            if(!cube_ready) {
+                set_quantization_uniforms(program, quantized_cube);
+            }
+
+            vao.bind();
+            glDrawElementsInstanced(GL_TRIANGLES,
+                                    static_cast<GLsizei>(indices.count),
+                                    indices.type,
+                                    nullptr,
+                                    static_cast<GLsizei>(cube_instances.count()));
+        }
 
         SDL_GL_SwapWindow(window.get());
     }
 
-    glDeleteVertexArrays(1, &vao);
+    if(total_tested > 0) {
+        spdlog::info("[Culling] {} cube(s) drawn over all frames, {} tested one by one, out of {} per frame",
+                     total_visible,
+                     total_tested,
+                     scene.size());
+    }
+
+    texture_residency::statistics const& residency = textures.stats();
+    spdlog::info("[Residency] {} of {} byte(s) resident, {} upgrade(s), {} downgrade(s), {} eviction(s), {} byte(s) "
+                 "uploaded",
+                 residency.resident_bytes,
+                 textures.budget(),
+                 residency.upgrades,
+                 residency.downgrades,
+                 residency.evictions,
+                 residency.uploaded_bytes);
+
+    spdlog::info("[GL State] {} call(s) issued, {} redundant call(s) skipped",
+                 gl_state::current().stats().issued,
+                 gl_state::current().stats().skipped);
+
+    gl_state::current().forget_buffer(vbo);
+    gl_state::current().forget_buffer(ibo);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ibo);
-
-    SDL_GL_DeleteContext(gl_context);
 }
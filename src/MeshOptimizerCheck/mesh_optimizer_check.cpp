@@ -0,0 +1,105 @@
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "util/mesh_optimizer.hpp"
+
+namespace {
+
+using triangle = std::array<std::uint32_t, 3>;
+
+///
+/// `side` x `side` grid of quads, two triangles each, in random order. A few
+/// degenerate triangles repeating one or all of their vertices are mixed in.
+///
+[[nodiscard]] auto make_grid(std::uint32_t const side) -> mesh
+{
+    mesh result{};
+    result.stride = 3;
+
+    for(std::uint32_t y = 0; y <= side; ++y) {
+        for(std::uint32_t x = 0; x <= side; ++x) {
+            result.vertices.insert(result.vertices.end(), { static_cast<float>(x), static_cast<float>(y), 0.0F });
+        }
+    }
+
+    std::vector<triangle> triangles{};
+    for(std::uint32_t y = 0; y < side; ++y) {
+        for(std::uint32_t x = 0; x < side; ++x) {
+            std::uint32_t const corner = y * (side + 1) + x;
+            triangles.push_back({ corner, corner + 1, corner + side + 1 });
+            triangles.push_back({ corner + 1, corner + side + 2, corner + side + 1 });
+        }
+    }
+
+    triangles.push_back({ 0, 0, 1 });
+    triangles.push_back({ side + 1, side + 2, side + 2 });
+    triangles.push_back({ 5, 6, 5 });
+    triangles.push_back({ 7, 7, 7 });
+
+    std::mt19937 rng{ 1337 }; // NOLINT
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+
+    for(triangle const& t : triangles) {
+        result.indices.insert(result.indices.end(), t.begin(), t.end());
+    }
+
+    return result;
+}
+
+/// Triangles of `m` in a canonical order, to compare meshes regardless of how they were reordered
+[[nodiscard]] auto sorted_triangles(mesh const& m) -> std::vector<triangle>
+{
+    std::vector<triangle> result{};
+
+    for(std::size_t i = 0; i + 2 < m.indices.size(); i += 3) {
+        result.push_back({ m.indices[i], m.indices[i + 1], m.indices[i + 2] });
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace
+
+///
+/// Runs the vertex cache optimization on a shuffled grid with a few
+/// degenerate triangles. Fails if a triangle is lost or emitted twice, or
+/// the ACMR doesn't improve.
+///
+auto main() -> int
+{
+    constexpr std::uint32_t side = 64;
+    mesh const source = make_grid(side);
+
+    mesh optimized = source;
+    optimize_vertex_cache(optimized);
+
+    vertex_cache_stats const before = analyze_vertex_cache(source);
+    vertex_cache_stats const after = analyze_vertex_cache(optimized);
+
+    spdlog::info("[Mesh Optimizer] {} triangles, ACMR {:.2f} -> {:.2f}, ATVR {:.2f} -> {:.2f}",
+                 source.indices.size() / 3,
+                 before.acmr,
+                 after.acmr,
+                 before.atvr,
+                 after.atvr);
+
+    if(sorted_triangles(optimized) != sorted_triangles(source)) {
+        spdlog::error("[Mesh Optimizer] Reordering lost or duplicated triangles!");
+        return EXIT_FAILURE;
+    }
+
+    if(after.acmr >= before.acmr) {
+        spdlog::error("[Mesh Optimizer] Reordering didn't improve the ACMR!");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
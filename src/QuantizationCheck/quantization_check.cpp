@@ -0,0 +1,170 @@
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "util/mesh_optimizer.hpp"
+#include "util/vertex_quantization.hpp"
+
+namespace {
+
+constexpr float snorm16_max = 32767.0F;
+constexpr float unorm16_max = 65535.0F;
+
+/// Position, texture coordinates and normal
+constexpr std::size_t floats_per_vertex = 8;
+
+template<typename T>
+[[nodiscard]] auto read(std::vector<std::uint8_t> const& bytes, std::size_t const offset) noexcept -> T
+{
+    T value{};
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+/// What the GPU does with a normalized signed attribute
+[[nodiscard]] auto decode_snorm16(std::int16_t const q) noexcept -> float
+{
+    return std::max(static_cast<float>(q) / snorm16_max, -1.0F);
+}
+
+[[nodiscard]] auto decode_unorm16(std::uint16_t const q) noexcept -> float
+{
+    return static_cast<float>(q) / unorm16_max;
+}
+
+///
+/// From the cross product rather than `acos` of the dot product, which can't
+/// resolve angles this small in single precision.
+///
+[[nodiscard]] auto angle_degrees(glm::vec3 const& a, glm::vec3 const& b) noexcept -> float
+{
+    glm::vec3 const cross{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    float const sine = std::sqrt(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+    float const cosine = a.x * b.x + a.y * b.y + a.z * b.z;
+    return glm::degrees(std::atan2(sine, cosine));
+}
+
+///
+/// Random mesh with positions in a box, texture coordinates repeating a few
+/// times and unit normals, as in `floats_per_vertex`.
+///
+[[nodiscard]] auto make_mesh(std::size_t const count) -> mesh
+{
+    std::mt19937 rng{ 1337 }; // NOLINT
+    std::uniform_real_distribution<float> coord{ -10.0F, 10.0F };
+    std::uniform_real_distribution<float> uv{ 0.0F, 4.0F };
+    std::normal_distribution<float> direction{ 0.0F, 1.0F };
+
+    mesh result{};
+    result.stride = floats_per_vertex;
+    result.vertices.reserve(count * floats_per_vertex);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        glm::vec3 const n = glm::normalize(glm::vec3{ direction(rng), direction(rng), direction(rng) });
+        result.vertices.insert(result.vertices.end(),
+                               { coord(rng), coord(rng), coord(rng), uv(rng), uv(rng), n.x, n.y, n.z });
+        result.indices.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    return result;
+}
+
+} // namespace
+
+///
+/// Quantizes a random mesh with normals and decodes it back the way the
+/// `QUANTIZED` shaders do. Fails if any attribute is off by more than its
+/// encoding allows.
+///
+auto main() -> int
+{
+    constexpr std::size_t num_vertices = 1'000;
+    mesh const source = make_mesh(num_vertices);
+    quantized_mesh const quantized = quantize_mesh(source, quantize_attributes{ 0, 3, 5 }, "random");
+
+    float position_error = 0.0F;
+    float uv_error = 0.0F;
+    float normal_error = 0.0F;
+    float octahedral_error = 0.0F;
+
+    for(std::size_t v = 0; v < quantized.vertex_count(); ++v) {
+        std::size_t const base = v * quantized.stride;
+        float const* const vertex = &source.vertices[v * source.stride];
+
+        for(std::size_t axis = 0; axis < 3; ++axis) {
+            auto const i = static_cast<int>(axis);
+            std::size_t const offset = base + axis * sizeof(std::int16_t);
+            float const decoded = decode_snorm16(read<std::int16_t>(quantized.vertices, offset)) *
+                                      quantized.position_scale[i] +
+                                  quantized.position_offset[i];
+            position_error = std::max(position_error, std::abs(decoded - vertex[axis])); // NOLINT
+        }
+
+        for(std::size_t axis = 0; axis < 2; ++axis) {
+            auto const i = static_cast<int>(axis);
+            std::size_t const offset = base + 4 * sizeof(std::int16_t) + axis * sizeof(std::uint16_t);
+            float const decoded = decode_unorm16(read<std::uint16_t>(quantized.vertices, offset)) *
+                                      quantized.uv_transform[i] +
+                                  quantized.uv_transform[i + 2];
+            uv_error = std::max(uv_error, std::abs(decoded - vertex[3 + axis])); // NOLINT
+        }
+
+        glm::vec3 const normal{ vertex[5], vertex[6], vertex[7] }; // NOLINT
+        std::size_t const offset = base + 4 * sizeof(std::int16_t) + 2 * sizeof(std::uint16_t);
+        std::int16_t const x = read<std::int16_t>(quantized.vertices, offset);
+        std::int16_t const y = read<std::int16_t>(quantized.vertices, offset + sizeof(std::int16_t));
+        glm::vec2 const encoded{ decode_snorm16(x), decode_snorm16(y) };
+
+        normal_error = std::max(normal_error, angle_degrees(normal, decode_octahedral(encoded)));
+        octahedral_error =
+            std::max(octahedral_error, angle_degrees(normal, decode_octahedral(encode_octahedral(normal))));
+    }
+
+    // Half a step of each encoding, plus some slack for float rounding. Over
+    // millions of random normals the octahedral snorm16 error stays under
+    // 0.004 degrees
+    glm::vec4 const& scale = quantized.position_scale;
+    float const max_scale = std::max({ scale.x, scale.y, scale.z });
+    float const max_uv_extent = std::max(quantized.uv_transform.x, quantized.uv_transform.y);
+    float const position_tolerance = 0.5F * max_scale / snorm16_max * 1.05F;
+    float const uv_tolerance = 0.5F * max_uv_extent / unorm16_max * 1.05F;
+    constexpr float normal_tolerance = 0.01F;
+    constexpr float octahedral_tolerance = 0.001F;
+
+    spdlog::info("[Quantization] {} vertices, {} -> {} bytes per vertex",
+                 quantized.vertex_count(),
+                 source.stride * sizeof(float),
+                 quantized.stride);
+    spdlog::info("[Quantization] max error: position {:.3g} (tolerance {:.3g}), uv {:.3g} (tolerance {:.3g}), normal "
+                 "{:.3g} degrees (tolerance {:.3g}), unquantized octahedral round trip {:.3g} degrees",
+                 position_error,
+                 position_tolerance,
+                 uv_error,
+                 uv_tolerance,
+                 normal_error,
+                 normal_tolerance,
+                 octahedral_error);
+
+    // Zero length normals have no direction, they must map to +z instead of NaN
+    glm::vec2 const zero = encode_octahedral(glm::vec3{ 0.0F, 0.0F, 0.0F });
+    if(zero.x != 0.0F || zero.y != 0.0F) {
+        spdlog::error("[Quantization] A zero normal encodes to ({}, {}) instead of +z!", zero.x, zero.y);
+        return EXIT_FAILURE;
+    }
+
+    if(position_error > position_tolerance || uv_error > uv_tolerance || normal_error > normal_tolerance ||
+       octahedral_error > octahedral_tolerance) {
+        spdlog::error("[Quantization] Decoded vertices are off by more than the encoding allows!");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
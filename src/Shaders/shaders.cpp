@@ -8,6 +8,10 @@
 #include <string>
 #include <vector>
 
+#include "util/gl_state.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
+
 auto sdl_error(std::string const& msg) -> void
 {
     spdlog::error("[SDL2] <<{}>>: {}!", msg, SDL_GetError());
@@ -85,9 +89,11 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         SDL_Quit();
     };
     auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
 
     using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
     using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
 
     constexpr int window_width = 1280;
     constexpr int window_height = 720;
@@ -118,7 +124,8 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         sdl_error("Couldn't create a renderer");
     }
 
-    SDL_GLContext gl_context = SDL_GL_CreateContext(window.get());
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ SDL_GL_CreateContext(window.get()), sdl_context_deleter };
 
     if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
         spdlog::error("[glad] Failed to initialize OpenGL context");
@@ -165,20 +172,17 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
     }
     )";
 
-    unsigned int vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    vertex_array vao{};
+    vao.bind();
 
     unsigned int vbo = 0;
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), nullptr); // NOLINT
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat))); // NOLINT
-    glEnableVertexAttribArray(1);
+    // Position followed by color
+    using triangle_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec3>>;
+    triangle_layout::apply(vao, vbo);
 
     auto const vertex_shader = create_shader(shader_type::vertex, vertex_shader_source);
     auto const fragment_shader = create_shader(shader_type::fragment, fragment_shader_source);
@@ -186,11 +190,11 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
 
     unsigned int ibo = 0;
     glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+    vertex_array::unbind();
 
     bool window_should_close = false;
     constexpr color clear_color{ 0.0F, 0.0F, 0.0F, 1.0F };
@@ -218,22 +222,24 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept ->
         glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shader_program);
+        gl_state::current().use_program(shader_program);
 
         auto const ms_ellapsed = SDL_GetTicks();
         double const green_value = std::sin(ms_ellapsed) / 2.0F + 0.5F;
         int vertex_color_location = glGetUniformLocation(shader_program, "ourColor");
         glUniform4f(vertex_color_location, 0.0F, green_value, 0.0F, 1.0F);
 
-        glBindVertexArray(vao);
+        vao.bind();
 
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-
         SDL_GL_SwapWindow(window.get());
     }
 
-    SDL_GL_DeleteContext(gl_context);
+    gl_state::current().forget_program(shader_program);
+    gl_state::current().forget_buffer(vbo);
+    gl_state::current().forget_buffer(ibo);
+    glDeleteProgram(shader_program);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
 }
@@ -0,0 +1,170 @@
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/baked_texture.hpp"
+#include "util/texture_cache.hpp"
+#include "util/virtual_texture.hpp"
+
+namespace {
+
+/// Enough for bilinear filtering with a bit of slack
+constexpr std::uint32_t page_border = 2;
+
+[[noreturn]] auto usage() -> void
+{
+    spdlog::error("Usage: TextureBaker <input image> <output .btex/.vtex> [--flip] [--linear] [--channels N] "
+                  "[--format bc1|bc3|bc7] [--repeat N] [--virtual PAGE]");
+    std::exit(EXIT_FAILURE);
+}
+
+[[nodiscard]] auto parse_format(std::string_view const name) -> block_format
+{
+    if(name == "bc1") {
+        return block_format::bc1;
+    }
+    if(name == "bc3") {
+        return block_format::bc3;
+    }
+    if(name == "bc7") {
+        return block_format::bc7;
+    }
+
+    usage();
+}
+
+///
+/// `source` tiled `count` times on each side.
+///
+[[nodiscard]] auto repeat(image const& source, int const count) -> image
+{
+    image result{};
+    result.width = source.width * count;
+    result.height = source.height * count;
+    result.channels = source.channels;
+
+    auto const row_bytes = static_cast<std::size_t>(source.width) * static_cast<std::size_t>(source.channels);
+    result.pixels.reserve(row_bytes * static_cast<std::size_t>(count) * static_cast<std::size_t>(result.height));
+
+    for(int y = 0; y < result.height; ++y) {
+        auto const offset = static_cast<std::size_t>(y % source.height) * row_bytes;
+        auto const row = source.pixels.begin() + static_cast<std::ptrdiff_t>(offset);
+
+        for(int i = 0; i < count; ++i) {
+            result.pixels.insert(result.pixels.end(), row, row + static_cast<std::ptrdiff_t>(row_bytes));
+        }
+    }
+
+    return result;
+}
+
+} // namespace
+
+///
+/// Bakes an image into a `.btex` file with its whole mip chain, see
+/// `baked_texture.hpp`, or into a `.vtex` file of pages, see
+/// `virtual_texture.hpp`.
+///
+///     --flip        store rows bottom to top, like OpenGL expects
+///     --linear      filter the values as they are instead of as sRGB colors
+///     --channels N  force N channels instead of what the file has
+///     --format F    block compress to bc1 (RGB), bc3 or bc7 (RGBA)
+///     --repeat N    tile the image N times on each side first, for huge test images
+///     --virtual P   write a virtual texture of P squared pages, always RGBA8
+///
+auto main(int argc, char* argv[]) -> int
+{
+    std::vector<std::string_view> const args(argv, argv + argc); // NOLINT
+
+    if(args.size() < 3) {
+        usage();
+    }
+
+    std::string const input{ args[1] };
+    std::string const output{ args[2] };
+    bake_options options{};
+    bool flip = false;
+    int channels = 0;
+    int repeat_count = 1;
+    std::uint32_t page_size = 0;
+
+    for(std::size_t i = 3; i < args.size(); ++i) {
+        if(args[i] == "--flip") {
+            flip = true;
+        }
+        else if(args[i] == "--linear") {
+            options.srgb = false;
+        }
+        else if(args[i] == "--channels" && i + 1 < args.size()) {
+            channels = std::atoi(std::string{ args[++i] }.c_str());
+        }
+        else if(args[i] == "--format" && i + 1 < args.size()) {
+            options.compression = parse_format(args[++i]);
+        }
+        else if(args[i] == "--repeat" && i + 1 < args.size()) {
+            repeat_count = std::max(std::atoi(std::string{ args[++i] }.c_str()), 1);
+        }
+        else if(args[i] == "--virtual" && i + 1 < args.size()) {
+            page_size = static_cast<std::uint32_t>(std::max(std::atoi(std::string{ args[++i] }.c_str()), 0));
+        }
+        else {
+            usage();
+        }
+    }
+
+    // Through the cache like the examples, so the file is memory mapped and
+    // stb's global flip setting is left alone
+    texture_cache images{};
+    image source{};
+
+    if(!images.load_image(input, image_params{ flip, channels }, source)) {
+        return EXIT_FAILURE;
+    }
+
+    if(repeat_count > 1) {
+        source = repeat(source, repeat_count);
+    }
+
+    std::vector<unsigned char> const baked =
+        page_size != 0 ? bake_virtual_texture(source, page_size, page_border, options) : bake_texture(source, options);
+
+    if(baked.empty()) {
+        spdlog::error("[Texture Baker] Couldn't bake {}!", input);
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file{ output, std::ios::binary | std::ios::trunc };
+    file.write(reinterpret_cast<char const*>(baked.data()), static_cast<std::streamsize>(baked.size())); // NOLINT
+
+    if(!file) {
+        spdlog::error("[Texture Baker] Couldn't write {}!", output);
+        return EXIT_FAILURE;
+    }
+
+    spdlog::info("[Texture Baker] {} -> {}: {}x{}, {} channel(s), {} bytes",
+                 input,
+                 output,
+                 source.width,
+                 source.height,
+                 source.channels,
+                 baked.size());
+
+    if(page_size != 0) {
+        virtual_texture_view view{};
+        if(parse_virtual_texture(baked.data(), baked.size(), output, view)) {
+            spdlog::info("[Texture Baker] {} level(s) of {}x{} pages", view.header->levels, page_size, page_size);
+        }
+    }
+    else if(options.compression.has_value()) {
+        // An uncompressed mip chain takes about 4/3 of the first level
+        double const uncompressed = static_cast<double>(source.pixels.size()) * 4.0 / 3.0;
+        spdlog::info("[Texture Baker] {:.1f}x smaller than uncompressed", uncompressed / static_cast<double>(baked.size()));
+    }
+}
@@ -0,0 +1,174 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "util/transform_batch.hpp"
+#include "util/worker_pool.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+///
+/// Largest difference between any element of `a` and `b`.
+///
+[[nodiscard]] auto max_abs_error(std::vector<glm::mat4> const& a, std::vector<glm::mat4> const& b) noexcept -> float
+{
+    float result = 0.0F;
+
+    for(std::size_t i = 0; i < a.size(); ++i) {
+        for(int column = 0; column < 4; ++column) {
+            for(int row = 0; row < 4; ++row) {
+                result = std::max(result, std::abs(a[i][column][row] - b[i][column][row]));
+            }
+        }
+    }
+
+    return result;
+}
+
+///
+/// Best of `repeats` runs, in nanoseconds per object.
+///
+template<typename F>
+[[nodiscard]] auto measure(std::size_t const count, F&& fn) -> double
+{
+    constexpr int repeats = 10;
+    double best = 0.0;
+
+    for(int i = 0; i < repeats; ++i) {
+        auto const start = clock_type::now();
+        fn(static_cast<float>(i) * 0.016F); // NOLINT
+        auto const elapsed = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+
+        if(i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best / static_cast<double>(count);
+}
+
+///
+/// Returns `false` if the SIMD or threaded matrices drift from `compute_scalar`.
+///
+auto run(std::size_t const count, worker_pool& pool) -> bool
+{
+    std::mt19937 rng{ 1337 }; // NOLINT
+    std::uniform_real_distribution<float> coord{ -50.0F, 50.0F };
+
+    std::vector<glm::vec3> positions{};
+    std::vector<float> speeds{};
+    transform_batch batch{};
+
+    positions.reserve(count);
+    speeds.reserve(count);
+    batch.reserve(count);
+
+    glm::vec3 const axis{ 1.0F, 0.3F, 0.5F };
+
+    for(std::size_t i = 0; i < count; ++i) {
+        positions.emplace_back(coord(rng), coord(rng), coord(rng));
+        speeds.push_back(glm::radians(static_cast<float>(i % 360) * 20.0F)); // NOLINT
+        batch.add(positions.back(), axis, speeds.back());
+    }
+
+    std::vector<glm::mat4> out(count);
+
+    // What the examples used to do every frame
+    double const glm_loop = measure(count, [&](float const time) {
+        for(std::size_t i = 0; i < count; ++i) {
+            glm::mat4 model = glm::translate(glm::mat4{ 1.0F }, positions[i]);
+            out[i] = model * glm::toMat4(glm::angleAxis(speeds[i] * time, axis));
+        }
+    });
+
+    double const scalar = measure(count, [&](float const time) { batch.compute_scalar(time, out.data(), 0, count); });
+    double const simd = measure(count, [&](float const time) { batch.compute_simd(time, out.data(), 0, count); });
+    double const threaded = measure(count, [&](float const time) { batch.compute(time, out.data(), &pool); });
+
+    spdlog::info("[Transform] {:>8} objects: glm {:6.2f} ns, scalar {:6.2f} ns, simd {:6.2f} ns, simd + {} threads "
+                 "{:6.2f} ns per object",
+                 count,
+                 glm_loop,
+                 scalar,
+                 simd,
+                 pool.size() + 1,
+                 threaded);
+
+    // A frame in, and a few minutes in, where the angles need range reduction
+    constexpr float tolerance = 1e-4F;
+    std::vector<glm::mat4> reference(count);
+    bool accurate = true;
+
+    // Back to front, to go through the indexed path the culled examples use
+    std::vector<std::uint32_t> indices(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        indices[i] = static_cast<std::uint32_t>(count - 1 - i);
+    }
+
+    for(float const time : { 0.016F, 300.0F }) {
+        batch.compute_scalar(time, reference.data(), 0, count);
+
+        batch.compute_simd(time, out.data(), 0, count);
+        float const simd_error = max_abs_error(reference, out);
+
+        batch.compute(time, out.data(), &pool);
+        float const threaded_error = max_abs_error(reference, out);
+
+        batch.compute(time, indices.data(), count, out.data(), &pool);
+        std::reverse(out.begin(), out.end());
+        float const indexed_error = max_abs_error(reference, out);
+
+        float const error = std::max({ simd_error, threaded_error, indexed_error });
+
+        if(error > tolerance) {
+            spdlog::error("[Transform] {:>8} objects at {} s: max error {:.3g} (simd), {:.3g} (threaded), {:.3g} "
+                          "(indexed), over the tolerance of {:.3g}!",
+                          count,
+                          time,
+                          simd_error,
+                          threaded_error,
+                          indexed_error,
+                          tolerance);
+            accurate = false;
+        }
+        else {
+            spdlog::info("[Transform] {:>8} objects at {} s: max error {:.3g} (simd), {:.3g} (threaded), {:.3g} "
+                         "(indexed)",
+                         count,
+                         time,
+                         simd_error,
+                         threaded_error,
+                         indexed_error);
+        }
+    }
+
+    return accurate;
+}
+
+} // namespace
+
+auto main() -> int
+{
+    worker_pool pool{};
+
+    spdlog::info("[Transform] SIMD width: {}", transform_batch::simd_width());
+
+    bool accurate = true;
+    for(std::size_t const count : { std::size_t{ 1'000 }, std::size_t{ 100'000 }, std::size_t{ 1'000'000 } }) {
+        accurate = run(count, pool) && accurate;
+    }
+
+    return accurate ? EXIT_SUCCESS : EXIT_FAILURE;
+}
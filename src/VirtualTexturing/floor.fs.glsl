@@ -0,0 +1,59 @@
+#version 330 core
+
+// Compiled twice: as is to draw the floor from the virtual texture's page
+// cache, and with FEEDBACK defined to write the page each pixel wants
+
+in vec2 texCoord;
+
+// Width, height, last level and level bias
+uniform vec4 vt_size;
+// Page size, border, slot size and cache size in texels
+uniform vec4 vt_page;
+
+#ifdef FEEDBACK
+out uvec4 feedback;
+#else
+out vec4 fragColor;
+
+uniform sampler2D vt_cache;
+uniform usampler2D vt_indirection;
+#endif
+
+// Level of detail the pixel wants, picked the way mipmapping would
+float vt_level(vec2 uv) {
+    vec2 dx = dFdx(uv * vt_size.xy);
+    vec2 dy = dFdy(uv * vt_size.xy);
+    float rho = max(max(dot(dx, dx), dot(dy, dy)), 1e-8);
+    return clamp(0.5 * log2(rho) - vt_size.w, 0.0, vt_size.z);
+}
+
+// Texel of `uv` in `level`, kept off the far edges
+vec2 vt_texel(vec2 uv, float level) {
+    vec2 size = max(floor(vt_size.xy / exp2(level)), vec2(1.0));
+    return min(uv * size, size - 0.5);
+}
+
+#ifndef FEEDBACK
+vec4 vt_sample(vec2 uv, float wanted) {
+    ivec2 page = ivec2(vt_texel(uv, wanted) / vt_page.x);
+    uvec4 entry = texelFetch(vt_indirection, page, int(wanted));
+
+    // The entry may point at a coarser level if the wanted page isn't resident
+    vec2 texel = vt_texel(uv, float(entry.z));
+    vec2 in_page = texel - floor(texel / vt_page.x) * vt_page.x;
+    vec2 cache_texel = vec2(entry.xy) * vt_page.z + vt_page.y + in_page;
+    return textureLod(vt_cache, cache_texel / vt_page.w, 0.0);
+}
+#endif
+
+void main() {
+    // Derivatives before clamping, which would flatten them at the edges
+    float level = floor(vt_level(texCoord));
+    vec2 uv = clamp(texCoord, 0.0, 1.0);
+
+#ifdef FEEDBACK
+    feedback = uvec4(uvec2(vt_texel(uv, level) / vt_page.x), uint(level), 1u);
+#else
+    fragColor = vt_sample(uv, level);
+#endif
+}
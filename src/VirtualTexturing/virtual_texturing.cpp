@@ -0,0 +1,424 @@
+#include <SDL.h>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/frame_constants.hpp"
+#include "util/gl_state.hpp"
+#include "util/page_feedback.hpp"
+#include "util/shader.hpp"
+#include "util/vertex_array.hpp"
+#include "util/vertex_layout.hpp"
+#include "util/virtual_texture.hpp"
+#include "util/worker_pool.hpp"
+
+auto sdl_error(std::string const& msg) -> void
+{
+    spdlog::error("[SDL2] <<{}>>: {}!", msg, SDL_GetError());
+    std::exit(EXIT_FAILURE);
+}
+
+struct color
+{
+    GLfloat r = 0.0F;
+    GLfloat g = 0.0F;
+    GLfloat b = 0.0F;
+    GLfloat a = 1.0F;
+};
+
+class camera
+{
+private:
+    glm::vec3 m_pos;
+    glm::quat m_orient;
+
+public:
+    camera() noexcept = default;
+    camera(camera const&) noexcept = default;
+    camera(camera&&) noexcept = default;
+    ~camera() noexcept = default;
+
+    camera(glm::vec3 const& pos, glm::quat const& orient) noexcept
+        : m_pos{ pos }
+        , m_orient{ orient }
+    {
+    }
+    explicit camera(glm::vec3 const& pos) noexcept
+        : camera(pos, glm::quat{})
+    {
+    }
+
+    auto operator=(camera const&) noexcept -> camera& = default;
+    auto operator=(camera&&) noexcept -> camera& = default;
+
+    auto position() const noexcept -> glm::vec3 const&
+    {
+        return m_pos;
+    }
+
+    auto orientation() const noexcept -> glm::quat const&
+    {
+        return m_orient;
+    }
+
+    auto view() const noexcept -> glm::mat4
+    {
+        return glm::translate(glm::mat4_cast(m_orient), m_pos);
+    }
+
+    auto translate(glm::vec3 const& v) noexcept -> void
+    {
+        m_pos += v * m_orient;
+    }
+    auto translate(float const x, float const y, float const z)
+    {
+        this->translate(glm::vec3{ x, y, z });
+    }
+
+    auto rotate(float const angle, glm::vec3 const& axis) noexcept -> void
+    {
+        m_orient *= glm::angleAxis(angle, axis * m_orient);
+    }
+    auto rotate(float const angle, float const x, float const y, float const z) noexcept -> void
+    {
+        this->rotate(angle, glm::vec3{ x, y, z });
+    }
+
+    auto yaw(float const angle) noexcept -> void
+    {
+        this->rotate(angle, 0.0F, 1.0F, 0.0F);
+    }
+
+    auto pitch(float const angle) noexcept -> void
+    {
+        this->rotate(angle, 1.0F, 0.0F, 0.0F);
+    }
+
+    auto roll(float const angle) noexcept -> void
+    {
+        this->rotate(angle, 0.0F, 0.0F, 1.0F);
+    }
+};
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) noexcept -> int
+{
+    spdlog::info("Hello triangle!");
+
+    auto sdl_window_deleter = [](SDL_Window* w) noexcept {
+        SDL_DestroyWindow(w);
+        SDL_Quit();
+    };
+    auto sdl_renderer_deleter = [](SDL_Renderer* r) noexcept { SDL_DestroyRenderer(r); };
+    auto sdl_context_deleter = [](SDL_GLContext c) noexcept { SDL_GL_DeleteContext(c); };
+
+    using window_t = std::unique_ptr<SDL_Window, decltype(sdl_window_deleter)>;
+    using renderer_t = std::unique_ptr<SDL_Renderer, decltype(sdl_renderer_deleter)>;
+    using context_t = std::unique_ptr<void, decltype(sdl_context_deleter)>;
+
+    int window_width = 1280; // NOLINT
+    int window_height = 720; // NOLINT
+
+    if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+        sdl_error("Couldn't initialize SDL");
+    }
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+    window_t window{ SDL_CreateWindow("HelloTriangle!",
+                                      SDL_WINDOWPOS_CENTERED,
+                                      SDL_WINDOWPOS_CENTERED,
+                                      window_width,
+                                      window_height,
+                                      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE),
+                     sdl_window_deleter };
+
+    if(window == nullptr) {
+        sdl_error("Couldn't create a window");
+    }
+
+    renderer_t renderer{ SDL_CreateRenderer(window.get(), -1, SDL_RENDERER_ACCELERATED), sdl_renderer_deleter };
+
+    if(renderer == nullptr) {
+        sdl_error("Couldn't create a renderer");
+    }
+
+    // Owned, so that every GL object in main() is destroyed before the context
+    context_t gl_context{ SDL_GL_CreateContext(window.get()), sdl_context_deleter };
+
+    if(gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
+        spdlog::error("[glad] Failed to initialize OpenGL context");
+        std::exit(EXIT_FAILURE);
+    }
+
+    spdlog::info("[OpenGL] Context created! Version {}.{}", GLVersion.major, GLVersion.minor);
+
+    int num_attributes = 0;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &num_attributes);
+    spdlog::info("[OpenGL] Max number of vertex attributes: {}", num_attributes);
+
+    // A floor far bigger than the screen, textured with a virtual texture of
+    // wall.jpg tiled to 4096x4096. Only the pages a low resolution feedback
+    // pass sees get streamed into its page cache
+    constexpr float floor_extent = 40.0F;
+    constexpr float floor_height = -6.0F;
+    std::vector<GLfloat> const vertices = {
+        -floor_extent, floor_height, floor_extent,  0.0F, 0.0F, // NOLINT
+        floor_extent,  floor_height, floor_extent,  1.0F, 0.0F, // NOLINT
+        floor_extent,  floor_height, -floor_extent, 1.0F, 1.0F, // NOLINT
+        -floor_extent, floor_height, -floor_extent, 0.0F, 1.0F  // NOLINT
+    };
+
+    std::vector<unsigned int> const indices = { 0, 1, 2, 0, 2, 3 };
+
+    vertex_array vao{};
+    vao.bind();
+
+    unsigned int vbo = 0;
+    glGenBuffers(1, &vbo);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+
+    // Position followed by texture coordinates
+    using floor_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec2>>;
+    floor_layout::apply(vao, vbo);
+
+    unsigned int ibo = 0;
+    glGenBuffers(1, &ibo);
+    gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+    vertex_array::unbind();
+
+    worker_pool pool{};
+    constexpr std::uint32_t cache_side = 12;
+    virtual_texture floor_texture{ pool, "wall.vtex", cache_side };
+
+    if(!floor_texture.valid()) {
+        return EXIT_FAILURE;
+    }
+
+    page_feedback feedback{ window_width, window_height };
+    std::vector<page_request> page_requests{};
+
+    // The same shaders twice, once writing the page each pixel wants instead of its color
+    shader floor_program{ "floor.vs.glsl", "floor.fs.glsl" };
+    floor_program.use();
+    floor_program.set_int("vt_cache", 0);
+    floor_program.set_int("vt_indirection", 1);
+    floor_texture.set_uniforms(floor_program);
+
+    shader feedback_program{ "floor.vs.glsl", "floor.fs.glsl", { "FEEDBACK" } };
+    feedback_program.use();
+    floor_texture.set_uniforms(feedback_program, feedback.level_bias());
+
+    glm::vec3 camera_pos{ 0.0F, 0.0F, 3.0F }; // NOLINT
+    glm::vec3 camera_front{ 0.0F, 0.0F, -1.0F };
+    camera cam{ camera_pos, camera_front };
+
+    constexpr float translate_offset = 0.5F;
+    constexpr float roll_offset = 0.5F;
+
+    auto const fwidth = static_cast<float>(window_width);
+    auto const fheight = static_cast<float>(window_height);
+    float fov = 45.0F; // NOLINT
+    constexpr float near = 0.1F;
+    constexpr float far = 100.0F;
+
+    frame_constants_buffer frame_buffer{};
+    frame_constants frame{};
+    frame.projection = glm::perspective(glm::radians(fov), fwidth / fheight, near, far);
+
+    bool window_should_close = false;
+    constexpr color clear_color{ 0.0F, 0.0F, 0.0F, 1.0F };
+
+    int last_mouse_x = window_width / 2;  // NOLINT
+    int last_mouse_y = window_height / 2; // NOLINT
+
+    bool dragging = false;
+
+    gl_state::current().set_enabled(GL_DEPTH_TEST, true);
+
+    auto start = std::chrono::steady_clock::now();
+
+    while(!window_should_close) {
+        using namespace std::chrono;
+        auto end = steady_clock::now();
+        float const elapsed = duration<float>{ end - start }.count();
+        start = end;
+
+        SDL_Event e;
+        while(SDL_PollEvent(&e) != 0) {
+            switch(e.type) {
+            case SDL_QUIT: {
+                window_should_close = true;
+                break;
+            }
+            case SDL_WINDOWEVENT: {
+                if(e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    window_width = e.window.data1;
+                    window_height = e.window.data2;
+                    glViewport(0, 0, e.window.data1, e.window.data2);
+                    feedback.resize(e.window.data1, e.window.data2);
+                    frame.projection = glm::perspective(
+                        glm::radians(fov), static_cast<float>(e.window.data1) / e.window.data2, near, far);
+                }
+                break;
+            }
+            case SDL_KEYDOWN: {
+                float const camera_speed = 50.0F * elapsed;
+
+                switch(e.key.keysym.sym) {
+                case SDLK_ESCAPE: {
+                    window_should_close = true;
+                    break;
+                }
+                case SDLK_UP: {
+                    cam.translate(0.0F, 0.0F, translate_offset * camera_speed);
+                    break;
+                }
+                case SDLK_DOWN: {
+                    cam.translate(0.0F, 0.0F, -translate_offset * camera_speed);
+                    break;
+                }
+                case SDLK_LEFT: {
+                    cam.translate(translate_offset * camera_speed, 0.0F, 0.0F);
+                    break;
+                }
+                case SDLK_RIGHT: {
+                    cam.translate(-translate_offset * camera_speed, 0.0F, 0.0F);
+                    break;
+                }
+                case SDLK_w: {
+                    cam.translate(0.0F, -translate_offset * camera_speed, 0.0F);
+                    break;
+                }
+                case SDLK_s: {
+                    cam.translate(0.0F, translate_offset * camera_speed, 0.0F);
+                    break;
+                }
+                case SDLK_q: {
+                    cam.roll(roll_offset * camera_speed);
+                    break;
+                }
+                case SDLK_e: {
+                    cam.roll(-roll_offset * camera_speed);
+                    break;
+                }
+                default: {
+                    break;
+                }
+                }
+                break;
+            }
+            case SDL_MOUSEBUTTONDOWN: {
+                if(e.button.button == SDL_BUTTON_LEFT) {
+                    dragging = true;
+                    last_mouse_x = e.button.x;
+                    last_mouse_y = e.button.y;
+                }
+                break;
+            }
+            case SDL_MOUSEBUTTONUP: {
+                if(e.button.button == SDL_BUTTON_LEFT) {
+                    dragging = false;
+                }
+                break;
+            }
+            case SDL_MOUSEWHEEL: {
+                if(e.wheel.y != 0) {
+                    fov -= e.wheel.y;
+
+                    if(fov < 1.0F) {
+                        fov = 1.0F;
+                    }
+                    if(fov > 45.0F) { // NOLINT
+                        fov = 45.0F;  // NOLINT
+                    }
+
+                    float const a = static_cast<float>(window_width) / static_cast<float>(window_height);
+                    glm::mat4 proj = glm::perspective(glm::radians(fov), a, near, far);
+
+                    frame.projection = proj;
+                }
+                break;
+            }
+            default: {
+                break;
+            }
+            }
+        }
+
+        if(dragging) {
+            int mouse_x = 0;
+            int mouse_y = 0;
+            SDL_GetMouseState(&mouse_x, &mouse_y);
+
+            auto x_offset = static_cast<float>(mouse_x - last_mouse_x);
+            auto y_offset = static_cast<float>(last_mouse_y - mouse_y);
+
+            last_mouse_x = mouse_x;
+            last_mouse_y = mouse_y;
+
+            constexpr float sensitivity = 0.001F;
+
+            x_offset *= sensitivity;
+            y_offset *= sensitivity;
+
+            cam.yaw(-x_offset);
+            cam.pitch(y_offset);
+        }
+
+        glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        frame.view = cam.view();
+        frame_buffer.update(frame);
+
+        // Pages the floor wants, as seen a few frames ago
+        feedback.begin();
+        feedback_program.use();
+        vao.bind();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+        feedback.end(window_width, window_height);
+
+        if(feedback.collect(page_requests)) {
+            floor_texture.request(page_requests);
+        }
+        floor_texture.update();
+
+        floor_program.use();
+        floor_texture.bind(0, 1);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+
+        SDL_GL_SwapWindow(window.get());
+    }
+
+    virtual_texture::statistics const& pages = floor_texture.stats();
+    spdlog::info("[Virtual Texture] {} of {} page(s) resident, {} requested, {} uploaded, {} evicted, {} dropped, {} "
+                 "feedback frame(s) skipped",
+                 floor_texture.resident_pages(),
+                 floor_texture.capacity(),
+                 pages.requested,
+                 pages.uploaded,
+                 pages.evicted,
+                 pages.dropped,
+                 feedback.skipped());
+
+    gl_state::current().forget_buffer(vbo);
+    gl_state::current().forget_buffer(ibo);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ibo);
+}
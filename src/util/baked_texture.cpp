@@ -0,0 +1,399 @@
+#include "util/baked_texture.hpp"
+#include "util/block_compression.hpp"
+#include "util/mapped_file.hpp"
+#include "util/texture2d.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr std::size_t level_alignment = 16;
+
+[[nodiscard]] auto align(std::size_t const value) noexcept -> std::size_t
+{
+    return (value + level_alignment - 1) / level_alignment * level_alignment;
+}
+
+[[nodiscard]] auto srgb_to_linear(float const c) noexcept -> float
+{
+    return c <= 0.04045F ? c / 12.92F : std::pow((c + 0.055F) / 1.055F, 2.4F); // NOLINT
+}
+
+[[nodiscard]] auto linear_to_srgb(float const c) noexcept -> float
+{
+    return c <= 0.0031308F ? c * 12.92F : 1.055F * std::pow(c, 1.0F / 2.4F) - 0.055F; // NOLINT
+}
+
+///
+/// Image with float channels, in linear light when baking with `srgb`.
+///
+struct float_image
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<float> pixels{};
+};
+
+[[nodiscard]] auto is_color_channel(int const channels, int const c, bool const srgb) noexcept -> bool
+{
+    return srgb && channels >= 3 && c < 3;
+}
+
+[[nodiscard]] auto to_float(image const& source, bool const srgb) -> float_image
+{
+    std::array<float, 256> decode{};
+    for(std::size_t i = 0; i < decode.size(); ++i) {
+        decode[i] = srgb_to_linear(static_cast<float>(i) / 255.0F); // NOLINT
+    }
+
+    float_image result{ source.width, source.height, source.channels, {} };
+    result.pixels.resize(source.pixels.size());
+
+    for(std::size_t i = 0; i < source.pixels.size(); ++i) {
+        int const c = static_cast<int>(i % static_cast<std::size_t>(source.channels));
+        unsigned char const value = source.pixels[i];
+        result.pixels[i] =
+            is_color_channel(source.channels, c, srgb) ? decode[value] : static_cast<float>(value) / 255.0F; // NOLINT
+    }
+
+    return result;
+}
+
+auto to_bytes(float_image const& source, bool const srgb, unsigned char* const out) noexcept -> void
+{
+    for(std::size_t i = 0; i < source.pixels.size(); ++i) {
+        int const c = static_cast<int>(i % static_cast<std::size_t>(source.channels));
+        float value = std::clamp(source.pixels[i], 0.0F, 1.0F);
+
+        if(is_color_channel(source.channels, c, srgb)) {
+            value = linear_to_srgb(value);
+        }
+
+        out[i] = static_cast<unsigned char>(std::lround(value * 255.0F)); // NOLINT
+    }
+}
+
+///
+/// Halves one dimension with the [1 3 3 1] / 8 kernel, `stride` apart
+/// samples of `count` long lines.
+///
+auto downsample_line(float const* const src,
+                     int const count,
+                     std::size_t const stride,
+                     int const channels,
+                     float* const dst,
+                     std::size_t const dst_stride) noexcept -> void
+{
+    constexpr std::array<float, 4> weights{ 1.0F / 8.0F, 3.0F / 8.0F, 3.0F / 8.0F, 1.0F / 8.0F };
+    int const half = std::max(1, count / 2);
+
+    for(int i = 0; i < half; ++i) {
+        for(int c = 0; c < channels; ++c) {
+            float sum = 0.0F;
+
+            for(int tap = 0; tap < 4; ++tap) {
+                int const x = std::clamp(2 * i - 1 + tap, 0, count - 1);
+                sum += weights[static_cast<std::size_t>(tap)] *
+                       src[static_cast<std::size_t>(x) * stride + static_cast<std::size_t>(c)]; // NOLINT
+            }
+
+            dst[static_cast<std::size_t>(i) * dst_stride + static_cast<std::size_t>(c)] = sum; // NOLINT
+        }
+    }
+}
+
+[[nodiscard]] auto downsample(float_image const& src) -> float_image
+{
+    int const width = std::max(1, src.width / 2);
+    int const height = std::max(1, src.height / 2);
+    auto const channels = static_cast<std::size_t>(src.channels);
+
+    // Rows first into a (width x src.height) image, then columns
+    std::vector<float> rows(static_cast<std::size_t>(width) * static_cast<std::size_t>(src.height) * channels);
+    for(int y = 0; y < src.height; ++y) {
+        auto const row = static_cast<std::size_t>(y);
+        downsample_line(src.pixels.data() + row * static_cast<std::size_t>(src.width) * channels,
+                        src.width,
+                        channels,
+                        src.channels,
+                        rows.data() + row * static_cast<std::size_t>(width) * channels,
+                        channels);
+    }
+
+    float_image result{ width, height, src.channels, {} };
+    result.pixels.resize(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * channels);
+
+    std::size_t const row_stride = static_cast<std::size_t>(width) * channels;
+    for(int x = 0; x < width; ++x) {
+        auto const column = static_cast<std::size_t>(x) * channels;
+        downsample_line(
+            rows.data() + column, src.height, row_stride, src.channels, result.pixels.data() + column, row_stride);
+    }
+
+    return result;
+}
+
+} // namespace
+
+auto bake_texture(image const& source, bake_options const& options) -> std::vector<unsigned char>
+{
+    std::vector<float_image> chain{};
+    chain.push_back(to_float(source, options.srgb));
+
+    while(chain.back().width > 1 || chain.back().height > 1) {
+        chain.push_back(downsample(chain.back()));
+    }
+
+    baked_texture_header header{};
+    header.width = static_cast<std::uint32_t>(source.width);
+    header.height = static_cast<std::uint32_t>(source.height);
+    header.levels = static_cast<std::uint32_t>(chain.size());
+    header.channels = static_cast<std::uint32_t>(source.channels);
+    header.internal_format = internal_format_of(source.channels);
+    header.format = format_of(source.channels);
+
+    if(options.compression.has_value()) {
+        header.channels = *options.compression == block_format::bc1 ? 3 : 4;
+        header.internal_format = block_internal_format(*options.compression);
+        header.format = 0;
+    }
+
+    std::vector<baked_level> levels(chain.size());
+    std::size_t offset = align(sizeof(baked_texture_header) + levels.size() * sizeof(baked_level));
+
+    for(std::size_t i = 0; i < chain.size(); ++i) {
+        std::size_t const size = options.compression.has_value()
+                                     ? compressed_size(*options.compression, chain[i].width, chain[i].height)
+                                     : chain[i].pixels.size();
+
+        levels[i].offset = offset;
+        levels[i].size = size;
+        levels[i].width = static_cast<std::uint32_t>(chain[i].width);
+        levels[i].height = static_cast<std::uint32_t>(chain[i].height);
+        offset = align(offset + size);
+    }
+
+    std::vector<unsigned char> result(offset);
+    std::memcpy(result.data(), &header, sizeof(header));
+    std::memcpy(result.data() + sizeof(header), levels.data(), levels.size() * sizeof(baked_level)); // NOLINT
+
+    std::vector<unsigned char> pixels{};
+    for(std::size_t i = 0; i < chain.size(); ++i) {
+        unsigned char* const out = result.data() + levels[i].offset; // NOLINT
+
+        if(!options.compression.has_value()) {
+            to_bytes(chain[i], options.srgb, out);
+            continue;
+        }
+
+        pixels.resize(chain[i].pixels.size());
+        to_bytes(chain[i], options.srgb, pixels.data());
+
+        std::vector<unsigned char> const blocks =
+            compress_blocks(*options.compression, pixels.data(), chain[i].width, chain[i].height, chain[i].channels);
+        std::memcpy(out, blocks.data(), blocks.size());
+    }
+
+    return result;
+}
+
+auto parse_baked_texture(unsigned char const* const data,
+                         std::size_t const size,
+                         std::string const& name,
+                         baked_texture_view& view) -> bool
+{
+    if(data == nullptr || size < sizeof(baked_texture_header)) {
+        spdlog::error("[Baked Texture] {} is too small to be a baked texture!", name);
+        return false;
+    }
+
+    auto const* const header = reinterpret_cast<baked_texture_header const*>(data); // NOLINT
+
+    if(header->magic != baked_texture_header::file_magic || header->version != baked_texture_header::file_version) {
+        spdlog::error("[Baked Texture] {} isn't a version {} baked texture!", name, baked_texture_header::file_version);
+        return false;
+    }
+
+    std::optional<block_format> const compression = block_format_of(header->internal_format);
+    std::size_t const table_end = sizeof(baked_texture_header) + header->levels * sizeof(baked_level);
+
+    if(header->levels == 0 || header->channels < 1 || header->channels > 4 || table_end > size ||
+       (header->format == 0 && !compression.has_value())) {
+        spdlog::error("[Baked Texture] {} has a broken header!", name);
+        return false;
+    }
+
+    auto const* const levels = reinterpret_cast<baked_level const*>(data + sizeof(baked_texture_header)); // NOLINT
+
+    for(std::uint32_t i = 0; i < header->levels; ++i) {
+        baked_level const& level = levels[i]; // NOLINT
+        std::uint64_t const expected =
+            header->format == 0
+                ? compressed_size(*compression, static_cast<int>(level.width), static_cast<int>(level.height))
+                : std::uint64_t{ level.width } * std::uint64_t{ level.height } * std::uint64_t{ header->channels };
+
+        if(level.size != expected || level.offset > size || level.size > size - level.offset) {
+            spdlog::error("[Baked Texture] {} level {} lies outside the file!", name, i);
+            return false;
+        }
+    }
+
+    view.header = header;
+    view.levels = levels;
+    view.data = data;
+    return true;
+}
+
+auto baked_texture_supported(baked_texture_view const& view) noexcept -> bool
+{
+    std::optional<block_format> const compression = block_format_of(view.header->internal_format);
+    return view.header->format != 0 || block_format_supported(*compression);
+}
+
+auto decompress_baked_texture(baked_texture_view const& view, std::vector<image>& levels) -> bool
+{
+    baked_texture_header const& header = *view.header;
+    block_format const compression = *block_format_of(header.internal_format);
+    bool ok = true;
+
+    levels.resize(header.levels);
+
+    for(std::uint32_t i = 0; i < header.levels; ++i) {
+        baked_level const& level = view.levels[i]; // NOLINT
+        image& decoded = levels[i];
+        decoded.width = static_cast<int>(level.width);
+        decoded.height = static_cast<int>(level.height);
+        decoded.channels = 4;
+
+        ok = decompress_blocks(compression, view.data + level.offset, decoded.width, decoded.height, decoded.pixels) && // NOLINT
+             ok;
+    }
+
+    return ok;
+}
+
+auto upload_baked_texture(texture const& tex, baked_texture_view const& view, std::uint32_t const first_level) noexcept
+    -> void
+{
+    baked_texture_header const& header = *view.header;
+    baked_level const& top = view.levels[first_level]; // NOLINT
+    auto const levels = static_cast<GLint>(header.levels - first_level);
+    bool const compressed = header.format == 0;
+    bool const immutable = GLAD_GL_VERSION_4_2 != 0 || GLAD_GL_ARB_texture_storage != 0;
+
+    // Compressed levels can't be allocated without their data before GL 4.2
+    if(!compressed || immutable) {
+        allocate_texture_storage(
+            tex, levels, header.internal_format, static_cast<GLsizei>(top.width), static_cast<GLsizei>(top.height));
+    }
+    else {
+        tex.bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if(!compressed) {
+        set_channel_swizzle(GL_TEXTURE_2D, static_cast<int>(header.channels));
+    }
+
+    for(GLint i = 0; i < levels; ++i) {
+        baked_level const& level = view.levels[first_level + static_cast<std::uint32_t>(i)]; // NOLINT
+        auto const width = static_cast<GLsizei>(level.width);
+        auto const height = static_cast<GLsizei>(level.height);
+        auto const size = static_cast<GLsizei>(level.size);
+        void const* const pixels = view.data + level.offset; // NOLINT
+
+        if(compressed && immutable) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height, header.internal_format, size, pixels);
+        }
+        else if(compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, header.internal_format, width, height, 0, size, pixels);
+        }
+        else {
+            std::size_t const row_bytes = static_cast<std::size_t>(level.width) * header.channels;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_of(row_bytes));
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height, header.format, GL_UNSIGNED_BYTE, pixels);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+auto upload_mip_chain(texture const& tex, std::vector<image> const& levels, std::size_t const first_level) noexcept
+    -> void
+{
+    image const& top = levels[first_level];
+    allocate_texture_storage(tex,
+                             static_cast<int>(levels.size() - first_level),
+                             internal_format_of(top.channels),
+                             top.width,
+                             top.height);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    set_channel_swizzle(GL_TEXTURE_2D, top.channels);
+
+    for(std::size_t i = first_level; i < levels.size(); ++i) {
+        image const& level = levels[i];
+        auto const row_bytes = static_cast<std::size_t>(level.width) * static_cast<std::size_t>(level.channels);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_of(row_bytes));
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        static_cast<GLint>(i - first_level),
+                        0,
+                        0,
+                        level.width,
+                        level.height,
+                        format_of(level.channels),
+                        GL_UNSIGNED_BYTE,
+                        level.pixels.data());
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+auto load_baked_texture(std::string const& path) -> std::shared_ptr<texture>
+{
+    mapped_file const file{ path };
+
+    if(!file.valid()) {
+        spdlog::error("[Baked Texture] Couldn't map {}: {}!", path, file.error());
+        return nullptr;
+    }
+
+    baked_texture_view view{};
+    if(!parse_baked_texture(file.data(), file.size(), path, view)) {
+        return nullptr;
+    }
+
+    auto result = std::make_shared<texture>();
+
+    if(baked_texture_supported(view)) {
+        upload_baked_texture(*result, view);
+        return result;
+    }
+
+    spdlog::info("[Baked Texture] {} is compressed in a format the driver lacks, decoding it", path);
+
+    std::vector<image> levels{};
+    if(!decompress_baked_texture(view, levels)) {
+        spdlog::error("[Baked Texture] {} has blocks that can't be decoded!", path);
+        return nullptr;
+    }
+
+    upload_mip_chain(*result, levels);
+    return result;
+}
@@ -0,0 +1,745 @@
+#include "util/block_compression.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+constexpr int block_dim = 4;
+constexpr std::size_t block_pixel_count = 16;
+
+///
+/// One 4x4 block as RGBA, row by row.
+///
+using block_pixels = std::array<std::array<int, 4>, block_pixel_count>;
+
+template<std::size_t N>
+using vec = std::array<float, N>;
+
+[[nodiscard]] auto gather_block(unsigned char const* const pixels,
+                                int const width,
+                                int const height,
+                                int const channels,
+                                int const block_x,
+                                int const block_y) noexcept -> block_pixels
+{
+    block_pixels result{};
+    bool const grey = channels < 3;
+    bool const alpha = channels == 2 || channels == 4;
+    constexpr int opaque = 255;
+
+    for(int y = 0; y < block_dim; ++y) {
+        for(int x = 0; x < block_dim; ++x) {
+            int const source_x = std::min(block_x * block_dim + x, width - 1);
+            int const source_y = std::min(block_y * block_dim + y, height - 1);
+            auto const offset = (static_cast<std::size_t>(source_y) * static_cast<std::size_t>(width) +
+                                 static_cast<std::size_t>(source_x)) *
+                                static_cast<std::size_t>(channels);
+            unsigned char const* const in = pixels + offset; // NOLINT
+            auto& out = result[static_cast<std::size_t>(y * block_dim + x)];
+
+            for(std::size_t c = 0; c < 3; ++c) {
+                out[c] = in[grey ? 0 : c]; // NOLINT
+            }
+            out[3] = alpha ? in[channels - 1] : opaque; // NOLINT
+        }
+    }
+
+    return result;
+}
+
+///
+/// Line through the first `N` channels of `block` along their principal axis,
+/// clipped to the block's extent.
+///
+template<std::size_t N>
+auto fit_principal_axis(block_pixels const& block, vec<N>& low, vec<N>& high) noexcept -> void
+{
+    vec<N> mean{};
+    vec<N> min_value{};
+    vec<N> max_value{};
+    min_value.fill(std::numeric_limits<float>::max());
+    max_value.fill(std::numeric_limits<float>::lowest());
+
+    for(auto const& p : block) {
+        for(std::size_t c = 0; c < N; ++c) {
+            auto const value = static_cast<float>(p[c]);
+            mean[c] += value / static_cast<float>(block_pixel_count);
+            min_value[c] = std::min(min_value[c], value);
+            max_value[c] = std::max(max_value[c], value);
+        }
+    }
+
+    std::array<vec<N>, N> covariance{};
+    for(auto const& p : block) {
+        for(std::size_t i = 0; i < N; ++i) {
+            for(std::size_t j = 0; j < N; ++j) {
+                covariance[i][j] += (static_cast<float>(p[i]) - mean[i]) * (static_cast<float>(p[j]) - mean[j]);
+            }
+        }
+    }
+
+    // Power iteration, starting from the bounding box diagonal
+    vec<N> axis{};
+    for(std::size_t c = 0; c < N; ++c) {
+        axis[c] = max_value[c] - min_value[c];
+    }
+
+    constexpr int iterations = 8;
+    constexpr float min_length = 1e-6F;
+
+    for(int iteration = 0; iteration < iterations; ++iteration) {
+        vec<N> next{};
+        float length = 0.0F;
+
+        for(std::size_t i = 0; i < N; ++i) {
+            for(std::size_t j = 0; j < N; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+            length += next[i] * next[i];
+        }
+
+        if(length < min_length) {
+            break;
+        }
+
+        length = std::sqrt(length);
+        for(std::size_t c = 0; c < N; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float min_t = 0.0F;
+    float max_t = 0.0F;
+
+    for(auto const& p : block) {
+        float t = 0.0F;
+        for(std::size_t c = 0; c < N; ++c) {
+            t += (static_cast<float>(p[c]) - mean[c]) * axis[c];
+        }
+
+        min_t = std::min(min_t, t);
+        max_t = std::max(max_t, t);
+    }
+
+    constexpr float max_channel = 255.0F;
+    for(std::size_t c = 0; c < N; ++c) {
+        low[c] = std::clamp(mean[c] + min_t * axis[c], 0.0F, max_channel);
+        high[c] = std::clamp(mean[c] + max_t * axis[c], 0.0F, max_channel);
+    }
+}
+
+///
+/// Endpoints minimizing the squared error of `block` for the given
+/// interpolation weights (0 at `low`, 1 at `high`). Returns `false` when the
+/// weights don't determine them.
+///
+template<std::size_t N>
+[[nodiscard]] auto fit_least_squares(block_pixels const& block,
+                                     std::array<float, block_pixel_count> const& weights,
+                                     vec<N>& low,
+                                     vec<N>& high) noexcept -> bool
+{
+    float aa = 0.0F;
+    float ab = 0.0F;
+    float bb = 0.0F;
+    vec<N> ax{};
+    vec<N> bx{};
+
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        float const b = weights[i];
+        float const a = 1.0F - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for(std::size_t c = 0; c < N; ++c) {
+            auto const value = static_cast<float>(block[i][c]);
+            ax[c] += a * value;
+            bx[c] += b * value;
+        }
+    }
+
+    constexpr float min_determinant = 1e-4F;
+    float const determinant = aa * bb - ab * ab;
+
+    if(std::abs(determinant) < min_determinant) {
+        return false;
+    }
+
+    constexpr float max_channel = 255.0F;
+    for(std::size_t c = 0; c < N; ++c) {
+        low[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0F, max_channel);
+        high[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0F, max_channel);
+    }
+
+    return true;
+}
+
+template<std::size_t N, std::size_t Count>
+[[nodiscard]] auto nearest(std::array<std::array<int, 4>, Count> const& palette, std::array<int, 4> const& pixel) noexcept
+    -> std::pair<int, int>
+{
+    int best = 0;
+    int best_error = std::numeric_limits<int>::max();
+
+    for(std::size_t i = 0; i < Count; ++i) {
+        int error = 0;
+        for(std::size_t c = 0; c < N; ++c) {
+            int const d = palette[i][c] - pixel[c];
+            error += d * d;
+        }
+
+        if(error < best_error) {
+            best = static_cast<int>(i);
+            best_error = error;
+        }
+    }
+
+    return { best, best_error };
+}
+
+auto write_le(unsigned char* const out, std::uint64_t value, std::size_t const bytes) noexcept -> void
+{
+    for(std::size_t i = 0; i < bytes; ++i, value >>= 8U) {
+        out[i] = static_cast<unsigned char>(value & 0xFFU); // NOLINT
+    }
+}
+
+[[nodiscard]] auto read_le(unsigned char const* const in, std::size_t const bytes) noexcept -> std::uint64_t
+{
+    std::uint64_t value = 0;
+    for(std::size_t i = bytes; i > 0; --i) {
+        value = (value << 8U) | in[i - 1]; // NOLINT
+    }
+    return value;
+}
+
+//
+// BC1
+//
+
+[[nodiscard]] auto pack_565(vec<3> const& color) noexcept -> std::uint16_t
+{
+    auto const r = static_cast<unsigned int>(std::lround(color[0] * 31.0F / 255.0F)); // NOLINT
+    auto const g = static_cast<unsigned int>(std::lround(color[1] * 63.0F / 255.0F)); // NOLINT
+    auto const b = static_cast<unsigned int>(std::lround(color[2] * 31.0F / 255.0F)); // NOLINT
+    return static_cast<std::uint16_t>((r << 11U) | (g << 5U) | b);
+}
+
+[[nodiscard]] auto unpack_565(unsigned int const packed) noexcept -> std::array<int, 4>
+{
+    unsigned int const r = (packed >> 11U) & 0x1FU;
+    unsigned int const g = (packed >> 5U) & 0x3FU;
+    unsigned int const b = packed & 0x1FU;
+    return { static_cast<int>((r << 3U) | (r >> 2U)),
+             static_cast<int>((g << 2U) | (g >> 4U)),
+             static_cast<int>((b << 3U) | (b >> 2U)),
+             255 }; // NOLINT
+}
+
+[[nodiscard]] auto bc1_palette(unsigned int const c0, unsigned int const c1, bool const four_colors) noexcept
+    -> std::array<std::array<int, 4>, 4>
+{
+    std::array<std::array<int, 4>, 4> palette{ unpack_565(c0), unpack_565(c1), {}, {} };
+
+    for(std::size_t c = 0; c < 3; ++c) {
+        int const a = palette[0][c];
+        int const b = palette[1][c];
+
+        if(four_colors) {
+            palette[2][c] = (2 * a + b) / 3;
+            palette[3][c] = (a + 2 * b) / 3;
+        }
+        else {
+            palette[2][c] = (a + b) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    palette[2][3] = 255;                   // NOLINT
+    palette[3][3] = four_colors ? 255 : 0; // NOLINT
+    return palette;
+}
+
+struct bc1_candidate
+{
+    std::uint16_t c0 = 0;
+    std::uint16_t c1 = 0;
+    std::array<int, block_pixel_count> indices{};
+    int error = std::numeric_limits<int>::max();
+};
+
+[[nodiscard]] auto evaluate_bc1(block_pixels const& block, vec<3> const& e0, vec<3> const& e1) noexcept -> bc1_candidate
+{
+    bc1_candidate result{};
+    result.c0 = pack_565(e0);
+    result.c1 = pack_565(e1);
+    result.error = 0;
+
+    auto const palette = bc1_palette(result.c0, result.c1, true);
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        auto const [index, error] = nearest<3>(palette, block[i]);
+        result.indices[i] = index;
+        result.error += error;
+    }
+
+    return result;
+}
+
+auto encode_bc1(block_pixels const& block, unsigned char* const out) noexcept -> void
+{
+    vec<3> low{};
+    vec<3> high{};
+    fit_principal_axis(block, low, high);
+    bc1_candidate best = evaluate_bc1(block, high, low);
+
+    // Index order is c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+    constexpr std::array<float, 4> weights{ 0.0F, 1.0F, 1.0F / 3.0F, 2.0F / 3.0F };
+    std::array<float, block_pixel_count> pixel_weights{};
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        pixel_weights[i] = weights[static_cast<std::size_t>(best.indices[i])];
+    }
+
+    if(fit_least_squares(block, pixel_weights, high, low)) {
+        if(bc1_candidate refined = evaluate_bc1(block, high, low); refined.error < best.error) {
+            best = refined;
+        }
+    }
+
+    // Four color mode needs c0 > c1, a single color only uses c0
+    if(best.c0 < best.c1) {
+        std::swap(best.c0, best.c1);
+        for(int& index : best.indices) {
+            index ^= 1;
+        }
+    }
+    else if(best.c0 == best.c1) {
+        best.indices.fill(0);
+    }
+
+    std::uint64_t indices = 0;
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        indices |= static_cast<std::uint64_t>(best.indices[i]) << (2 * i);
+    }
+
+    write_le(out, best.c0, 2);
+    write_le(out + 2, best.c1, 2); // NOLINT
+    write_le(out + 4, indices, 4); // NOLINT
+}
+
+auto decode_bc1(unsigned char const* const in, bool const always_four_colors, block_pixels& out) noexcept -> void
+{
+    auto const c0 = static_cast<unsigned int>(read_le(in, 2));
+    auto const c1 = static_cast<unsigned int>(read_le(in + 2, 2)); // NOLINT
+    std::uint64_t const indices = read_le(in + 4, 4);             // NOLINT
+    auto const palette = bc1_palette(c0, c1, always_four_colors || c0 > c1);
+
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        out[i] = palette[(indices >> (2 * i)) & 0x3U];
+    }
+}
+
+//
+// BC3 alpha
+//
+
+[[nodiscard]] auto alpha_palette(int const a0, int const a1) noexcept -> std::array<std::array<int, 4>, 8>
+{
+    std::array<std::array<int, 4>, 8> palette{};
+    palette[0][0] = a0;
+    palette[1][0] = a1;
+
+    if(a0 > a1) {
+        for(int i = 1; i < 7; ++i) {
+            palette[static_cast<std::size_t>(i + 1)][0] = ((7 - i) * a0 + i * a1) / 7; // NOLINT
+        }
+    }
+    else {
+        for(int i = 1; i < 5; ++i) {
+            palette[static_cast<std::size_t>(i + 1)][0] = ((5 - i) * a0 + i * a1) / 5; // NOLINT
+        }
+        palette[6][0] = 0;   // NOLINT
+        palette[7][0] = 255; // NOLINT
+    }
+
+    return palette;
+}
+
+auto encode_alpha(block_pixels const& block, unsigned char* const out) noexcept -> void
+{
+    int a0 = 0;
+    int a1 = 255; // NOLINT
+    for(auto const& p : block) {
+        a0 = std::max(a0, p[3]);
+        a1 = std::min(a1, p[3]);
+    }
+
+    std::uint64_t indices = 0;
+
+    // Equal endpoints pick the six value mode, where index 0 is still a0
+    if(a0 != a1) {
+        auto const palette = alpha_palette(a0, a1);
+
+        for(std::size_t i = 0; i < block_pixel_count; ++i) {
+            std::array<int, 4> const alpha{ block[i][3], 0, 0, 0 };
+            indices |= static_cast<std::uint64_t>(nearest<1>(palette, alpha).first) << (3 * i);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(a0);
+    out[1] = static_cast<unsigned char>(a1);
+    write_le(out + 2, indices, 6); // NOLINT
+}
+
+auto decode_alpha(unsigned char const* const in, block_pixels& out) noexcept -> void
+{
+    auto const palette = alpha_palette(in[0], in[1]); // NOLINT
+    std::uint64_t const indices = read_le(in + 2, 6); // NOLINT
+
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        out[i][3] = palette[(indices >> (3 * i)) & 0x7U][0];
+    }
+}
+
+//
+// BC7 mode 6
+//
+
+constexpr std::array<int, 16> bc7_weights{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+constexpr int bc7_mode = 6;
+
+///
+/// Endpoint stored as 7 bits per channel plus a shared lowest bit.
+///
+struct bc7_endpoint
+{
+    std::array<unsigned int, 4> bits{};
+    unsigned int p = 0;
+
+    [[nodiscard]] auto value(std::size_t const c) const noexcept -> int
+    {
+        return static_cast<int>((bits[c] << 1U) | p);
+    }
+};
+
+[[nodiscard]] auto quantize_bc7(vec<4> const& color) noexcept -> bc7_endpoint
+{
+    bc7_endpoint best{};
+    float best_error = std::numeric_limits<float>::max();
+
+    for(unsigned int p = 0; p < 2; ++p) {
+        bc7_endpoint candidate{};
+        candidate.p = p;
+        float error = 0.0F;
+
+        for(std::size_t c = 0; c < 4; ++c) {
+            long const q = std::lround((color[c] - static_cast<float>(p)) / 2.0F);
+            candidate.bits[c] = static_cast<unsigned int>(std::clamp(q, 0L, 127L)); // NOLINT
+            float const d = static_cast<float>(candidate.value(c)) - color[c];
+            error += d * d;
+        }
+
+        if(error < best_error) {
+            best = candidate;
+            best_error = error;
+        }
+    }
+
+    return best;
+}
+
+[[nodiscard]] auto bc7_palette(bc7_endpoint const& e0, bc7_endpoint const& e1) noexcept
+    -> std::array<std::array<int, 4>, 16>
+{
+    std::array<std::array<int, 4>, 16> palette{};
+
+    for(std::size_t i = 0; i < palette.size(); ++i) {
+        int const w = bc7_weights[i];
+        for(std::size_t c = 0; c < 4; ++c) {
+            palette[i][c] = ((64 - w) * e0.value(c) + w * e1.value(c) + 32) >> 6; // NOLINT
+        }
+    }
+
+    return palette;
+}
+
+struct bc7_candidate
+{
+    bc7_endpoint e0{};
+    bc7_endpoint e1{};
+    std::array<int, block_pixel_count> indices{};
+    int error = std::numeric_limits<int>::max();
+};
+
+[[nodiscard]] auto evaluate_bc7(block_pixels const& block, vec<4> const& low, vec<4> const& high) noexcept
+    -> bc7_candidate
+{
+    bc7_candidate result{ quantize_bc7(low), quantize_bc7(high), {}, 0 };
+
+    auto const palette = bc7_palette(result.e0, result.e1);
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        auto const [index, error] = nearest<4>(palette, block[i]);
+        result.indices[i] = index;
+        result.error += error;
+    }
+
+    return result;
+}
+
+///
+/// Writes 128 bits from the lowest one up.
+///
+class bit_writer
+{
+private:
+    unsigned char* m_out;
+    std::size_t m_position = 0;
+
+public:
+    explicit bit_writer(unsigned char* const out) noexcept
+        : m_out{ out }
+    {
+        std::fill(out, out + 16, static_cast<unsigned char>(0)); // NOLINT
+    }
+
+    auto write(unsigned int const value, std::size_t const bits) noexcept -> void
+    {
+        for(std::size_t i = 0; i < bits; ++i, ++m_position) {
+            if(((value >> i) & 1U) != 0) {
+                m_out[m_position / 8] |= static_cast<unsigned char>(1U << (m_position % 8)); // NOLINT
+            }
+        }
+    }
+};
+
+class bit_reader
+{
+private:
+    unsigned char const* m_in;
+    std::size_t m_position = 0;
+
+public:
+    explicit bit_reader(unsigned char const* const in) noexcept
+        : m_in{ in }
+    {
+    }
+
+    [[nodiscard]] auto read(std::size_t const bits) noexcept -> unsigned int
+    {
+        unsigned int value = 0;
+        for(std::size_t i = 0; i < bits; ++i, ++m_position) {
+            value |= ((m_in[m_position / 8] >> (m_position % 8)) & 1U) << i; // NOLINT
+        }
+        return value;
+    }
+};
+
+auto encode_bc7(block_pixels const& block, unsigned char* const out) noexcept -> void
+{
+    vec<4> low{};
+    vec<4> high{};
+    fit_principal_axis(block, low, high);
+    bc7_candidate best = evaluate_bc7(block, low, high);
+
+    std::array<float, block_pixel_count> weights{};
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        weights[i] = static_cast<float>(bc7_weights[static_cast<std::size_t>(best.indices[i])]) / 64.0F; // NOLINT
+    }
+
+    if(fit_least_squares(block, weights, low, high)) {
+        if(bc7_candidate refined = evaluate_bc7(block, low, high); refined.error < best.error) {
+            best = refined;
+        }
+    }
+
+    // The first index is stored without its top bit, which must thus be 0
+    constexpr int max_index = 15;
+    if(best.indices[0] > max_index / 2) {
+        std::swap(best.e0, best.e1);
+        for(int& index : best.indices) {
+            index = max_index - index;
+        }
+    }
+
+    bit_writer writer{ out };
+    writer.write(1U << static_cast<unsigned int>(bc7_mode), bc7_mode + 1);
+
+    for(std::size_t c = 0; c < 4; ++c) {
+        writer.write(best.e0.bits[c], 7);
+        writer.write(best.e1.bits[c], 7);
+    }
+
+    writer.write(best.e0.p, 1);
+    writer.write(best.e1.p, 1);
+
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        writer.write(static_cast<unsigned int>(best.indices[i]), i == 0 ? 3 : 4);
+    }
+}
+
+[[nodiscard]] auto decode_bc7(unsigned char const* const in, block_pixels& out) noexcept -> bool
+{
+    bit_reader reader{ in };
+
+    if(reader.read(bc7_mode + 1) != 1U << static_cast<unsigned int>(bc7_mode)) {
+        constexpr std::array<int, 4> magenta{ 255, 0, 255, 255 };
+        out.fill(magenta);
+        return false;
+    }
+
+    bc7_endpoint e0{};
+    bc7_endpoint e1{};
+
+    for(std::size_t c = 0; c < 4; ++c) {
+        e0.bits[c] = reader.read(7);
+        e1.bits[c] = reader.read(7);
+    }
+
+    e0.p = reader.read(1);
+    e1.p = reader.read(1);
+
+    auto const palette = bc7_palette(e0, e1);
+    for(std::size_t i = 0; i < block_pixel_count; ++i) {
+        out[i] = palette[reader.read(i == 0 ? 3 : 4)];
+    }
+
+    return true;
+}
+
+[[nodiscard]] auto blocks_across(int const size) noexcept -> int
+{
+    return (size + block_dim - 1) / block_dim;
+}
+
+} // namespace
+
+auto block_size(block_format const format) noexcept -> std::size_t
+{
+    return format == block_format::bc1 ? 8 : 16; // NOLINT
+}
+
+auto compressed_size(block_format const format, int const width, int const height) noexcept -> std::size_t
+{
+    return static_cast<std::size_t>(blocks_across(width)) * static_cast<std::size_t>(blocks_across(height)) *
+           block_size(format);
+}
+
+auto block_internal_format(block_format const format) noexcept -> unsigned int
+{
+    switch(format) {
+    case block_format::bc1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case block_format::bc3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case block_format::bc7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+
+    return 0;
+}
+
+auto block_format_of(unsigned int const internal_format) noexcept -> std::optional<block_format>
+{
+    switch(internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return block_format::bc1;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return block_format::bc3;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return block_format::bc7;
+    default:
+        return std::nullopt;
+    }
+}
+
+auto block_format_supported(block_format const format) noexcept -> bool
+{
+    if(format == block_format::bc7) {
+        return GLAD_GL_VERSION_4_2 != 0 || GLAD_GL_ARB_texture_compression_bptc != 0;
+    }
+
+    return GLAD_GL_EXT_texture_compression_s3tc != 0;
+}
+
+auto compress_blocks(block_format const format,
+                     unsigned char const* const pixels,
+                     int const width,
+                     int const height,
+                     int const channels) -> std::vector<unsigned char>
+{
+    std::vector<unsigned char> result(compressed_size(format, width, height));
+    std::size_t const size = block_size(format);
+    unsigned char* out = result.data();
+
+    for(int y = 0; y < blocks_across(height); ++y) {
+        for(int x = 0; x < blocks_across(width); ++x, out += size) { // NOLINT
+            block_pixels const block = gather_block(pixels, width, height, channels, x, y);
+
+            switch(format) {
+            case block_format::bc1:
+                encode_bc1(block, out);
+                break;
+            case block_format::bc3:
+                encode_alpha(block, out);
+                encode_bc1(block, out + 8); // NOLINT
+                break;
+            case block_format::bc7:
+                encode_bc7(block, out);
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+auto decompress_blocks(block_format const format,
+                       unsigned char const* blocks,
+                       int const width,
+                       int const height,
+                       std::vector<unsigned char>& rgba) -> bool
+{
+    rgba.resize(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+    std::size_t const size = block_size(format);
+    bool ok = true;
+
+    for(int y = 0; y < blocks_across(height); ++y) {
+        for(int x = 0; x < blocks_across(width); ++x, blocks += size) { // NOLINT
+            block_pixels block{};
+
+            switch(format) {
+            case block_format::bc1:
+                decode_bc1(blocks, false, block);
+                break;
+            case block_format::bc3:
+                decode_bc1(blocks + 8, true, block); // NOLINT
+                decode_alpha(blocks, block);
+                break;
+            case block_format::bc7:
+                ok = decode_bc7(blocks, block) && ok;
+                break;
+            }
+
+            for(int py = 0; py < block_dim && y * block_dim + py < height; ++py) {
+                for(int px = 0; px < block_dim && x * block_dim + px < width; ++px) {
+                    auto const& p = block[static_cast<std::size_t>(py * block_dim + px)];
+                    auto const offset = (static_cast<std::size_t>(y * block_dim + py) * static_cast<std::size_t>(width) +
+                                         static_cast<std::size_t>(x * block_dim + px)) *
+                                        4;
+
+                    for(std::size_t c = 0; c < 4; ++c) {
+                        rgba[offset + c] = static_cast<unsigned char>(p[c]);
+                    }
+                }
+            }
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,274 @@
+#include "util/buffer_arena.hpp"
+#include "util/gl_state.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+auto range_allocator::statistics::fragmentation() const noexcept -> double
+{
+    std::size_t const free = capacity - used;
+    return free == 0 ? 0.0 : 1.0 - static_cast<double>(largest_free) / static_cast<double>(free);
+}
+
+range_allocator::range_allocator(std::size_t const capacity)
+    : m_capacity{ capacity }
+    , m_used{ 0 }
+    , m_allocations{ 0 }
+{
+    if(capacity > 0) {
+        this->insert_free(0, capacity);
+    }
+}
+
+auto range_allocator::insert_free(std::size_t const offset, std::size_t const size) -> void
+{
+    m_by_offset.emplace(offset, size);
+    m_by_size.emplace(size, offset);
+}
+
+auto range_allocator::erase_free(std::map<std::size_t, std::size_t>::iterator const it) -> void
+{
+    m_by_size.erase({ it->second, it->first });
+    m_by_offset.erase(it);
+}
+
+auto range_allocator::allocate(std::size_t const size) -> std::size_t
+{
+    if(size == 0) {
+        return npos;
+    }
+
+    auto const best = m_by_size.lower_bound({ size, 0 });
+
+    if(best == m_by_size.end()) {
+        return npos;
+    }
+
+    auto const [block_size, offset] = *best;
+    this->erase_free(m_by_offset.find(offset));
+
+    if(block_size > size) {
+        this->insert_free(offset + size, block_size - size);
+    }
+
+    m_used += size;
+    ++m_allocations;
+    return offset;
+}
+
+auto range_allocator::free(std::size_t offset, std::size_t size) -> void
+{
+    if(offset == npos || size == 0) {
+        return;
+    }
+
+    m_used -= size;
+    --m_allocations;
+
+    auto next = m_by_offset.lower_bound(offset);
+
+    if(next != m_by_offset.end() && offset + size == next->first) {
+        size += next->second;
+        this->erase_free(next);
+        next = m_by_offset.lower_bound(offset);
+    }
+
+    if(next != m_by_offset.begin()) {
+        auto const previous = std::prev(next);
+
+        if(previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            this->erase_free(previous);
+        }
+    }
+
+    this->insert_free(offset, size);
+}
+
+auto range_allocator::stats() const noexcept -> statistics
+{
+    statistics result{};
+    result.capacity = m_capacity;
+    result.used = m_used;
+    result.allocations = m_allocations;
+    result.free_blocks = m_by_offset.size();
+    result.largest_free = m_by_size.empty() ? 0 : m_by_size.rbegin()->first;
+    return result;
+}
+
+buffer_arena::buffer_arena(std::size_t const vertex_stride,
+                           std::size_t const max_vertices,
+                           std::size_t const max_indices,
+                           unsigned int const index_type)
+    : m_vertex_buffer{ 0 }
+    , m_index_buffer{ 0 }
+    , m_vertex_stride{ vertex_stride }
+    , m_index_type{ index_type }
+    , m_index_size{ index_type == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t) }
+    , m_vertices{ max_vertices }
+    , m_indices{ max_indices }
+{
+    glGenBuffers(1, &m_vertex_buffer);
+    gl_state::current().bind_buffer(GL_COPY_WRITE_BUFFER, m_vertex_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(max_vertices * vertex_stride), nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &m_index_buffer);
+    gl_state::current().bind_buffer(GL_COPY_WRITE_BUFFER, m_index_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(max_indices * m_index_size), nullptr, GL_STATIC_DRAW);
+
+    // The element array binding is part of the vertex array
+    m_vao.bind();
+    gl_state::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+    vertex_array::unbind();
+}
+
+buffer_arena::~buffer_arena() noexcept
+{
+    for(unsigned int const buffer : { m_vertex_buffer, m_index_buffer }) {
+        gl_state::current().forget_buffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+auto buffer_arena::upload(std::size_t const offset, std::size_t const size, void const* const data, unsigned int buffer)
+    noexcept -> void
+{
+    // Not GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER, which would change
+    // whatever vertex array happens to be bound
+    gl_state::current().bind_buffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+auto buffer_arena::add(void const* const vertices,
+                       std::size_t const vertex_count,
+                       std::vector<std::uint32_t> const& indices) -> mesh_range
+{
+    constexpr std::size_t short_vertices = std::size_t{ std::numeric_limits<std::uint16_t>::max() } + 1;
+
+    // The allocators have no empty ranges to give, and there'd be nothing to draw
+    if(vertex_count == 0 || indices.empty()) {
+        spdlog::error("[Buffer Arena] Empty mesh with {} vertices and {} indices!", vertex_count, indices.size());
+        return mesh_range{};
+    }
+
+    if(m_index_type == GL_UNSIGNED_SHORT && vertex_count > short_vertices) {
+        spdlog::error("[Buffer Arena] {} vertices are too many for 16 bit indices!", vertex_count);
+        return mesh_range{};
+    }
+
+    if(std::any_of(indices.begin(), indices.end(), [vertex_count](auto const i) { return i >= vertex_count; })) {
+        spdlog::error("[Buffer Arena] Mesh has indices past its {} vertices!", vertex_count);
+        return mesh_range{};
+    }
+
+    mesh_range range{};
+    range.vertex_count = vertex_count;
+    range.index_count = indices.size();
+    range.first_vertex = m_vertices.allocate(vertex_count);
+    range.first_index = m_indices.allocate(indices.size());
+
+    if(!range.valid()) {
+        spdlog::error("[Buffer Arena] No room for {} vertices and {} indices!", vertex_count, indices.size());
+        this->remove(range);
+        return mesh_range{};
+    }
+
+    this->upload(range.first_vertex * m_vertex_stride, vertex_count * m_vertex_stride, vertices, m_vertex_buffer);
+
+    if(m_index_type == GL_UNSIGNED_SHORT) {
+        std::vector<std::uint16_t> const narrow(indices.begin(), indices.end());
+        this->upload(range.first_index * m_index_size, narrow.size() * m_index_size, narrow.data(), m_index_buffer);
+    }
+    else {
+        this->upload(range.first_index * m_index_size, indices.size() * m_index_size, indices.data(), m_index_buffer);
+    }
+
+    return range;
+}
+
+auto buffer_arena::remove(mesh_range const& range) -> void
+{
+    m_vertices.free(range.first_vertex, range.vertex_count);
+    m_indices.free(range.first_index, range.index_count);
+}
+
+auto buffer_arena::draw(std::vector<mesh_range> const& ranges) -> void
+{
+    m_counts.clear();
+    m_offsets.clear();
+    m_base_vertices.clear();
+
+    for(mesh_range const& range : ranges) {
+        if(!range.valid()) {
+            continue;
+        }
+
+        m_counts.push_back(static_cast<int>(range.index_count));
+        m_offsets.push_back(reinterpret_cast<void const*>(range.first_index * m_index_size)); // NOLINT
+        m_base_vertices.push_back(static_cast<int>(range.first_vertex));
+    }
+
+    if(m_counts.empty()) {
+        return;
+    }
+
+    m_vao.bind();
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES,
+                                  m_counts.data(),
+                                  m_index_type,
+                                  m_offsets.data(),
+                                  static_cast<GLsizei>(m_counts.size()),
+                                  m_base_vertices.data());
+}
+
+auto buffer_arena::draw(mesh_range const& range, std::size_t const instances) const noexcept -> void
+{
+    if(!range.valid() || instances == 0) {
+        return;
+    }
+
+    m_vao.bind();
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                                      static_cast<GLsizei>(range.index_count),
+                                      m_index_type,
+                                      reinterpret_cast<void const*>(range.first_index * m_index_size), // NOLINT
+                                      static_cast<GLsizei>(instances),
+                                      static_cast<GLint>(range.first_vertex));
+}
+
+auto buffer_arena::stats() const noexcept -> statistics
+{
+    return statistics{ m_vertices.stats(), m_indices.stats() };
+}
+
+auto buffer_arena::report(std::string const& name) const -> void
+{
+    auto const log = [&name](char const* what, range_allocator::statistics const& s) {
+        spdlog::info("[Buffer Arena] {} {}: {} of {} used by {} mesh(es), {} free block(s), largest {}, "
+                     "{:.0f}% fragmented",
+                     name,
+                     what,
+                     s.used,
+                     s.capacity,
+                     s.allocations,
+                     s.free_blocks,
+                     s.largest_free,
+                     100.0 * s.fragmentation());
+    };
+
+    log("vertices", m_vertices.stats());
+    log("indices", m_indices.stats());
+}
+
+auto buffer_arena::vao() const noexcept -> vertex_array const&
+{
+    return m_vao;
+}
+
+auto buffer_arena::vertex_buffer() const noexcept -> unsigned int
+{
+    return m_vertex_buffer;
+}
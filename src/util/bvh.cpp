@@ -0,0 +1,425 @@
+#include "util/bvh.hpp"
+#include "util/frustum.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace {
+
+constexpr unsigned int all_planes = (1U << frustum::count) - 1U;
+
+auto grow(aabb& box, glm::vec3 const& min, glm::vec3 const& max) noexcept -> void
+{
+    box.min = glm::vec3{ std::fmin(box.min.x, min.x), std::fmin(box.min.y, min.y), std::fmin(box.min.z, min.z) };
+    box.max = glm::vec3{ std::fmax(box.max.x, max.x), std::fmax(box.max.y, max.y), std::fmax(box.max.z, max.z) };
+}
+
+[[nodiscard]] auto empty_box() noexcept -> aabb
+{
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    return aabb{ glm::vec3{ inf }, glm::vec3{ -inf } };
+}
+
+///
+/// Half the surface area, enough to compare costs.
+///
+[[nodiscard]] auto half_area(aabb const& box) noexcept -> float
+{
+    glm::vec3 const e = box.max - box.min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+enum class plane_side
+{
+    outside,
+    intersects,
+    inside
+};
+
+[[nodiscard]] auto classify(glm::vec4 const& plane, glm::vec3 const& min, glm::vec3 const& max) noexcept -> plane_side
+{
+    glm::vec3 const center = (min + max) * 0.5F;
+    glm::vec3 const extents = (max - min) * 0.5F;
+
+    float const distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+    float const radius =
+        std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+
+    if(distance + radius < 0.0F) {
+        return plane_side::outside;
+    }
+    if(distance - radius >= 0.0F) {
+        return plane_side::inside;
+    }
+    return plane_side::intersects;
+}
+
+///
+/// Entry distance of the ray into the box, or infinity if it misses within
+/// `[0, max_distance]`.
+///
+[[nodiscard]] auto entry_distance(glm::vec3 const& origin,
+                                  glm::vec3 const& inverse_direction,
+                                  glm::vec3 const& min,
+                                  glm::vec3 const& max,
+                                  float const max_distance) noexcept -> float
+{
+    float t_min = 0.0F;
+    float t_max = max_distance;
+
+    for(int axis = 0; axis < 3; ++axis) {
+        float const t1 = (min[axis] - origin[axis]) * inverse_direction[axis];
+        float const t2 = (max[axis] - origin[axis]) * inverse_direction[axis];
+
+        // fmin/fmax drop the NaN of a ray lying exactly on an axis aligned face
+        t_min = std::fmax(t_min, std::fmin(t1, t2));
+        t_max = std::fmin(t_max, std::fmax(t1, t2));
+    }
+
+    return t_min <= t_max ? t_min : std::numeric_limits<float>::infinity();
+}
+
+} // namespace
+
+auto aabb::around(glm::vec3 const& center, float const radius) noexcept -> aabb
+{
+    return aabb{ center - glm::vec3{ radius }, center + glm::vec3{ radius } };
+}
+
+auto bvh::build(std::vector<aabb> boxes) -> void
+{
+    m_boxes = std::move(boxes);
+    m_nodes.clear();
+    m_items.resize(m_boxes.size());
+
+    m_volumes.clear();
+    m_volumes.reserve(m_boxes.size());
+    for(auto const& box : m_boxes) {
+        m_volumes.add_aabb(box.min, box.max);
+    }
+
+    for(std::size_t i = 0; i < m_items.size(); ++i) {
+        m_items[i] = static_cast<std::uint32_t>(i);
+    }
+
+    if(m_boxes.empty()) {
+        return;
+    }
+
+    std::vector<glm::vec3> centroids{};
+    centroids.reserve(m_boxes.size());
+    for(auto const& box : m_boxes) {
+        centroids.push_back((box.min + box.max) * 0.5F);
+    }
+
+    // A binary tree with at least one item per leaf has fewer than 2n nodes
+    m_nodes.reserve(2 * m_boxes.size());
+    this->build_node(centroids, 0, static_cast<std::uint32_t>(m_boxes.size()));
+}
+
+auto bvh::build(std::vector<glm::vec3> const& centers, float const radius) -> void
+{
+    std::vector<aabb> boxes{};
+    boxes.reserve(centers.size());
+
+    for(auto const& center : centers) {
+        boxes.push_back(aabb::around(center, radius));
+    }
+
+    this->build(std::move(boxes));
+}
+
+auto bvh::build_node(std::vector<glm::vec3> const& centroids, std::uint32_t const first, std::uint32_t const count)
+    -> std::uint32_t
+{
+    auto const index = static_cast<std::uint32_t>(m_nodes.size());
+
+    aabb bounds = empty_box();
+    aabb centroid_bounds = empty_box();
+    for(std::uint32_t i = first; i < first + count; ++i) {
+        aabb const& box = m_boxes[m_items[i]];
+        grow(bounds, box.min, box.max);
+        grow(centroid_bounds, centroids[m_items[i]], centroids[m_items[i]]);
+    }
+
+    m_nodes.push_back(node{ bounds.min, first, bounds.max, count, 0 });
+
+    if(count <= max_leaf_items) {
+        return index;
+    }
+
+    glm::vec3 const extent = centroid_bounds.max - centroid_bounds.min;
+    int axis = 0;
+    if(extent.y > extent[axis]) {
+        axis = 1;
+    }
+    if(extent.z > extent[axis]) {
+        axis = 2;
+    }
+
+    auto* const items_begin = m_items.data() + first;
+    auto* const items_end = items_begin + count;
+    std::uint32_t left_count = count / 2;
+
+    if(extent[axis] > 0.0F) {
+        // Binned SAH: sort centroids into buckets, then pick the bucket
+        // boundary minimizing area * count on both sides
+        constexpr int num_bins = 12;
+        struct bin
+        {
+            aabb bounds = empty_box();
+            std::uint32_t count = 0;
+        };
+        std::array<bin, num_bins> bins{};
+
+        float const origin = centroid_bounds.min[axis];
+        float const scale = static_cast<float>(num_bins) / extent[axis];
+        auto const bin_of = [&](std::uint32_t const item) {
+            return std::min(num_bins - 1, static_cast<int>((centroids[item][axis] - origin) * scale));
+        };
+
+        for(auto const* it = items_begin; it != items_end; ++it) {
+            bin& b = bins[static_cast<std::size_t>(bin_of(*it))];
+            grow(b.bounds, m_boxes[*it].min, m_boxes[*it].max);
+            ++b.count;
+        }
+
+        std::array<float, num_bins - 1> left_cost{};
+        aabb left_bounds = empty_box();
+        std::uint32_t left_items = 0;
+        for(std::size_t i = 0; i + 1 < num_bins; ++i) {
+            grow(left_bounds, bins[i].bounds.min, bins[i].bounds.max);
+            left_items += bins[i].count;
+            left_cost[i] = left_items == 0 ? 0.0F : half_area(left_bounds) * static_cast<float>(left_items);
+        }
+
+        float best_cost = std::numeric_limits<float>::infinity();
+        int best_split = 1;
+        aabb right_bounds = empty_box();
+        std::uint32_t right_items = 0;
+        for(int split = num_bins - 1; split > 0; --split) {
+            auto const i = static_cast<std::size_t>(split);
+            grow(right_bounds, bins[i].bounds.min, bins[i].bounds.max);
+            right_items += bins[i].count;
+
+            float const cost = left_cost[i - 1] + half_area(right_bounds) * static_cast<float>(right_items);
+            if(cost < best_cost) {
+                best_cost = cost;
+                best_split = split;
+            }
+        }
+
+        auto const* const middle = std::partition(
+            items_begin, items_end, [&](std::uint32_t const item) { return bin_of(item) < best_split; });
+        left_count = static_cast<std::uint32_t>(middle - items_begin);
+    }
+
+    if(left_count == 0 || left_count == count) {
+        // Every centroid in one spot or one bucket, split the range in half
+        left_count = count / 2;
+        std::nth_element(items_begin, items_begin + left_count, items_end, [&](std::uint32_t a, std::uint32_t b) {
+            return centroids[a][axis] < centroids[b][axis];
+        });
+    }
+
+    this->build_node(centroids, first, left_count);
+    std::uint32_t const right = this->build_node(centroids, first + left_count, count - left_count);
+    m_nodes[index].right = right;
+
+    return index;
+}
+
+auto bvh::fit_node(node& n) const noexcept -> void
+{
+    aabb bounds = empty_box();
+
+    if(n.right == 0) {
+        for(std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+            grow(bounds, m_boxes[m_items[i]].min, m_boxes[m_items[i]].max);
+        }
+    }
+    else {
+        auto const left = static_cast<std::size_t>(&n - m_nodes.data()) + 1;
+        grow(bounds, m_nodes[left].min, m_nodes[left].max);
+        grow(bounds, m_nodes[n.right].min, m_nodes[n.right].max);
+    }
+
+    n.min = bounds.min;
+    n.max = bounds.max;
+}
+
+auto bvh::update(std::size_t const item, aabb const& box) noexcept -> void
+{
+    m_boxes[item] = box;
+    m_volumes.set_aabb(item, box.min, box.max);
+}
+
+auto bvh::refit() noexcept -> void
+{
+    // Children always come after their parent
+    for(auto it = m_nodes.rbegin(); it != m_nodes.rend(); ++it) {
+        this->fit_node(*it);
+    }
+}
+
+auto bvh::size() const noexcept -> std::size_t
+{
+    return m_boxes.size();
+}
+
+auto bvh::nodes() const noexcept -> std::vector<node> const&
+{
+    return m_nodes;
+}
+
+auto bvh::query(frustum const& f, std::vector<std::uint32_t>& visible) -> std::size_t
+{
+    visible.clear();
+    m_candidates.clear();
+    m_stats = stats{};
+
+    if(m_nodes.empty()) {
+        return 0;
+    }
+
+    // Planes a node is entirely inside of are dropped for its whole subtree
+    struct entry
+    {
+        std::uint32_t node;
+        unsigned int planes;
+    };
+
+    std::vector<entry> stack{};
+    stack.push_back(entry{ 0, all_planes });
+
+    auto const outside = [&f](glm::vec3 const& min, glm::vec3 const& max, unsigned int& planes) {
+        for(std::size_t p = 0; p < frustum::count; ++p) {
+            if((planes & (1U << p)) == 0) {
+                continue;
+            }
+
+            plane_side const side = classify(f.planes[p], min, max);
+            if(side == plane_side::outside) {
+                return true;
+            }
+            if(side == plane_side::inside) {
+                planes &= ~(1U << p);
+            }
+        }
+
+        return false;
+    };
+
+    while(!stack.empty()) {
+        entry e = stack.back();
+        stack.pop_back();
+
+        node const& n = m_nodes[e.node];
+        ++m_stats.nodes_visited;
+
+        if(outside(n.min, n.max, e.planes)) {
+            continue;
+        }
+
+        if(e.planes == 0) {
+            visible.insert(visible.end(), m_items.begin() + n.first, m_items.begin() + n.first + n.count);
+            continue;
+        }
+
+        // Leaves are too small to fill a vector on their own, their items get
+        // tested together once the traversal is done
+        if(n.right == 0) {
+            m_candidates.insert(m_candidates.end(), m_items.begin() + n.first, m_items.begin() + n.first + n.count);
+            continue;
+        }
+
+        stack.push_back(entry{ n.right, e.planes });
+        stack.push_back(entry{ e.node + 1, e.planes });
+    }
+
+    m_stats.items_tested = m_candidates.size();
+    m_volumes.cull(f, m_candidates, visible);
+
+    return visible.size();
+}
+
+auto bvh::raycast(glm::vec3 const& origin, glm::vec3 const& direction, float const max_distance)
+    -> std::optional<ray_hit>
+{
+    m_stats = stats{};
+
+    if(m_nodes.empty()) {
+        return std::nullopt;
+    }
+
+    glm::vec3 const inverse_direction{ 1.0F / direction.x, 1.0F / direction.y, 1.0F / direction.z };
+    constexpr float miss = std::numeric_limits<float>::infinity();
+
+    std::optional<ray_hit> best{};
+    float best_distance = max_distance;
+
+    std::vector<std::pair<std::uint32_t, float>> stack{};
+    float const root_distance = entry_distance(origin, inverse_direction, m_nodes[0].min, m_nodes[0].max, max_distance);
+    if(root_distance != miss) {
+        stack.emplace_back(0, root_distance);
+    }
+
+    while(!stack.empty()) {
+        auto const [index, distance] = stack.back();
+        stack.pop_back();
+
+        // Something nearer got hit since this node was pushed
+        if(distance > best_distance) {
+            continue;
+        }
+
+        node const& n = m_nodes[index];
+        ++m_stats.nodes_visited;
+
+        if(n.right == 0) {
+            for(std::uint32_t i = n.first; i < n.first + n.count; ++i) {
+                ++m_stats.items_tested;
+
+                aabb const& box = m_boxes[m_items[i]];
+                float const t = entry_distance(origin, inverse_direction, box.min, box.max, best_distance);
+                if(t != miss && (!best.has_value() || t < best_distance)) {
+                    best = ray_hit{ m_items[i], t };
+                    best_distance = t;
+                }
+            }
+            continue;
+        }
+
+        std::uint32_t const left = index + 1;
+        float const left_distance =
+            entry_distance(origin, inverse_direction, m_nodes[left].min, m_nodes[left].max, best_distance);
+        float const right_distance =
+            entry_distance(origin, inverse_direction, m_nodes[n.right].min, m_nodes[n.right].max, best_distance);
+
+        // Nearer child on top, so it's visited first and prunes the other one
+        if(left_distance <= right_distance) {
+            if(right_distance != miss) {
+                stack.emplace_back(n.right, right_distance);
+            }
+            if(left_distance != miss) {
+                stack.emplace_back(left, left_distance);
+            }
+        }
+        else {
+            if(left_distance != miss) {
+                stack.emplace_back(left, left_distance);
+            }
+            stack.emplace_back(n.right, right_distance);
+        }
+    }
+
+    return best;
+}
+
+auto bvh::last_stats() const noexcept -> stats
+{
+    return m_stats;
+}
@@ -0,0 +1,52 @@
+#include "util/frame_constants.hpp"
+#include "util/gl_state.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+[[nodiscard]] auto uniform_offset_alignment() noexcept -> std::size_t
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return static_cast<std::size_t>(std::max(alignment, 1));
+}
+
+} // namespace
+
+frame_constants_buffer::frame_constants_buffer()
+    : m_ring{ GL_UNIFORM_BUFFER, sizeof(frame_constants) + uniform_offset_alignment() }
+    , m_alignment{ uniform_offset_alignment() }
+{
+    // Something valid is bound before the first real update
+    this->update(frame_constants{});
+}
+
+auto frame_constants_buffer::update(frame_constants const& constants) noexcept -> void
+{
+    frame_constants data = constants;
+    data.view_projection = constants.projection * constants.view;
+
+    m_ring.begin_frame();
+    ring_buffer::allocation const slot = m_ring.allocate(sizeof(frame_constants), m_alignment);
+
+    if(!slot.valid()) {
+        spdlog::error("[Frame Constants] Couldn't allocate this frame's constants!");
+        return;
+    }
+
+    std::memcpy(slot.data, &data, sizeof(frame_constants));
+    m_ring.flush();
+
+    gl_state::current().bind_buffer_range(
+        GL_UNIFORM_BUFFER, frame_constants_binding, m_ring.id(), slot.offset, sizeof(frame_constants));
+}
+
+auto frame_constants_buffer::id() const noexcept -> unsigned int
+{
+    return m_ring.id();
+}
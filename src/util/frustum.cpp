@@ -0,0 +1,320 @@
+#include "util/frustum.hpp"
+
+#include "simd.hpp"
+
+#include <array>
+#include <cmath>
+
+namespace {
+
+[[nodiscard]] auto row(glm::mat4 const& m, int const i) noexcept -> glm::vec4
+{
+    return glm::vec4{ m[0][i], m[1][i], m[2][i], m[3][i] };
+}
+
+[[nodiscard]] auto normalize_plane(glm::vec4 const& plane) noexcept -> glm::vec4
+{
+    float const length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    return length > 0.0F ? plane / length : plane;
+}
+
+///
+/// Signed distance of the volume's farthest point along the plane normal,
+/// negative when the whole volume is outside.
+///
+[[nodiscard]] auto reach(glm::vec4 const& plane,
+                         float const cx,
+                         float const cy,
+                         float const cz,
+                         float const ex,
+                         float const ey,
+                         float const ez,
+                         float const radius) noexcept -> float
+{
+    float const distance = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+    float const extent = std::fabs(plane.x) * ex + std::fabs(plane.y) * ey + std::fabs(plane.z) * ez;
+    return distance + extent + radius;
+}
+
+#if defined(UTIL_SIMD)
+
+///
+/// Bits of the lanes whose volume is entirely outside one of the planes.
+///
+[[nodiscard]] auto outside_lanes(frustum const& f,
+                                 simd::simd_float const cx,
+                                 simd::simd_float const cy,
+                                 simd::simd_float const cz,
+                                 simd::simd_float const ex,
+                                 simd::simd_float const ey,
+                                 simd::simd_float const ez,
+                                 simd::simd_float const radius) noexcept -> unsigned int
+{
+    using simd::simd_float;
+
+    simd_float const zero = simd_float::set(0.0F);
+    simd_float outside = less(zero, zero);
+
+    for(auto const& plane : f.planes) {
+        simd_float const distance = simd_float::set(plane.x) * cx + simd_float::set(plane.y) * cy +
+                                    simd_float::set(plane.z) * cz + simd_float::set(plane.w);
+        simd_float const extent = simd_float::set(std::fabs(plane.x)) * ex + simd_float::set(std::fabs(plane.y)) * ey +
+                                  simd_float::set(std::fabs(plane.z)) * ez;
+
+        outside = mask_or(outside, less(distance + extent + radius, zero));
+    }
+
+    return mask_bits(outside);
+}
+
+#endif
+
+} // namespace
+
+auto frustum::from_matrix(glm::mat4 const& view_projection) noexcept -> frustum
+{
+    glm::vec4 const x = row(view_projection, 0);
+    glm::vec4 const y = row(view_projection, 1);
+    glm::vec4 const z = row(view_projection, 2);
+    glm::vec4 const w = row(view_projection, 3);
+
+    frustum result{};
+    result.planes[left] = normalize_plane(w + x);
+    result.planes[right] = normalize_plane(w - x);
+    result.planes[bottom] = normalize_plane(w + y);
+    result.planes[top] = normalize_plane(w - y);
+    result.planes[z_near] = normalize_plane(w + z);
+    result.planes[z_far] = normalize_plane(w - z);
+    return result;
+}
+
+auto frustum::intersects_sphere(glm::vec3 const& center, float const radius) const noexcept -> bool
+{
+    for(auto const& plane : planes) {
+        if(reach(plane, center.x, center.y, center.z, 0.0F, 0.0F, 0.0F, radius) < 0.0F) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto frustum::intersects_aabb(glm::vec3 const& min, glm::vec3 const& max) const noexcept -> bool
+{
+    glm::vec3 const center = (min + max) * 0.5F;
+    glm::vec3 const extents = (max - min) * 0.5F;
+
+    for(auto const& plane : planes) {
+        if(reach(plane, center.x, center.y, center.z, extents.x, extents.y, extents.z, 0.0F) < 0.0F) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto frustum_culler::reserve(std::size_t const count) -> void
+{
+    for(auto* v : { &m_cx, &m_cy, &m_cz, &m_ex, &m_ey, &m_ez, &m_radius }) {
+        v->reserve(count);
+    }
+}
+
+auto frustum_culler::clear() noexcept -> void
+{
+    for(auto* v : { &m_cx, &m_cy, &m_cz, &m_ex, &m_ey, &m_ez, &m_radius }) {
+        v->clear();
+    }
+}
+
+auto frustum_culler::add_sphere(glm::vec3 const& center, float const radius) -> void
+{
+    m_cx.push_back(center.x);
+    m_cy.push_back(center.y);
+    m_cz.push_back(center.z);
+    m_ex.push_back(0.0F);
+    m_ey.push_back(0.0F);
+    m_ez.push_back(0.0F);
+    m_radius.push_back(radius);
+}
+
+auto frustum_culler::add_aabb(glm::vec3 const& min, glm::vec3 const& max) -> void
+{
+    glm::vec3 const center = (min + max) * 0.5F;
+    glm::vec3 const extents = (max - min) * 0.5F;
+
+    m_cx.push_back(center.x);
+    m_cy.push_back(center.y);
+    m_cz.push_back(center.z);
+    m_ex.push_back(extents.x);
+    m_ey.push_back(extents.y);
+    m_ez.push_back(extents.z);
+    m_radius.push_back(0.0F);
+}
+
+auto frustum_culler::set_center(std::size_t const index, glm::vec3 const& center) noexcept -> void
+{
+    m_cx[index] = center.x;
+    m_cy[index] = center.y;
+    m_cz[index] = center.z;
+}
+
+auto frustum_culler::set_aabb(std::size_t const index, glm::vec3 const& min, glm::vec3 const& max) noexcept -> void
+{
+    glm::vec3 const center = (min + max) * 0.5F;
+    glm::vec3 const extents = (max - min) * 0.5F;
+
+    m_cx[index] = center.x;
+    m_cy[index] = center.y;
+    m_cz[index] = center.z;
+    m_ex[index] = extents.x;
+    m_ey[index] = extents.y;
+    m_ez[index] = extents.z;
+    m_radius[index] = 0.0F;
+}
+
+auto frustum_culler::size() const noexcept -> std::size_t
+{
+    return m_radius.size();
+}
+
+auto frustum_culler::cull(frustum const& f, std::vector<std::uint32_t>& visible) -> std::size_t
+{
+    std::size_t const n = this->size();
+    visible.resize(n);
+
+    std::size_t num_visible = 0;
+    std::size_t i = 0;
+
+#if defined(UTIL_SIMD)
+    using simd::simd_float;
+    constexpr std::size_t w = simd_float::width;
+    constexpr unsigned int all_lanes = (1U << w) - 1U;
+
+    for(; i + w <= n; i += w) {
+        unsigned int const outside = outside_lanes(f,
+                                                   simd_float::load(m_cx.data() + i),
+                                                   simd_float::load(m_cy.data() + i),
+                                                   simd_float::load(m_cz.data() + i),
+                                                   simd_float::load(m_ex.data() + i),
+                                                   simd_float::load(m_ey.data() + i),
+                                                   simd_float::load(m_ez.data() + i),
+                                                   simd_float::load(m_radius.data() + i));
+
+        // Compact the visible lanes, lowest index first
+        for(unsigned int bits = ~outside & all_lanes; bits != 0; bits &= bits - 1U) {
+            unsigned int lane = 0;
+            while((bits & (1U << lane)) == 0) {
+                ++lane;
+            }
+
+            visible[num_visible++] = static_cast<std::uint32_t>(i + lane);
+        }
+    }
+#endif
+
+    for(; i < n; ++i) {
+        bool inside = true;
+
+        for(auto const& plane : f.planes) {
+            if(reach(plane, m_cx[i], m_cy[i], m_cz[i], m_ex[i], m_ey[i], m_ez[i], m_radius[i]) < 0.0F) {
+                inside = false;
+                break;
+            }
+        }
+
+        if(inside) {
+            visible[num_visible++] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    visible.resize(num_visible);
+    m_stats = stats{ n, num_visible };
+
+    return num_visible;
+}
+
+auto frustum_culler::cull(frustum const& f,
+                          std::vector<std::uint32_t> const& candidates,
+                          std::vector<std::uint32_t>& visible) -> std::size_t
+{
+    std::size_t const n = candidates.size();
+    std::size_t const old_size = visible.size();
+    visible.resize(old_size + n);
+
+    std::size_t num_visible = old_size;
+    std::size_t i = 0;
+
+#if defined(UTIL_SIMD)
+    using simd::simd_float;
+    constexpr std::size_t w = simd_float::width;
+    constexpr unsigned int all_lanes = (1U << w) - 1U;
+
+    // Candidates are scattered, gather them lane by lane before the test
+    std::array<std::array<float, w>, 7> lanes{};
+
+    for(; i + w <= n; i += w) {
+        for(std::size_t lane = 0; lane < w; ++lane) {
+            std::uint32_t const index = candidates[i + lane];
+            lanes[0][lane] = m_cx[index];
+            lanes[1][lane] = m_cy[index];
+            lanes[2][lane] = m_cz[index];
+            lanes[3][lane] = m_ex[index];
+            lanes[4][lane] = m_ey[index];
+            lanes[5][lane] = m_ez[index];
+            lanes[6][lane] = m_radius[index];
+        }
+
+        unsigned int const outside = outside_lanes(f,
+                                                   simd_float::load(lanes[0].data()),
+                                                   simd_float::load(lanes[1].data()),
+                                                   simd_float::load(lanes[2].data()),
+                                                   simd_float::load(lanes[3].data()),
+                                                   simd_float::load(lanes[4].data()),
+                                                   simd_float::load(lanes[5].data()),
+                                                   simd_float::load(lanes[6].data()));
+
+        for(unsigned int bits = ~outside & all_lanes; bits != 0; bits &= bits - 1U) {
+            unsigned int lane = 0;
+            while((bits & (1U << lane)) == 0) {
+                ++lane;
+            }
+
+            visible[num_visible++] = candidates[i + lane];
+        }
+    }
+#endif
+
+    for(; i < n; ++i) {
+        std::uint32_t const index = candidates[i];
+        bool inside = true;
+
+        for(auto const& plane : f.planes) {
+            if(reach(plane,
+                     m_cx[index],
+                     m_cy[index],
+                     m_cz[index],
+                     m_ex[index],
+                     m_ey[index],
+                     m_ez[index],
+                     m_radius[index]) < 0.0F) {
+                inside = false;
+                break;
+            }
+        }
+
+        if(inside) {
+            visible[num_visible++] = index;
+        }
+    }
+
+    visible.resize(num_visible);
+    m_stats = stats{ n, num_visible - old_size };
+
+    return num_visible - old_size;
+}
+
+auto frustum_culler::last_stats() const noexcept -> stats
+{
+    return m_stats;
+}
@@ -0,0 +1,285 @@
+#include "util/gl_state.hpp"
+
+#include <glad/glad.h>
+
+namespace {
+
+constexpr std::size_t untracked = ~std::size_t{ 0 };
+
+[[nodiscard]] auto buffer_index(unsigned int const target) noexcept -> std::size_t
+{
+    switch(target) {
+    case GL_ARRAY_BUFFER:
+        return 0;
+    case GL_ELEMENT_ARRAY_BUFFER:
+        return 1;
+    case GL_UNIFORM_BUFFER:
+        return 2;
+    case GL_PIXEL_UNPACK_BUFFER:
+        return 3;
+    case GL_PIXEL_PACK_BUFFER:
+        return 4;
+    case GL_COPY_READ_BUFFER:
+        return 5;
+    case GL_COPY_WRITE_BUFFER:
+        return 6;
+    case GL_DRAW_INDIRECT_BUFFER:
+        return 7;
+    default:
+        return untracked;
+    }
+}
+
+[[nodiscard]] auto texture_index(unsigned int const target) noexcept -> std::size_t
+{
+    switch(target) {
+    case GL_TEXTURE_2D:
+        return 0;
+    case GL_TEXTURE_2D_ARRAY:
+        return 1;
+    case GL_TEXTURE_3D:
+        return 2;
+    case GL_TEXTURE_CUBE_MAP:
+        return 3;
+    default:
+        return untracked;
+    }
+}
+
+[[nodiscard]] auto capability_index(unsigned int const capability) noexcept -> std::size_t
+{
+    switch(capability) {
+    case GL_DEPTH_TEST:
+        return 0;
+    case GL_BLEND:
+        return 1;
+    case GL_CULL_FACE:
+        return 2;
+    default:
+        return untracked;
+    }
+}
+
+} // namespace
+
+gl_state::gl_state() noexcept
+{
+    this->invalidate();
+}
+
+auto gl_state::current() noexcept -> gl_state&
+{
+    static gl_state state{};
+    return state;
+}
+
+auto gl_state::use_program(unsigned int const program) noexcept -> void
+{
+    if(m_program == program) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    glUseProgram(program);
+    m_program = program;
+    ++m_stats.issued;
+}
+
+auto gl_state::bind_vertex_array(unsigned int const vao) noexcept -> void
+{
+    if(m_vertex_array == vao) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    glBindVertexArray(vao);
+    m_vertex_array = vao;
+    ++m_stats.issued;
+
+    // The element buffer binding is part of the vertex array object
+    m_buffers[buffer_index(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+}
+
+auto gl_state::bind_buffer(unsigned int const target, unsigned int const buffer) noexcept -> void
+{
+    std::size_t const index = buffer_index(target);
+
+    if(index != untracked && m_buffers[index] == buffer) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    glBindBuffer(target, buffer);
+    ++m_stats.issued;
+
+    if(index != untracked) {
+        m_buffers[index] = buffer;
+    }
+}
+
+auto gl_state::bind_buffer_base(unsigned int const target, unsigned int const index, unsigned int const buffer) noexcept
+    -> void
+{
+    // Indexed bindings aren't shadowed, but they also replace the generic binding
+    glBindBufferBase(target, index, buffer);
+    ++m_stats.issued;
+
+    std::size_t const generic = buffer_index(target);
+    if(generic != untracked) {
+        m_buffers[generic] = buffer;
+    }
+}
+
+auto gl_state::bind_buffer_range(unsigned int const target,
+                                 unsigned int const index,
+                                 unsigned int const buffer,
+                                 std::size_t const offset,
+                                 std::size_t const size) noexcept -> void
+{
+    glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+    ++m_stats.issued;
+
+    std::size_t const generic = buffer_index(target);
+    if(generic != untracked) {
+        m_buffers[generic] = buffer;
+    }
+}
+
+auto gl_state::activate_unit(unsigned int const unit) noexcept -> void
+{
+    if(m_active_unit == unit) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    m_active_unit = unit;
+    ++m_stats.issued;
+}
+
+auto gl_state::bind_texture(unsigned int const unit, unsigned int const target, unsigned int const texture) noexcept
+    -> void
+{
+    std::size_t const index = texture_index(target);
+    bool const tracked = index != untracked && unit < max_texture_units;
+
+    if(tracked && m_textures[unit][index] == texture) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    this->activate_unit(unit);
+    glBindTexture(target, texture);
+    ++m_stats.issued;
+
+    if(tracked) {
+        m_textures[unit][index] = texture;
+    }
+}
+
+auto gl_state::bind_sampler(unsigned int const unit, unsigned int const sampler) noexcept -> void
+{
+    bool const tracked = unit < max_texture_units;
+
+    if(tracked && m_samplers[unit] == sampler) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    glBindSampler(unit, sampler);
+    ++m_stats.issued;
+
+    if(tracked) {
+        m_samplers[unit] = sampler;
+    }
+}
+
+auto gl_state::set_enabled(unsigned int const capability, bool const enabled) noexcept -> void
+{
+    std::size_t const index = capability_index(capability);
+    unsigned int const value = enabled ? 1U : 0U;
+
+    if(index != untracked && m_capabilities[index] == value) {
+        ++m_stats.skipped;
+        return;
+    }
+
+    if(enabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+    ++m_stats.issued;
+
+    if(index != untracked) {
+        m_capabilities[index] = value;
+    }
+}
+
+auto gl_state::forget_program(unsigned int const program) noexcept -> void
+{
+    if(m_program == program) {
+        m_program = unknown;
+    }
+}
+
+auto gl_state::forget_vertex_array(unsigned int const vao) noexcept -> void
+{
+    if(m_vertex_array == vao) {
+        m_vertex_array = unknown;
+        m_buffers[buffer_index(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+    }
+}
+
+auto gl_state::forget_buffer(unsigned int const buffer) noexcept -> void
+{
+    for(auto& bound : m_buffers) {
+        if(bound == buffer) {
+            bound = unknown;
+        }
+    }
+}
+
+auto gl_state::forget_texture(unsigned int const texture) noexcept -> void
+{
+    for(auto& unit : m_textures) {
+        for(auto& bound : unit) {
+            if(bound == texture) {
+                bound = unknown;
+            }
+        }
+    }
+}
+
+auto gl_state::invalidate() noexcept -> void
+{
+    m_program = unknown;
+    m_vertex_array = unknown;
+    m_active_unit = unknown;
+    m_buffers.fill(unknown);
+    for(auto& unit : m_textures) {
+        unit.fill(unknown);
+    }
+    m_samplers.fill(unknown);
+    m_capabilities.fill(unknown);
+}
+
+auto gl_state::bound_vertex_array() const noexcept -> std::optional<unsigned int>
+{
+    if(m_vertex_array == unknown) {
+        return std::nullopt;
+    }
+
+    return m_vertex_array;
+}
+
+auto gl_state::stats() const noexcept -> statistics const&
+{
+    return m_stats;
+}
+
+auto gl_state::reset_stats() noexcept -> void
+{
+    m_stats = statistics{};
+}
@@ -0,0 +1,129 @@
+#ifndef UTIL_BAKED_TEXTURE_HPP
+#define UTIL_BAKED_TEXTURE_HPP
+#pragma once
+
+#include "util/block_compression.hpp"
+#include "util/texture.hpp"
+#include "util/texture_cache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+///
+/// Baked texture file (`.btex`), written by the TextureBaker tool:
+///
+///     baked_texture_header
+///     baked_level[levels]      largest level first
+///     pixels of every level    each at a 16 byte aligned offset
+///
+/// Everything is little endian and laid out so a mapped file can be handed to
+/// `glTexStorage2D` / `glTexSubImage2D` as is. Block compressed files (see
+/// `block_compression.hpp`) have a compressed `internal_format`, `format` 0
+/// and levels of 4x4 blocks for `glCompressedTexSubImage2D`.
+///
+struct baked_texture_header
+{
+    static constexpr std::uint32_t file_magic = 0x58455442; // "BTEX"
+    static constexpr std::uint32_t file_version = 2;
+
+    std::uint32_t magic = file_magic;
+    std::uint32_t version = file_version;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t levels = 0;
+    std::uint32_t channels = 0;
+    /// Sized format for `glTexStorage2D`, e.g. `GL_RGBA8`
+    std::uint32_t internal_format = 0;
+    /// Pixel format of the stored levels, e.g. `GL_RGBA`, 0 if compressed
+    std::uint32_t format = 0;
+};
+
+struct baked_level
+{
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+};
+
+static_assert(sizeof(baked_texture_header) == 32, "baked_texture_header has padding!");
+static_assert(sizeof(baked_level) == 24, "baked_level has padding!");
+
+///
+/// Checked view of a baked texture in memory, pointing into the given bytes.
+///
+struct baked_texture_view
+{
+    baked_texture_header const* header = nullptr;
+    baked_level const* levels = nullptr;
+    unsigned char const* data = nullptr;
+};
+
+struct bake_options
+{
+    /// Filter colors in linear light, for color images stored as sRGB. Turn
+    /// off for data such as normal maps.
+    bool srgb = true;
+    /// Block compress every level, stored as 8 bit pixels if empty
+    std::optional<block_format> compression{};
+};
+
+///
+/// Full mip chain of `source` down to 1x1, each level filtered from the one
+/// above with a separable [1 3 3 1] / 8 kernel, in the file layout above.
+/// Alpha and 1/2 channel images are always filtered as they are.
+///
+[[nodiscard]] auto bake_texture(image const& source, bake_options const& options = {}) -> std::vector<unsigned char>;
+
+///
+/// Checks the header and that every level lies within `size` bytes. Returns
+/// `false` and logs with `name` otherwise.
+///
+[[nodiscard]] auto parse_baked_texture(unsigned char const* data,
+                                       std::size_t size,
+                                       std::string const& name,
+                                       baked_texture_view& view) -> bool;
+
+///
+/// Allocates immutable storage for every level of `view` (falling back to
+/// `glTexImage2D` per level without GL 4.2 / ARB_texture_storage) and
+/// uploads them, no mipmap generation involved. Uses trilinear filtering.
+/// Compressed views must be `baked_texture_supported`.
+///
+/// Levels above `first_level` are left out, the texture's level 0 being
+/// `first_level` of the file.
+///
+auto upload_baked_texture(texture const& tex, baked_texture_view const& view, std::uint32_t first_level = 0) noexcept
+    -> void;
+
+///
+/// Whether the context can upload `view` as it is, always true when it isn't
+/// compressed.
+///
+[[nodiscard]] auto baked_texture_supported(baked_texture_view const& view) noexcept -> bool;
+
+///
+/// Decodes every level of a compressed `view` to RGBA8 for contexts without
+/// its format. Slow, so best done on a worker. Returns `false` if some blocks
+/// couldn't be decoded.
+///
+[[nodiscard]] auto decompress_baked_texture(baked_texture_view const& view, std::vector<image>& levels) -> bool;
+
+///
+/// Uploads a decoded mip chain like `decompress_baked_texture` returns, from
+/// `first_level` down.
+///
+auto upload_mip_chain(texture const& tex, std::vector<image> const& levels, std::size_t first_level = 0) noexcept
+    -> void;
+
+///
+/// Maps `path` and uploads it, decoding it first if its format isn't
+/// supported. Returns `nullptr` and logs on failure.
+///
+[[nodiscard]] auto load_baked_texture(std::string const& path) -> std::shared_ptr<texture>;
+
+#endif // !UTIL_BAKED_TEXTURE_HPP
@@ -0,0 +1,70 @@
+#ifndef UTIL_BLOCK_COMPRESSION_HPP
+#define UTIL_BLOCK_COMPRESSION_HPP
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+///
+/// GPU block compressed formats, each storing 4x4 pixel blocks:
+///
+///     bc1  RGB,  8 bytes per block (6:1 against RGB8)
+///     bc3  RGBA, 16 bytes per block (4:1 against RGBA8)
+///     bc7  RGBA, 16 bytes per block, better quality than bc3
+///
+/// The encoders fit endpoints along the principal axis of each block and
+/// refine them once by least squares. The bc7 encoder only writes mode 6
+/// (one subset, 4 bit indices), which is also all the decoder reads.
+///
+enum class block_format
+{
+    bc1,
+    bc3,
+    bc7
+};
+
+[[nodiscard]] auto block_size(block_format format) noexcept -> std::size_t;
+
+///
+/// Bytes taken by a `width` x `height` image, partial blocks rounded up.
+///
+[[nodiscard]] auto compressed_size(block_format format, int width, int height) noexcept -> std::size_t;
+
+[[nodiscard]] auto block_internal_format(block_format format) noexcept -> unsigned int;
+
+///
+/// Inverse of `block_internal_format`, empty for formats that aren't handled
+/// here.
+///
+[[nodiscard]] auto block_format_of(unsigned int internal_format) noexcept -> std::optional<block_format>;
+
+///
+/// Whether the current context can sample `format`: bc1 and bc3 need
+/// EXT_texture_compression_s3tc, bc7 GL 4.2 or ARB_texture_compression_bptc.
+/// Only reads the flags glad filled in, so it may be called from any thread.
+///
+[[nodiscard]] auto block_format_supported(block_format format) noexcept -> bool;
+
+///
+/// Encodes tightly packed 8 bit pixels with 1 to 4 channels. Grey images are
+/// spread over RGB and missing alpha is opaque. Blocks sticking out of the
+/// image repeat its last row and column.
+///
+[[nodiscard]] auto compress_blocks(block_format format,
+                                   unsigned char const* pixels,
+                                   int width,
+                                   int height,
+                                   int channels) -> std::vector<unsigned char>;
+
+///
+/// Decodes `blocks` into `width` x `height` RGBA8 pixels. Returns `false` for
+/// bc7 blocks in modes other than 6, which come out magenta.
+///
+[[nodiscard]] auto decompress_blocks(block_format format,
+                                     unsigned char const* blocks,
+                                     int width,
+                                     int height,
+                                     std::vector<unsigned char>& rgba) -> bool;
+
+#endif // !UTIL_BLOCK_COMPRESSION_HPP
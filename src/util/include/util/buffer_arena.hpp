@@ -0,0 +1,178 @@
+#ifndef UTIL_BUFFER_ARENA_HPP
+#define UTIL_BUFFER_ARENA_HPP
+#pragma once
+
+#include "util/vertex_array.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+///
+/// Free list over `[0, capacity)`, handing out the smallest free block that
+/// fits and merging neighbouring blocks again when they are freed. Both are
+/// logarithmic in the number of free blocks.
+///
+class range_allocator
+{
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    struct statistics
+    {
+        std::size_t capacity = 0;
+        std::size_t used = 0;
+        std::size_t allocations = 0;
+        std::size_t free_blocks = 0;
+        std::size_t largest_free = 0;
+
+        ///
+        /// How much of the free space can't be handed out in one piece, from
+        /// 0 (it's all one block) to almost 1.
+        ///
+        [[nodiscard]] auto fragmentation() const noexcept -> double;
+    };
+
+private:
+    std::size_t m_capacity;
+    std::size_t m_used;
+    std::size_t m_allocations;
+
+    /// Offset to size, for merging neighbours
+    std::map<std::size_t, std::size_t> m_by_offset{};
+    /// (size, offset), for best fit
+    std::set<std::pair<std::size_t, std::size_t>> m_by_size{};
+
+    auto insert_free(std::size_t offset, std::size_t size) -> void;
+    auto erase_free(std::map<std::size_t, std::size_t>::iterator it) -> void;
+
+public:
+    explicit range_allocator(std::size_t capacity);
+
+    ///
+    /// Returns the offset of `size` free units, or `npos` if no free block
+    /// is that large.
+    ///
+    [[nodiscard]] auto allocate(std::size_t size) -> std::size_t;
+
+    ///
+    /// Returns a block from `allocate`, with the size it was allocated with.
+    ///
+    auto free(std::size_t offset, std::size_t size) -> void;
+
+    [[nodiscard]] auto stats() const noexcept -> statistics;
+};
+
+///
+/// Where a mesh lives inside a `buffer_arena`.
+///
+struct mesh_range
+{
+    std::size_t first_vertex = range_allocator::npos;
+    std::size_t vertex_count = 0;
+    std::size_t first_index = range_allocator::npos;
+    std::size_t index_count = 0;
+
+    [[nodiscard]] auto valid() const noexcept -> bool
+    {
+        return first_vertex != range_allocator::npos && first_index != range_allocator::npos;
+    }
+};
+
+///
+/// One vertex buffer, one index buffer and one vertex array shared by many
+/// meshes of the same vertex format. Meshes get ranges of both buffers, and
+/// their indices stay relative to their own first vertex: draws add it back
+/// with `glDrawElementsBaseVertex`. That keeps 16 bit indices usable for any
+/// number of meshes, as long as each has fewer than 65536 vertices.
+///
+/// Switching meshes doesn't touch any binding, so `draw` takes a list of
+/// them and issues a single `glMultiDrawElementsBaseVertex`.
+///
+/// Set the vertex format up once, e.g.
+///
+///     cube_layout::apply(arena.vao(), arena.vertex_buffer());
+///
+class buffer_arena
+{
+public:
+    struct statistics
+    {
+        range_allocator::statistics vertices{};
+        range_allocator::statistics indices{};
+    };
+
+private:
+    vertex_array m_vao{};
+    unsigned int m_vertex_buffer;
+    unsigned int m_index_buffer;
+    std::size_t m_vertex_stride;
+    unsigned int m_index_type;
+    std::size_t m_index_size;
+
+    range_allocator m_vertices;
+    range_allocator m_indices;
+
+    // Reused by every draw of a batch
+    std::vector<int> m_counts{};
+    std::vector<void const*> m_offsets{};
+    std::vector<int> m_base_vertices{};
+
+    auto upload(std::size_t offset, std::size_t size, void const* data, unsigned int buffer) noexcept -> void;
+
+public:
+    buffer_arena(buffer_arena const&) = delete;
+    buffer_arena(buffer_arena&&) = delete;
+    ~buffer_arena() noexcept;
+
+    ///
+    /// `index_type` is `GL_UNSIGNED_SHORT` or `GL_UNSIGNED_INT`.
+    ///
+    buffer_arena(std::size_t vertex_stride,
+                 std::size_t max_vertices,
+                 std::size_t max_indices,
+                 unsigned int index_type = GL_UNSIGNED_SHORT);
+
+    auto operator=(buffer_arena const&) -> buffer_arena& = delete;
+    auto operator=(buffer_arena&&) -> buffer_arena& = delete;
+
+    ///
+    /// Copies `vertex_count` vertices and their triangle list into the arena.
+    /// Returns an invalid range, and logs why, if either is empty or doesn't
+    /// fit, or if an index is too big for the arena's index type.
+    ///
+    [[nodiscard]] auto add(void const* vertices, std::size_t vertex_count, std::vector<std::uint32_t> const& indices)
+        -> mesh_range;
+
+    auto remove(mesh_range const& range) -> void;
+
+    ///
+    /// Draws `ranges` as triangles with the arena's vertex array and
+    /// whatever program is in use.
+    ///
+    auto draw(std::vector<mesh_range> const& ranges) -> void;
+
+    ///
+    /// Draws `instances` instances of `range`.
+    ///
+    auto draw(mesh_range const& range, std::size_t instances) const noexcept -> void;
+
+    [[nodiscard]] auto stats() const noexcept -> statistics;
+
+    ///
+    /// Logs usage and fragmentation of both buffers under `name`.
+    ///
+    auto report(std::string const& name) const -> void;
+
+    [[nodiscard]] auto vao() const noexcept -> vertex_array const&;
+    [[nodiscard]] auto vertex_buffer() const noexcept -> unsigned int;
+};
+
+#endif // !UTIL_BUFFER_ARENA_HPP
@@ -0,0 +1,126 @@
+#ifndef UTIL_BVH_HPP
+#define UTIL_BVH_HPP
+#pragma once
+
+#include "util/frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+struct aabb
+{
+    glm::vec3 min{ 0.0F };
+    glm::vec3 max{ 0.0F };
+
+    ///
+    /// Box of a sphere, e.g. an object spinning in place.
+    ///
+    [[nodiscard]] static auto around(glm::vec3 const& center, float radius) noexcept -> aabb;
+};
+
+///
+/// Bounding volume hierarchy over a set of boxes, item `i` being the `i`-th
+/// box given to `build`. Meant for large, mostly static scenes: a frustum or
+/// ray query only visits the branches it touches, so its cost grows with
+/// what is visible rather than with the scene size.
+///
+/// Nodes live in one array in depth-first order, a node's left child right
+/// after it, and every node covers a contiguous range of the item list. A
+/// branch entirely inside the frustum is thus accepted in one go.
+///
+class bvh
+{
+public:
+    struct node
+    {
+        glm::vec3 min;
+        std::uint32_t first;
+        glm::vec3 max;
+        std::uint32_t count;
+        /// Right child, 0 for leaves (the root is never anybody's child)
+        std::uint32_t right;
+    };
+
+    struct ray_hit
+    {
+        std::uint32_t item;
+        float distance;
+    };
+
+    struct stats
+    {
+        std::size_t nodes_visited = 0;
+        std::size_t items_tested = 0;
+    };
+
+private:
+    std::vector<aabb> m_boxes{};
+    std::vector<node> m_nodes{};
+    std::vector<std::uint32_t> m_items{};
+    /// Same boxes as `m_boxes`, for testing leaf items several at a time
+    frustum_culler m_volumes{};
+    /// Items of the leaves crossing the frustum, scratch space of `query`
+    std::vector<std::uint32_t> m_candidates{};
+    stats m_stats{};
+
+    auto build_node(std::vector<glm::vec3> const& centroids, std::uint32_t first, std::uint32_t count)
+        -> std::uint32_t;
+    auto fit_node(node& n) const noexcept -> void;
+
+public:
+    ///
+    /// Largest number of items per leaf.
+    ///
+    static constexpr std::uint32_t max_leaf_items = 4;
+
+    ///
+    /// Replaces the hierarchy with one over `boxes`, splitting nodes with a
+    /// binned surface area heuristic.
+    ///
+    auto build(std::vector<aabb> boxes) -> void;
+
+    ///
+    /// Same as `build` with a box around every sphere of `radius`.
+    ///
+    auto build(std::vector<glm::vec3> const& centers, float radius) -> void;
+
+    ///
+    /// Changes the box of `item`, only taking effect on the next `refit`.
+    ///
+    auto update(std::size_t item, aabb const& box) noexcept -> void;
+
+    ///
+    /// Refits every node around the current boxes without changing the tree.
+    /// Cheap but the tree gets looser as objects drift from where they were at
+    /// `build` time, rebuild once queries slow down.
+    ///
+    auto refit() noexcept -> void;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+    [[nodiscard]] auto nodes() const noexcept -> std::vector<node> const&;
+
+    ///
+    /// Replaces `visible` with the items intersecting `f`, in no particular
+    /// order, and returns how many there are. As conservative as
+    /// `frustum_culler`.
+    ///
+    auto query(frustum const& f, std::vector<std::uint32_t>& visible) -> std::size_t;
+
+    ///
+    /// Nearest item whose box the ray `origin + t * direction`, `0 <= t <=
+    /// max_distance`, goes through. `distance` is `t` at the entry point.
+    ///
+    [[nodiscard]] auto raycast(glm::vec3 const& origin, glm::vec3 const& direction, float max_distance)
+        -> std::optional<ray_hit>;
+
+    ///
+    /// Counters of the last `query` or `raycast`.
+    ///
+    [[nodiscard]] auto last_stats() const noexcept -> stats;
+};
+
+#endif // !UTIL_BVH_HPP
@@ -0,0 +1,71 @@
+#ifndef UTIL_FRAME_CONSTANTS_HPP
+#define UTIL_FRAME_CONSTANTS_HPP
+#pragma once
+
+#include "util/ring_buffer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+///
+/// Binding point of the `frame_constants` uniform block. Every program created
+/// through `shader` that declares the block gets it bound here.
+///
+constexpr unsigned int frame_constants_binding = 0;
+
+///
+/// CPU side of the std140 block below, shared by all programs:
+///
+///     layout(std140) uniform frame_constants {
+///         mat4 view;
+///         mat4 projection;
+///         mat4 view_projection;
+///     };
+///
+/// Only `mat4` members, so the C++ layout matches std140 as is.
+///
+struct frame_constants
+{
+    glm::mat4 view{ 1.0F };
+    glm::mat4 projection{ 1.0F };
+    glm::mat4 view_projection{ 1.0F };
+};
+
+static_assert(sizeof(frame_constants) == 4 * 16 * 3, "frame_constants doesn't match the std140 layout!");
+static_assert(offsetof(frame_constants, view_projection) == 128, "frame_constants doesn't match the std140 layout!");
+
+///
+/// Uniform buffer holding `frame_constants`, bound at
+/// `frame_constants_binding` for its whole lifetime. Upload once per frame,
+/// every program reading the block sees the new values.
+///
+/// Each upload goes to the next slot of a `ring_buffer` and rebinds the
+/// block to it, so it never waits for draws still reading an older frame.
+///
+class frame_constants_buffer
+{
+private:
+    ring_buffer m_ring;
+    std::size_t m_alignment;
+
+public:
+    frame_constants_buffer();
+    frame_constants_buffer(frame_constants_buffer const&) = delete;
+    frame_constants_buffer(frame_constants_buffer&&) noexcept = default;
+    ~frame_constants_buffer() noexcept = default;
+
+    auto operator=(frame_constants_buffer const&) -> frame_constants_buffer& = delete;
+    auto operator=(frame_constants_buffer&&) noexcept -> frame_constants_buffer& = default;
+
+    ///
+    /// Uploads `constants`, computing `view_projection` from `view` and
+    /// `projection` on the way. Everything drawn since the last call counts
+    /// as the previous frame.
+    ///
+    auto update(frame_constants const& constants) noexcept -> void;
+
+    [[nodiscard]] auto id() const noexcept -> unsigned int;
+};
+
+#endif // !UTIL_FRAME_CONSTANTS_HPP
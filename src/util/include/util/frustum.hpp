@@ -0,0 +1,113 @@
+#ifndef UTIL_FRUSTUM_HPP
+#define UTIL_FRUSTUM_HPP
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///
+/// The six planes bounding what a camera sees, as `(normal, distance)` with
+/// normals pointing inwards: a point `p` is inside a plane when
+/// `dot(normal, p) + distance >= 0`.
+///
+struct frustum
+{
+    enum plane_index : std::size_t
+    {
+        left = 0,
+        right,
+        bottom,
+        top,
+        z_near,
+        z_far,
+        count
+    };
+
+    std::array<glm::vec4, plane_index::count> planes{};
+
+    ///
+    /// Extracts the planes from `projection * view` (Gribb/Hartmann), for
+    /// OpenGL clip space where `-w <= z <= w`. Planes are normalized, so
+    /// distances are in world units.
+    ///
+    [[nodiscard]] static auto from_matrix(glm::mat4 const& view_projection) noexcept -> frustum;
+
+    [[nodiscard]] auto intersects_sphere(glm::vec3 const& center, float radius) const noexcept -> bool;
+    [[nodiscard]] auto intersects_aabb(glm::vec3 const& min, glm::vec3 const& max) const noexcept -> bool;
+};
+
+///
+/// Bounding volumes of a set of objects, tested against a frustum several at a
+/// time. Object `i` is the `i`-th volume added, spheres and boxes can be
+/// mixed.
+///
+/// The tests are conservative: a volume crossing the frustum's corner region
+/// may be reported visible while being outside, never the other way around.
+///
+class frustum_culler
+{
+public:
+    struct stats
+    {
+        std::size_t tested = 0;
+        std::size_t visible = 0;
+    };
+
+private:
+    // A box is stored as center and half extents with a zero radius, a sphere
+    // as center and radius with zero extents, so both take the same test
+    std::vector<float> m_cx{};
+    std::vector<float> m_cy{};
+    std::vector<float> m_cz{};
+    std::vector<float> m_ex{};
+    std::vector<float> m_ey{};
+    std::vector<float> m_ez{};
+    std::vector<float> m_radius{};
+    stats m_stats{};
+
+public:
+    auto reserve(std::size_t count) -> void;
+    auto clear() noexcept -> void;
+
+    auto add_sphere(glm::vec3 const& center, float radius) -> void;
+    auto add_aabb(glm::vec3 const& min, glm::vec3 const& max) -> void;
+
+    ///
+    /// Moves object `index`, keeping its size. Useful when objects move but
+    /// don't change shape.
+    ///
+    auto set_center(std::size_t index, glm::vec3 const& center) noexcept -> void;
+
+    ///
+    /// Replaces object `index` with the box `[min, max]`.
+    ///
+    auto set_aabb(std::size_t index, glm::vec3 const& min, glm::vec3 const& max) noexcept -> void;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    ///
+    /// Replaces `visible` with the indices of the objects intersecting `f`,
+    /// in increasing order, and returns how many there are.
+    ///
+    auto cull(frustum const& f, std::vector<std::uint32_t>& visible) -> std::size_t;
+
+    ///
+    /// Appends to `visible` the objects of `candidates` intersecting `f`, in
+    /// the same order, and returns how many were appended. For callers that
+    /// already narrowed the set down, e.g. `bvh` leaves, the candidates get
+    /// gathered into lanes so they still take the vector test.
+    ///
+    auto cull(frustum const& f, std::vector<std::uint32_t> const& candidates, std::vector<std::uint32_t>& visible)
+        -> std::size_t;
+
+    ///
+    /// Counters of the last `cull`.
+    ///
+    [[nodiscard]] auto last_stats() const noexcept -> stats;
+};
+
+#endif // !UTIL_FRUSTUM_HPP
@@ -0,0 +1,101 @@
+#ifndef UTIL_GL_STATE_HPP
+#define UTIL_GL_STATE_HPP
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+///
+/// Shadow copy of the OpenGL binding state of the current context. Every call
+/// that wouldn't change anything is skipped and counted, the rest go through
+/// to the driver.
+///
+/// Everything that binds should route through here (`shader::use`, `texture`,
+/// `vertex_array`, ...). Code that calls `glBind*` directly has to call
+/// `invalidate` afterwards, and deleted objects must be `forget`-ed, since GL
+/// unbinds them behind our back and their names can get recycled.
+///
+class gl_state
+{
+public:
+    static constexpr std::size_t max_texture_units = 16;
+
+    struct statistics
+    {
+        std::size_t issued = 0;
+        std::size_t skipped = 0;
+    };
+
+private:
+    static constexpr unsigned int unknown = ~0U;
+
+    static constexpr std::size_t num_buffer_targets = 8;
+    static constexpr std::size_t num_texture_targets = 4;
+    static constexpr std::size_t num_capabilities = 3;
+
+    unsigned int m_program = unknown;
+    unsigned int m_vertex_array = unknown;
+    unsigned int m_active_unit = unknown;
+    std::array<unsigned int, num_buffer_targets> m_buffers{};
+    std::array<std::array<unsigned int, num_texture_targets>, max_texture_units> m_textures{};
+    std::array<unsigned int, max_texture_units> m_samplers{};
+    std::array<unsigned int, num_capabilities> m_capabilities{};
+    statistics m_stats{};
+
+    gl_state() noexcept;
+
+    auto activate_unit(unsigned int unit) noexcept -> void;
+
+public:
+    gl_state(gl_state const&) = delete;
+    gl_state(gl_state&&) = delete;
+    ~gl_state() noexcept = default;
+
+    auto operator=(gl_state const&) -> gl_state& = delete;
+    auto operator=(gl_state&&) -> gl_state& = delete;
+
+    ///
+    /// State of the (single) context the application renders with.
+    ///
+    [[nodiscard]] static auto current() noexcept -> gl_state&;
+
+    auto use_program(unsigned int program) noexcept -> void;
+    auto bind_vertex_array(unsigned int vao) noexcept -> void;
+    auto bind_buffer(unsigned int target, unsigned int buffer) noexcept -> void;
+    auto bind_buffer_base(unsigned int target, unsigned int index, unsigned int buffer) noexcept -> void;
+    auto bind_buffer_range(unsigned int target,
+                           unsigned int index,
+                           unsigned int buffer,
+                           std::size_t offset,
+                           std::size_t size) noexcept -> void;
+    auto bind_texture(unsigned int unit, unsigned int target, unsigned int texture) noexcept -> void;
+    auto bind_sampler(unsigned int unit, unsigned int sampler) noexcept -> void;
+
+    ///
+    /// Only `GL_DEPTH_TEST`, `GL_BLEND` and `GL_CULL_FACE` are shadowed,
+    /// anything else is passed straight through.
+    ///
+    auto set_enabled(unsigned int capability, bool enabled) noexcept -> void;
+
+    ///
+    /// Vertex array bound through `bind_vertex_array`, `std::nullopt` if that
+    /// isn't known (before the first bind, or after `invalidate`).
+    ///
+    [[nodiscard]] auto bound_vertex_array() const noexcept -> std::optional<unsigned int>;
+
+    auto forget_program(unsigned int program) noexcept -> void;
+    auto forget_vertex_array(unsigned int vao) noexcept -> void;
+    auto forget_buffer(unsigned int buffer) noexcept -> void;
+    auto forget_texture(unsigned int texture) noexcept -> void;
+
+    ///
+    /// Marks everything as unknown, so the next call of each kind is issued.
+    ///
+    auto invalidate() noexcept -> void;
+
+    [[nodiscard]] auto stats() const noexcept -> statistics const&;
+    auto reset_stats() noexcept -> void;
+};
+
+#endif // !UTIL_GL_STATE_HPP
@@ -0,0 +1,65 @@
+#ifndef UTIL_HASH_HPP
+#define UTIL_HASH_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+///
+/// 64-bit FNV-1a, fed one field at a time. Every field is followed by a zero
+/// byte so that moving data between fields changes the hash.
+///
+/// Strings can be hashed in constant expressions, which is how uniform names
+/// written as literals get hashed by the compiler (see `uniform_name`).
+///
+class hasher
+{
+private:
+    static constexpr std::uint64_t prime = 1099511628211ULL;
+    std::uint64_t m_hash = 14695981039346656037ULL;
+
+    constexpr auto add_byte(std::uint8_t const byte) noexcept -> void
+    {
+        m_hash ^= byte;
+        m_hash *= prime;
+    }
+
+public:
+    auto add(void const* const data, std::size_t const size) noexcept -> void
+    {
+        auto const* const bytes = static_cast<std::uint8_t const*>(data);
+
+        for(std::size_t i = 0; i < size; ++i) {
+            this->add_byte(bytes[i]); // NOLINT
+        }
+
+        this->add_byte(0);
+    }
+
+    constexpr auto add(std::string_view const str) noexcept -> void
+    {
+        for(char const c : str) {
+            this->add_byte(static_cast<std::uint8_t>(c));
+        }
+
+        this->add_byte(0);
+    }
+
+    [[nodiscard]] constexpr auto value() const noexcept -> std::uint64_t
+    {
+        return m_hash;
+    }
+
+    ///
+    /// Hash of `str` on its own.
+    ///
+    [[nodiscard]] static constexpr auto of(std::string_view const str) noexcept -> std::uint64_t
+    {
+        hasher h{};
+        h.add(str);
+        return h.value();
+    }
+};
+
+#endif // !UTIL_HASH_HPP
@@ -0,0 +1,85 @@
+#ifndef UTIL_INSTANCE_BUFFER_HPP
+#define UTIL_INSTANCE_BUFFER_HPP
+#pragma once
+
+#include "util/ring_buffer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+class vertex_array;
+
+///
+/// Vertex buffer of per-instance model matrices, read by the vertex shader as
+///
+///     layout(location = N) in mat4 model;
+///
+/// which takes up locations N to N + 3. Draw with `glDrawElementsInstanced`
+/// and `count()` instances.
+///
+/// Every `upload` or `map` starts a new frame of a `ring_buffer` and points
+/// the attached vertex array at it, so rewriting the matrices each frame
+/// never waits on draws still reading the last ones. The vertex array bound
+/// through `gl_state` before that is bound again afterwards.
+///
+class instance_buffer
+{
+private:
+    ring_buffer m_ring;
+    std::size_t m_capacity;
+    std::size_t m_count;
+
+    unsigned int m_vao;
+    unsigned int m_location;
+    std::size_t m_offset;
+
+    auto reserve(std::size_t count) -> void;
+    auto point_attributes() const noexcept -> void;
+
+public:
+    instance_buffer(instance_buffer const&) = delete;
+    instance_buffer(instance_buffer&&) noexcept = default;
+    ~instance_buffer() noexcept = default;
+
+    explicit instance_buffer(std::size_t capacity);
+
+    auto operator=(instance_buffer const&) -> instance_buffer& = delete;
+    auto operator=(instance_buffer&&) noexcept -> instance_buffer& = default;
+
+    ///
+    /// Adds the `mat4` attribute at `first_location` (and the following three
+    /// locations) to `vao`, advancing once per instance. `vao` has to outlive
+    /// the buffer, later uploads update its attributes.
+    ///
+    auto attach(vertex_array const& vao, unsigned int first_location) noexcept -> void;
+
+    ///
+    /// Replaces the contents with `count` matrices, growing the buffer if
+    /// they don't fit.
+    ///
+    auto upload(glm::mat4 const* models, std::size_t count) -> void;
+
+    ///
+    /// Like `upload`, but returns room for `count` matrices to write
+    /// straight into instead of copying them. Returns `nullptr`, with a
+    /// `count()` of 0, for no matrices or if the driver can't map the buffer.
+    /// Call `unmap` before drawing.
+    ///
+    [[nodiscard]] auto map(std::size_t count) -> glm::mat4*;
+
+    ///
+    /// Returns `false` if the contents got lost while mapped (they are then
+    /// undefined and should be written again).
+    ///
+    auto unmap() noexcept -> bool;
+
+    [[nodiscard]] auto count() const noexcept -> std::size_t;
+
+    ///
+    /// Changes when the buffer grows.
+    ///
+    [[nodiscard]] auto id() const noexcept -> unsigned int;
+};
+
+#endif // !UTIL_INSTANCE_BUFFER_HPP
@@ -0,0 +1,44 @@
+#ifndef UTIL_MAPPED_FILE_HPP
+#define UTIL_MAPPED_FILE_HPP
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+///
+/// Read-only memory mapping of a whole file. Check `valid()` after
+/// construction, `error()` then says what went wrong. An empty file is valid
+/// with a null `data()`.
+///
+class mapped_file
+{
+private:
+    void const* m_data;
+    std::size_t m_size;
+    std::string m_error;
+#if defined(_WIN32)
+    void* m_file;
+    void* m_mapping;
+#endif
+
+    auto close() noexcept -> void;
+
+public:
+    mapped_file() = delete;
+    mapped_file(mapped_file const&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    ~mapped_file() noexcept;
+
+    explicit mapped_file(std::string const& path);
+
+    auto operator=(mapped_file const&) -> mapped_file& = delete;
+    auto operator=(mapped_file&& other) noexcept -> mapped_file&;
+
+    [[nodiscard]] auto valid() const noexcept -> bool;
+    [[nodiscard]] auto error() const noexcept -> std::string const&;
+
+    [[nodiscard]] auto data() const noexcept -> unsigned char const*;
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+};
+
+#endif // !UTIL_MAPPED_FILE_HPP
@@ -0,0 +1,84 @@
+#ifndef UTIL_MESH_OPTIMIZER_HPP
+#define UTIL_MESH_OPTIMIZER_HPP
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+///
+/// Indexed triangle list with interleaved float vertices. Empty `indices`
+/// mean the vertices are a triangle soup, three per triangle.
+///
+struct mesh
+{
+    std::vector<float> vertices{};
+    /// Floats per vertex
+    std::size_t stride = 0;
+    std::vector<std::uint32_t> indices{};
+
+    [[nodiscard]] auto vertex_count() const noexcept -> std::size_t;
+    [[nodiscard]] auto index_count() const noexcept -> std::size_t;
+};
+
+///
+/// How well a mesh uses the post-transform vertex cache, simulated as a FIFO
+/// like most hardware has. ACMR is vertex shader runs per triangle (0.5 at
+/// best for large grids, 3 without any reuse), ATVR per vertex (1 at best).
+///
+struct vertex_cache_stats
+{
+    std::size_t transforms = 0;
+    double acmr = 0.0;
+    double atvr = 0.0;
+};
+
+///
+/// Index buffer in the narrowest type that fits, ready for `glBufferData`
+/// and `glDrawElements`.
+///
+struct packed_indices
+{
+    /// `GL_UNSIGNED_SHORT` or `GL_UNSIGNED_INT`
+    unsigned int type = GL_UNSIGNED_INT;
+    std::vector<unsigned char> bytes{};
+    std::size_t count = 0;
+};
+
+///
+/// Merges bitwise identical vertices, e.g. the corners a cube soup repeats
+/// for every triangle that shares them.
+///
+[[nodiscard]] auto weld_vertices(mesh const& source) -> mesh;
+
+///
+/// Reorders triangles so consecutive ones share vertices, using Tom
+/// Forsyth's linear-speed vertex cache optimisation with an LRU cache of
+/// `cache_size` entries.
+///
+auto optimize_vertex_cache(mesh& m, std::size_t cache_size = 32) -> void;
+
+///
+/// Reorders vertices in the order the indices first use them, so vertex
+/// fetches walk the buffer forward. Unused vertices are dropped.
+///
+auto optimize_vertex_fetch(mesh& m) -> void;
+
+[[nodiscard]] auto analyze_vertex_cache(mesh const& m, std::size_t cache_size = 16) -> vertex_cache_stats;
+
+///
+/// 16 bit indices whenever the vertices allow it. 8 bit ones are left out on
+/// purpose, plenty of GPUs convert them on the CPU or run them slower.
+///
+[[nodiscard]] auto pack_indices(mesh const& m) -> packed_indices;
+
+///
+/// Welds, cache and fetch optimizes `source`, logging its ACMR/ATVR before
+/// and after under `name`.
+///
+[[nodiscard]] auto optimize_mesh(mesh const& source, std::string const& name) -> mesh;
+
+#endif // !UTIL_MESH_OPTIMIZER_HPP
@@ -0,0 +1,88 @@
+#ifndef UTIL_PAGE_FEEDBACK_HPP
+#define UTIL_PAGE_FEEDBACK_HPP
+#pragma once
+
+#include "util/virtual_texture.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///
+/// Low resolution render target that virtual textured geometry is drawn into
+/// with a feedback shader, writing the page each pixel wants as
+/// `uvec4(x, y, level, 1)` (0 where nothing was drawn).
+///
+/// The target is read back into a ring of pixel buffers, so `collect` hands
+/// out the requests of a frame a few frames late instead of stalling on the
+/// GPU. Frames whose readback would find the ring full are skipped.
+///
+class page_feedback
+{
+private:
+    struct readback
+    {
+        unsigned int buffer = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    unsigned int m_framebuffer = 0;
+    unsigned int m_color = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_divisor;
+
+    std::vector<readback> m_readbacks{};
+    std::size_t m_write = 0;
+    std::size_t m_read = 0;
+    std::vector<std::uint64_t> m_keys{};
+    std::size_t m_skipped = 0;
+
+public:
+    page_feedback() = delete;
+    page_feedback(page_feedback const&) = delete;
+    page_feedback(page_feedback&&) = delete;
+    ~page_feedback() noexcept;
+
+    ///
+    /// Target `divisor` times smaller than the screen on each side, read back
+    /// `latency` frames late at most.
+    ///
+    page_feedback(int screen_width, int screen_height, int divisor = 8, std::size_t latency = 3);
+
+    auto operator=(page_feedback const&) -> page_feedback& = delete;
+    auto operator=(page_feedback&&) -> page_feedback& = delete;
+
+    auto resize(int screen_width, int screen_height) noexcept -> void;
+
+    ///
+    /// Binds and clears the target, draw the feedback pass after this.
+    ///
+    auto begin() const noexcept -> void;
+
+    ///
+    /// Starts reading the target back and binds the default framebuffer
+    /// again with a `screen_width` x `screen_height` viewport.
+    ///
+    auto end(int screen_width, int screen_height) noexcept -> void;
+
+    ///
+    /// Fills `requests` with the distinct pages of the oldest readback if it
+    /// has arrived. Returns `false`, leaving `requests` alone, otherwise.
+    ///
+    [[nodiscard]] auto collect(std::vector<page_request>& requests) -> bool;
+
+    ///
+    /// How many more levels of detail pixels here want than on the screen,
+    /// see `virtual_texture::set_uniforms`.
+    ///
+    [[nodiscard]] auto level_bias() const noexcept -> float;
+
+    [[nodiscard]] auto skipped() const noexcept -> std::size_t;
+};
+
+#endif // !UTIL_PAGE_FEEDBACK_HPP
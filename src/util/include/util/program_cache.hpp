@@ -0,0 +1,77 @@
+#ifndef UTIL_PROGRAM_CACHE_HPP
+#define UTIL_PROGRAM_CACHE_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///
+/// Persistent cache of linked program binaries (`glGetProgramBinary` /
+/// `glProgramBinary`), one file per program inside `directory`.
+///
+/// Entries are keyed by the shader sources, the preprocessor defines and the
+/// driver's vendor/renderer/version strings, so a driver update simply
+/// produces misses. A binary the driver refuses is deleted and counted as
+/// rejected, the caller then falls back to a full compile.
+///
+/// Must be created while an OpenGL context is current.
+///
+class program_cache
+{
+public:
+    struct statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t rejected = 0;
+        std::size_t stored = 0;
+    };
+
+private:
+    std::string m_directory;
+    std::string m_driver;
+    bool m_supported;
+    statistics m_stats{};
+
+    [[nodiscard]] auto path_of(std::uint64_t key) const -> std::string;
+
+public:
+    program_cache() = delete;
+    program_cache(program_cache const&) = default;
+    program_cache(program_cache&&) noexcept = default;
+    ~program_cache() noexcept = default;
+
+    explicit program_cache(std::string directory);
+
+    auto operator=(program_cache const&) -> program_cache& = default;
+    auto operator=(program_cache&&) noexcept -> program_cache& = default;
+
+    ///
+    /// `false` if the driver exposes no program binary formats, in which case
+    /// `load` always misses and `store` does nothing.
+    ///
+    [[nodiscard]] auto supported() const noexcept -> bool;
+
+    [[nodiscard]] auto key(std::string_view vs_source,
+                           std::string_view fs_source,
+                           std::vector<std::string> const& defines) const noexcept -> std::uint64_t;
+
+    ///
+    /// Creates a linked program from the cached binary for `key`, or returns
+    /// `0` if there is none or the driver rejected it.
+    ///
+    [[nodiscard]] auto load(std::uint64_t key) -> unsigned int;
+
+    ///
+    /// Saves the binary of `program`, which should have been linked with
+    /// `GL_PROGRAM_BINARY_RETRIEVABLE_HINT` set.
+    ///
+    auto store(std::uint64_t key, unsigned int program) -> void;
+
+    [[nodiscard]] auto stats() const noexcept -> statistics const&;
+};
+
+#endif // !UTIL_PROGRAM_CACHE_HPP
@@ -0,0 +1,123 @@
+#ifndef UTIL_RING_BUFFER_HPP
+#define UTIL_RING_BUFFER_HPP
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+///
+/// Buffer for data rewritten every frame (uniforms, instances, sprite
+/// vertices, ...), handed out with a bump allocator so writing it never
+/// waits on the GPU.
+///
+/// With `glBufferStorage` (GL 4.4 / ARB_buffer_storage) the buffer is mapped
+/// persistently and coherently once, and split into `frames` regions. Each
+/// frame allocates from the next region, after waiting on the fence placed
+/// when that region was last used, which only blocks if the GPU is more
+/// than `frames - 1` frames behind.
+///
+/// Otherwise every frame orphans the buffer and maps it anew, leaving the
+/// synchronisation to the driver.
+///
+///     ring.begin_frame();
+///     auto const a = ring.allocate(sizeof(data));
+///     std::memcpy(a.data, &data, sizeof(data));
+///     ring.flush();
+///     // draw reading from ring.id() at a.offset
+///     ring.end_frame();
+///
+class ring_buffer
+{
+public:
+    static constexpr std::size_t default_frames = 3;
+
+    struct allocation
+    {
+        void* data = nullptr;
+        /// From the start of the buffer, for binding or attribute offsets
+        std::size_t offset = 0;
+        std::size_t size = 0;
+
+        [[nodiscard]] auto valid() const noexcept -> bool
+        {
+            return data != nullptr;
+        }
+    };
+
+    struct statistics
+    {
+        std::size_t frames = 0;
+        /// Frames that had to wait for the GPU to release their region
+        std::size_t stalls = 0;
+        /// Allocations that didn't fit into their frame's region
+        std::size_t overflows = 0;
+    };
+
+private:
+    unsigned int m_buffer;
+    unsigned int m_target;
+    std::size_t m_frame_bytes;
+    std::size_t m_frames;
+    unsigned char* m_persistent;
+
+    std::vector<GLsync> m_fences{};
+    std::size_t m_frame;
+    std::size_t m_head;
+    bool m_in_frame;
+
+    // Orphaning only: the part of this frame's buffer currently mapped
+    unsigned char* m_mapped;
+    std::size_t m_mapped_from;
+
+    statistics m_stats{};
+
+    auto release() noexcept -> void;
+
+public:
+    ring_buffer(ring_buffer const&) = delete;
+    ring_buffer(ring_buffer&& other) noexcept;
+    ~ring_buffer() noexcept;
+
+    ///
+    /// Creates the buffer bound to `target`, with `frame_bytes` (rounded up to
+    /// 256, the largest uniform buffer offset alignment around) per frame.
+    ///
+    ring_buffer(unsigned int target, std::size_t frame_bytes, std::size_t frames = default_frames);
+
+    auto operator=(ring_buffer const&) -> ring_buffer& = delete;
+    auto operator=(ring_buffer&& other) noexcept -> ring_buffer&;
+
+    ///
+    /// Moves on to the next region, waiting for the GPU if it is still
+    /// reading it.
+    ///
+    auto begin_frame() noexcept -> void;
+
+    ///
+    /// Returns `size` bytes at an offset that is a multiple of `alignment`,
+    /// or an invalid allocation if this frame's region is full.
+    ///
+    [[nodiscard]] auto allocate(std::size_t size, std::size_t alignment = 16) noexcept -> allocation;
+
+    ///
+    /// Makes this frame's allocations visible to the GPU; call before drawing
+    /// with them. Allocating afterwards is fine. Returns `false` if the
+    /// driver lost the contents while mapped (only possible when orphaning).
+    ///
+    auto flush() noexcept -> bool;
+
+    ///
+    /// Fences off this frame's region. Call after the last draw reading it.
+    /// Does nothing outside of a frame.
+    ///
+    auto end_frame() noexcept -> void;
+
+    [[nodiscard]] auto persistent() const noexcept -> bool;
+    [[nodiscard]] auto frame_bytes() const noexcept -> std::size_t;
+    [[nodiscard]] auto stats() const noexcept -> statistics const&;
+    [[nodiscard]] auto id() const noexcept -> unsigned int;
+};
+
+#endif // !UTIL_RING_BUFFER_HPP
@@ -2,45 +2,273 @@
 #define UTIL_SHADER_HPP
 #pragma once
 
+#include "util/hash.hpp"
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+///
+/// Name of a uniform together with its precomputed hash. Constructing it is
+/// free of allocations, and `constexpr` instances (or `"name"_uniform`) are
+/// hashed at compile time.
+///
+/// Only a view of the name is kept, so the string it was made from has to
+/// outlive it. That's why `std::string`s have to be converted explicitly.
+///
+class uniform_name
+{
+private:
+    std::string_view m_name;
+    std::uint64_t m_hash;
+
+public:
+    constexpr uniform_name(std::string_view const name) noexcept
+        : m_name{ name }
+        , m_hash{ hasher::of(name) }
+    {
+    }
+    constexpr uniform_name(char const* const name) noexcept
+        : uniform_name(name != nullptr ? std::string_view{ name } : std::string_view{})
+    {
+    }
+    explicit uniform_name(std::string const& name) noexcept
+        : uniform_name(std::string_view{ name })
+    {
+    }
+
+    [[nodiscard]] constexpr auto name() const noexcept -> std::string_view
+    {
+        return m_name;
+    }
+
+    [[nodiscard]] constexpr auto hash() const noexcept -> std::uint64_t
+    {
+        return m_hash;
+    }
+};
+
+constexpr auto operator""_uniform(char const* const str, std::size_t const length) noexcept -> uniform_name
+{
+    return uniform_name{ std::string_view{ str, length } };
+}
+
+///
+/// Typed handle to a uniform of a linked program. Handles are obtained through
+/// `shader::get_uniform<T>`, which checks `T` against the type the program
+/// declared, so `set` is just the `glUniform*` call.
+///
+template<typename T>
+class uniform
+{
+private:
+    int m_location = -1;
+
+public:
+    constexpr uniform() noexcept = default;
+    constexpr explicit uniform(int const location) noexcept
+        : m_location{ location }
+    {
+    }
+
+    [[nodiscard]] constexpr auto location() const noexcept -> int
+    {
+        return m_location;
+    }
+
+    [[nodiscard]] constexpr auto valid() const noexcept -> bool
+    {
+        return m_location >= 0;
+    }
+
+    auto set(T const& value) const noexcept -> void;
+};
+
+class program_cache;
+class shader_compiler;
 
 class shader
 {
 private:
     unsigned int m_id;
 
+    ///
+    /// One entry per active uniform, filled once after linking and kept
+    /// sorted by name hash so lookups never have to go through the driver.
+    /// The name settles the rare case of two uniforms sharing a hash.
+    ///
+    struct uniform_info
+    {
+        std::uint64_t hash = 0;
+        int location = -1;
+        unsigned int type = 0;
+        std::string name{};
+    };
+
+    std::vector<uniform_info> m_uniforms{};
+
     enum shader_type
     {
         vertex = GL_VERTEX_SHADER,
         fragment = GL_FRAGMENT_SHADER
     };
 
-    [[nodiscard]] auto create_shader(shader_type type, char const* source) -> unsigned int;
-    [[nodiscard]] auto create_program(unsigned int vs, unsigned int fs) -> unsigned int;
+    ///
+    /// Compiling and linking are split from their status checks so that
+    /// `shader_compiler` can submit many programs before querying any of them.
+    ///
+    [[nodiscard]] static auto compile_shader(shader_type type, char const* source) -> unsigned int;
+    [[nodiscard]] static auto link_program(unsigned int vs, unsigned int fs, bool retrievable) -> unsigned int;
+    static auto check_shader(unsigned int shader, shader_type type) -> bool;
+    static auto check_program(unsigned int shader_program) -> bool;
+
+    ///
+    /// Maps the file at `path` and copies it once into `source`, with
+    /// `defines` injected. Returns `false` and logs if it can't be read or is
+    /// empty, so nothing gets compiled from it.
+    ///
+    [[nodiscard]] static auto load_source(std::string const& path,
+                                          std::vector<std::string> const& defines,
+                                          std::string& source) -> bool;
+
+    explicit shader(unsigned int program);
+
+    shader(program_cache* cache,
+           std::string const& vs_path,
+           std::string const& fs_path,
+           std::vector<std::string> const& defines);
+
+    auto cache_uniforms() -> void;
+
+    ///
+    /// Wires up the uniform blocks shared by every program, currently only
+    /// `frame_constants` (see `util/frame_constants.hpp`).
+    ///
+    auto bind_uniform_blocks() const noexcept -> void;
+
+    [[nodiscard]] auto find_uniform(uniform_name name) const noexcept -> uniform_info const*;
+    [[nodiscard]] auto bind_uniform(uniform_name name, unsigned int type) const noexcept -> int;
+
+    template<typename T>
+    static constexpr auto gl_type_of() noexcept -> unsigned int;
+
+    friend class shader_compiler;
 
 public:
     shader() = delete;
-    shader(shader const&) noexcept = default;
+    shader(shader const&) = default;
     shader(shader&&) noexcept = default;
     ~shader() noexcept = default;
 
-    shader(std::string const& vs_path, std::string const& fs_path);
+    ///
+    /// Every entry of `defines` is injected as `#define <entry>` right after
+    /// the `#version` line of both stages, e.g. `"USE_FOG"` or `"NUM_LIGHTS 4"`.
+    /// Files that can't be read are logged and nothing gets compiled.
+    ///
+    shader(std::string const& vs_path, std::string const& fs_path, std::vector<std::string> const& defines = {});
 
-    auto operator=(shader const&) noexcept -> shader& = default;
+    ///
+    /// Same as above, but tries to load the linked program from `cache` first
+    /// and stores it there after a successful compile.
+    ///
+    shader(program_cache& cache,
+           std::string const& vs_path,
+           std::string const& fs_path,
+           std::vector<std::string> const& defines = {});
+
+    auto operator=(shader const&) -> shader& = default;
     auto operator=(shader&&) noexcept -> shader& = default;
 
     auto use() const noexcept -> void;
 
-    auto set_bool(std::string const& id, bool value) const noexcept -> void;
-    auto set_int(std::string const& id, int value) const noexcept -> void;
-    auto set_float(std::string const& id, float value) const noexcept -> void;
-    auto set_vec4(std::string const& id, glm::vec4 const& value) const noexcept -> void;
-    auto set_mat4(std::string const& id, glm::mat4 const& value) const noexcept -> void;
+    ///
+    /// Returns the location of an active uniform or `-1` if the program doesn't
+    /// have one with that name (`glUniform*` silently ignores `-1`).
+    ///
+    /// Prefer `get_uniform` outside of hot loops, it also checks the type.
+    ///
+    [[nodiscard]] auto location(uniform_name name) const noexcept -> int;
+
+    ///
+    /// Binds a typed handle to the uniform `name`. If the program doesn't have
+    /// such a uniform, or it was declared with a type other than `T`, an error
+    /// is logged and the returned handle is invalid (setting it is a no-op).
+    ///
+    template<typename T>
+    [[nodiscard]] auto get_uniform(uniform_name const name) const noexcept -> uniform<T>
+    {
+        return uniform<T>{ this->bind_uniform(name, gl_type_of<T>()) };
+    }
+
+    auto set_bool(uniform_name name, bool value) const noexcept -> void;
+    auto set_int(uniform_name name, int value) const noexcept -> void;
+    auto set_float(uniform_name name, float value) const noexcept -> void;
+    auto set_vec4(uniform_name name, glm::vec4 const& value) const noexcept -> void;
+    auto set_mat4(uniform_name name, glm::mat4 const& value) const noexcept -> void;
+
+    static auto set_bool(int location, bool value) noexcept -> void;
+    static auto set_int(int location, int value) noexcept -> void;
+    static auto set_float(int location, float value) noexcept -> void;
+    static auto set_vec4(int location, glm::vec4 const& value) noexcept -> void;
+    static auto set_mat4(int location, glm::mat4 const& value) noexcept -> void;
 
     static auto unbind() noexcept -> void;
 };
 
+template<typename T>
+constexpr auto shader::gl_type_of() noexcept -> unsigned int
+{
+    if constexpr(std::is_same_v<T, bool>) {
+        return GL_BOOL;
+    }
+    else if constexpr(std::is_same_v<T, int>) {
+        return GL_INT;
+    }
+    else if constexpr(std::is_same_v<T, float>) {
+        return GL_FLOAT;
+    }
+    else if constexpr(std::is_same_v<T, glm::vec4>) {
+        return GL_FLOAT_VEC4;
+    }
+    else {
+        static_assert(std::is_same_v<T, glm::mat4>, "Unsupported uniform type!");
+        return GL_FLOAT_MAT4;
+    }
+}
+
+template<>
+inline auto uniform<bool>::set(bool const& value) const noexcept -> void
+{
+    shader::set_bool(m_location, value);
+}
+
+template<>
+inline auto uniform<int>::set(int const& value) const noexcept -> void
+{
+    shader::set_int(m_location, value);
+}
+
+template<>
+inline auto uniform<float>::set(float const& value) const noexcept -> void
+{
+    shader::set_float(m_location, value);
+}
+
+template<>
+inline auto uniform<glm::vec4>::set(glm::vec4 const& value) const noexcept -> void
+{
+    shader::set_vec4(m_location, value);
+}
+
+template<>
+inline auto uniform<glm::mat4>::set(glm::mat4 const& value) const noexcept -> void
+{
+    shader::set_mat4(m_location, value);
+}
+
 #endif // !UTIL_SHADER_HPP
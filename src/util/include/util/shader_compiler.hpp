@@ -0,0 +1,117 @@
+#ifndef UTIL_SHADER_COMPILER_HPP
+#define UTIL_SHADER_COMPILER_HPP
+#pragma once
+
+#include "util/shader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+class program_cache;
+
+///
+/// Batch shader compilation: `submit` only issues the compile and link
+/// commands, status is queried later from `poll`, so the driver can work on
+/// every program at once while the application does something else.
+///
+/// When `GL_KHR_parallel_shader_compile` or `GL_ARB_parallel_shader_compile`
+/// is available the driver compiles on its own threads and `poll` never
+/// blocks. Without it, `poll` finalizes at most one program per call, which
+/// spreads the stalls over several frames.
+///
+/// Until a program is ready (or if it failed), `get` returns the fallback
+/// program if one was set, or an invalid program that draws nothing.
+///
+class shader_compiler
+{
+public:
+    using handle = std::size_t;
+
+    enum class status
+    {
+        pending,
+        ready,
+        failed
+    };
+
+private:
+    struct job
+    {
+        unsigned int vs = 0;
+        unsigned int fs = 0;
+        unsigned int program = 0;
+        std::uint64_t key = 0;
+        status state = status::pending;
+        std::optional<shader> result{};
+    };
+
+    program_cache* m_cache;
+    bool m_parallel;
+    std::size_t m_pending;
+    /// A deque so that `submit` doesn't move the programs `get` handed out
+    std::deque<job> m_jobs{};
+    std::optional<shader> m_fallback{};
+    shader m_invalid;
+
+    [[nodiscard]] auto completed(job const& j) const noexcept -> bool;
+    auto finalize(job& j) -> void;
+    auto release() noexcept -> void;
+
+public:
+    shader_compiler(shader_compiler const&) = delete;
+    shader_compiler(shader_compiler&&) noexcept = default;
+    ///
+    /// Deletes the objects of programs that are still pending. Ready
+    /// programs belong to the `shader`s handed out for them.
+    ///
+    ~shader_compiler() noexcept;
+
+    ///
+    /// `cache` is optional, programs found there are ready right away.
+    /// Must be created while an OpenGL context is current.
+    ///
+    explicit shader_compiler(program_cache* cache = nullptr);
+
+    auto operator=(shader_compiler const&) -> shader_compiler& = delete;
+    auto operator=(shader_compiler&& other) noexcept -> shader_compiler&;
+
+    [[nodiscard]] auto parallel() const noexcept -> bool;
+
+    [[nodiscard]] auto submit(std::string const& vs_path,
+                              std::string const& fs_path,
+                              std::vector<std::string> const& defines = {}) -> handle;
+
+    ///
+    /// Program returned by `get` while the real one isn't ready. Should be
+    /// something trivial that compiles instantly, e.g. a flat color.
+    ///
+    auto set_fallback(shader fallback) -> void;
+
+    ///
+    /// Finalizes programs the driver finished with. Returns how many programs
+    /// are still pending. Meant to be called once per frame.
+    ///
+    auto poll() -> std::size_t;
+
+    ///
+    /// Blocks until every submitted program is either ready or failed.
+    ///
+    auto wait_all() -> void;
+
+    [[nodiscard]] auto state(handle h) const noexcept -> status;
+    [[nodiscard]] auto ready(handle h) const noexcept -> bool;
+    [[nodiscard]] auto pending() const noexcept -> std::size_t;
+
+    ///
+    /// The program for `h` if it's ready, otherwise the fallback, or the
+    /// invalid program without one. Call it again once `h` is ready, the
+    /// reference stays valid but doesn't switch over by itself.
+    ///
+    [[nodiscard]] auto get(handle h) const -> shader const&;
+};
+
+#endif // !UTIL_SHADER_COMPILER_HPP
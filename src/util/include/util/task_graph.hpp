@@ -0,0 +1,103 @@
+#ifndef UTIL_TASK_GRAPH_HPP
+#define UTIL_TASK_GRAPH_HPP
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class worker_pool;
+
+///
+/// Startup work as a graph of tasks, each started as soon as the tasks it
+/// depends on are done instead of one after the other.
+///
+/// Worker tasks (file reads, image decodes, ...) go to a `worker_pool`. GL
+/// tasks are queued for the thread calling `finish`, which owns the context,
+/// and run there in the order they become ready. Creating the context can be
+/// a GL task itself, so the workers get going before it exists.
+///
+/// Every task is timed from the graph's construction, so `report` can tell
+/// how long the first frame took and which chain of tasks bounded it.
+///
+class task_graph
+{
+public:
+    using task_id = std::size_t;
+    using clock_type = std::chrono::steady_clock;
+
+    enum class runs_on
+    {
+        worker,
+        gl
+    };
+
+private:
+    struct task
+    {
+        std::string name{};
+        runs_on where = runs_on::worker;
+        std::function<void()> fn{};
+        std::vector<task_id> dependencies{};
+        std::vector<task_id> dependents{};
+        std::size_t remaining = 0;
+        clock_type::time_point ready{};
+        clock_type::time_point started{};
+        clock_type::time_point finished{};
+    };
+
+    std::vector<task> m_tasks{};
+    worker_pool* m_pool = nullptr;
+    clock_type::time_point m_created;
+
+    std::mutex m_mutex{};
+    std::condition_variable m_changed{};
+    std::deque<task_id> m_gl_ready{};
+    std::size_t m_done = 0;
+
+    auto dispatch(task_id id) -> void;
+    auto run(task_id id) -> void;
+
+public:
+    task_graph(task_graph const&) = delete;
+    task_graph(task_graph&&) = delete;
+    ~task_graph() noexcept = default;
+
+    task_graph();
+
+    auto operator=(task_graph const&) -> task_graph& = delete;
+    auto operator=(task_graph&&) -> task_graph& = delete;
+
+    ///
+    /// Adds a task running after every task in `dependencies`, which must
+    /// have been added before. Only valid before `start`.
+    ///
+    auto add(std::string name, runs_on where, std::function<void()> fn, std::vector<task_id> const& dependencies = {})
+        -> task_id;
+
+    ///
+    /// Sends the tasks without dependencies off. `pool` must outlive the
+    /// graph's work, i.e. the `finish` call.
+    ///
+    auto start(worker_pool& pool) -> void;
+
+    ///
+    /// Runs GL tasks on the calling thread as they become ready, until every
+    /// task is done.
+    ///
+    auto finish() -> void;
+
+    ///
+    /// Logs the time from construction to `first_frame`, the time spent in
+    /// tasks and the critical path: the chain of tasks, each waiting on the
+    /// one before, that ended with the last one to finish.
+    ///
+    auto report(clock_type::time_point first_frame = clock_type::now()) const -> void;
+};
+
+#endif // !UTIL_TASK_GRAPH_HPP
@@ -0,0 +1,33 @@
+#ifndef UTIL_TEXTURE_HPP
+#define UTIL_TEXTURE_HPP
+#pragma once
+
+#include <glad/glad.h>
+
+///
+/// Owning handle to an OpenGL texture object. Binding goes through
+/// `gl_state`, so binding an already bound texture costs nothing.
+///
+class texture
+{
+private:
+    unsigned int m_id;
+    unsigned int m_target;
+
+public:
+    texture(texture const&) = delete;
+    texture(texture&& other) noexcept;
+    ~texture() noexcept;
+
+    explicit texture(unsigned int target = GL_TEXTURE_2D);
+
+    auto operator=(texture const&) -> texture& = delete;
+    auto operator=(texture&& other) noexcept -> texture&;
+
+    auto bind(unsigned int unit = 0) const noexcept -> void;
+
+    [[nodiscard]] auto id() const noexcept -> unsigned int;
+    [[nodiscard]] auto target() const noexcept -> unsigned int;
+};
+
+#endif // !UTIL_TEXTURE_HPP
@@ -0,0 +1,96 @@
+#ifndef UTIL_TEXTURE2D_HPP
+#define UTIL_TEXTURE2D_HPP
+#pragma once
+
+#include "util/texture.hpp"
+
+#include <cstddef>
+
+struct texture2d_params
+{
+    unsigned int wrap = GL_REPEAT;
+    unsigned int min_filter = GL_LINEAR_MIPMAP_LINEAR;
+    unsigned int mag_filter = GL_LINEAR;
+    /// Allocate the full mip chain and generate it on `upload`, otherwise the
+    /// texture only has level 0
+    bool mipmaps = true;
+};
+
+///
+/// `GL_TEXTURE_2D` with 8 bit channels whose size and format are fixed when it
+/// is created, see `allocate_texture_storage`. 1 and 2 channel textures sample
+/// as grey and grey/alpha, see `set_channel_swizzle`.
+///
+class texture2d
+{
+private:
+    texture m_texture{};
+    int m_width;
+    int m_height;
+    int m_channels;
+    int m_levels;
+
+public:
+    texture2d(int width, int height, int channels, texture2d_params const& params = {});
+
+    ///
+    /// Replaces level 0 with `pixels`, tightly packed rows of `channels`
+    /// bytes per pixel, and regenerates the other levels. `pixels` is an
+    /// offset instead while a `GL_PIXEL_UNPACK_BUFFER` is bound.
+    ///
+    auto upload(void const* pixels) const noexcept -> void;
+
+    auto bind(unsigned int unit = 0) const noexcept -> void;
+
+    ///
+    /// Hands the texture object over, e.g. to share it as a `texture`.
+    ///
+    [[nodiscard]] auto release() && noexcept -> texture;
+
+    [[nodiscard]] auto handle() const noexcept -> texture const&;
+    [[nodiscard]] auto width() const noexcept -> int;
+    [[nodiscard]] auto height() const noexcept -> int;
+    [[nodiscard]] auto channels() const noexcept -> int;
+    [[nodiscard]] auto levels() const noexcept -> int;
+};
+
+///
+/// Length of the full mip chain of a `width` x `height` image, down to 1x1.
+///
+[[nodiscard]] auto mip_levels(int width, int height) noexcept -> int;
+
+///
+/// Sized internal format for 1 to 4 channels, `GL_R8` to `GL_RGBA8`.
+///
+[[nodiscard]] auto internal_format_of(int channels) noexcept -> unsigned int;
+
+///
+/// Pixel transfer format for 1 to 4 channels, `GL_RED` to `GL_RGBA`.
+///
+[[nodiscard]] auto format_of(int channels) noexcept -> unsigned int;
+
+///
+/// Largest `GL_UNPACK_ALIGNMENT` (8, 4, 2 or 1) that tightly packed rows of
+/// `row_bytes` bytes satisfy.
+///
+[[nodiscard]] auto unpack_alignment_of(std::size_t row_bytes) noexcept -> int;
+
+///
+/// Makes a 1 or 2 channel texture bound to `target` sample as grey `(R, R, R, 1)`
+/// or grey and alpha `(R, R, R, G)`, like it did when it was expanded to
+/// RGB(A). Textures with 3 or 4 channels are left alone.
+///
+auto set_channel_swizzle(unsigned int target, int channels) noexcept -> void;
+
+///
+/// Binds `tex` and gives it `levels` levels of `internal_format`, the first
+/// one `width` x `height`, on the texture's own 2D target. Storage is allocated once with `glTexStorage2D`,
+/// so the driver never converts or reallocates anything on upload.
+///
+/// Without GL 4.2 / ARB_texture_storage every level is specified once with
+/// `glTexImage2D` instead, which ends up the same minus the immutability.
+///
+auto allocate_texture_storage(texture const& tex, int levels, unsigned int internal_format, int width, int height) noexcept
+    -> void;
+
+#endif // !UTIL_TEXTURE2D_HPP
@@ -0,0 +1,105 @@
+#ifndef UTIL_TEXTURE_ARRAY_HPP
+#define UTIL_TEXTURE_ARRAY_HPP
+#pragma once
+
+#include "util/texture.hpp"
+#include "util/texture2d.hpp"
+#include "util/texture_cache.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+///
+/// `GL_TEXTURE_2D_ARRAY` whose layers share one size and 8 bit format, with
+/// immutable storage for all of its levels. Objects sampling different layers
+/// can be drawn with one bind and, with the layer as a per-instance attribute,
+/// one draw call.
+///
+class texture_array
+{
+private:
+    texture m_texture{ GL_TEXTURE_2D_ARRAY };
+    int m_width;
+    int m_height;
+    int m_channels;
+    int m_layers;
+    int m_levels;
+
+public:
+    texture_array(int width, int height, int channels, int layers, texture2d_params const& params = {});
+
+    ///
+    /// Replaces level 0 of `layer` with `pixels`, tightly packed rows of
+    /// `channels` bytes per pixel. Call `generate_mipmaps` once every layer
+    /// is in.
+    ///
+    auto upload(int layer, void const* pixels) const noexcept -> void;
+    auto generate_mipmaps() const noexcept -> void;
+
+    auto bind(unsigned int unit = 0) const noexcept -> void;
+
+    [[nodiscard]] auto handle() const noexcept -> texture const&;
+    [[nodiscard]] auto width() const noexcept -> int;
+    [[nodiscard]] auto height() const noexcept -> int;
+    [[nodiscard]] auto channels() const noexcept -> int;
+    [[nodiscard]] auto layers() const noexcept -> int;
+    [[nodiscard]] auto levels() const noexcept -> int;
+};
+
+///
+/// Where an image ended up in a `texture_array`. Laid out to be read straight
+/// from a buffer as a per-instance attribute,
+///
+///     layout(location = N) in vec3 layer; // uv scale, layer
+///     texture(textures, vec3(uv * layer.xy, layer.z))
+///
+struct array_layer
+{
+    glm::vec2 uv_scale{ 1.0F };
+    float index = 0.0F;
+};
+
+static_assert(sizeof(array_layer) == 3 * sizeof(float), "array_layer has padding!");
+
+///
+/// Packs images into one `texture_array`. Layers take the size of the largest
+/// image and the most channels of any image (RGBA if some are RGB and others
+/// grey-alpha): smaller images sit in the corner of their layer, padded by
+/// repeating their last row and column so filtering doesn't bleed in black,
+/// and are sampled through `uv_scale`. Missing channels are filled in the way
+/// OpenGL expands formats (grey to RGB, opaque alpha).
+///
+/// Wrapping only works for images the size of the layer, padded ones need
+/// `fract(uv) * uv_scale` in the shader to repeat.
+///
+class texture_array_builder
+{
+private:
+    std::vector<image> m_images{};
+    int m_width = 0;
+    int m_height = 0;
+    int m_channels = 0;
+    bool m_has_alpha = false;
+
+public:
+    ///
+    /// Adds `img`, returns its layer.
+    ///
+    auto add(image img) -> std::size_t;
+
+    ///
+    /// Placement of `layer`, final once every image is added.
+    ///
+    [[nodiscard]] auto layer(std::size_t layer) const noexcept -> array_layer;
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    ///
+    /// Uploads every image into a new array and generates its mipmaps. Logs
+    /// if there are more layers than `GL_MAX_ARRAY_TEXTURE_LAYERS`.
+    ///
+    [[nodiscard]] auto build(texture2d_params const& params = {}) const -> texture_array;
+};
+
+#endif // !UTIL_TEXTURE_ARRAY_HPP
@@ -0,0 +1,131 @@
+#ifndef UTIL_TEXTURE_CACHE_HPP
+#define UTIL_TEXTURE_CACHE_HPP
+#pragma once
+
+#include "util/mapped_file.hpp"
+#include "util/texture.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+///
+/// How an image file is turned into pixels, part of the cache key.
+///
+struct image_params
+{
+    bool flip_vertically = false;
+    /// 1 to 4 to force that many channels, 0 keeps what the file has
+    int channels = 0;
+};
+
+///
+/// Decoded image, rows tightly packed, 8 bits per channel.
+///
+struct image
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<unsigned char> pixels{};
+};
+
+///
+/// Textures keyed by the hash of the file contents plus the decode
+/// parameters, so copies of one image under different paths share a texture.
+///
+/// Within a process a texture is decoded and uploaded once and handed out as
+/// long as somebody holds it. Decoded pixels are also written to `directory`,
+/// later launches read them back instead of decoding the JPEG/PNG again. By
+/// default the directory sits in the build tree and is shared by every
+/// example.
+///
+/// Files are memory mapped and decoded straight from the mapping.
+///
+/// Textures get `allocate_texture_storage`'s immutable storage for the whole
+/// mip chain, repeat wrapping and trilinear filtering.
+/// Decoding doesn't use stb's global flip setting, leave it untouched.
+///
+class texture_cache
+{
+public:
+    struct statistics
+    {
+        std::size_t memory_hits = 0;
+        std::size_t disk_hits = 0;
+        std::size_t decodes = 0;
+        std::size_t failures = 0;
+    };
+
+private:
+    struct counters
+    {
+        std::atomic<std::size_t> memory_hits{ 0 };
+        std::atomic<std::size_t> disk_hits{ 0 };
+        std::atomic<std::size_t> decodes{ 0 };
+        std::atomic<std::size_t> failures{ 0 };
+    };
+
+    std::string m_directory;
+    std::unordered_map<std::uint64_t, std::weak_ptr<texture>> m_textures{};
+    counters m_stats{};
+
+    [[nodiscard]] static auto key_of(mapped_file const& contents, image_params const& params) noexcept -> std::uint64_t;
+
+    [[nodiscard]] auto path_of(std::uint64_t key) const -> std::string;
+    [[nodiscard]] auto decode(std::string const& path,
+                              mapped_file const& contents,
+                              std::uint64_t key,
+                              image_params const& params,
+                              image& result) -> bool;
+    [[nodiscard]] auto read_pixels(std::uint64_t key, image& result) const -> bool;
+    auto write_pixels(std::uint64_t key, image const& decoded) const -> void;
+
+public:
+    texture_cache(texture_cache const&) = delete;
+    texture_cache(texture_cache&&) = delete;
+    ~texture_cache() noexcept = default;
+
+    explicit texture_cache(std::string directory = default_directory());
+
+    auto operator=(texture_cache const&) -> texture_cache& = delete;
+    auto operator=(texture_cache&&) -> texture_cache& = delete;
+
+    ///
+    /// Directory shared by all examples, set up by the build.
+    ///
+    [[nodiscard]] static auto default_directory() -> std::string;
+
+    ///
+    /// Pixels of `path`, from the disk cache if they are there. Returns
+    /// `false` and logs if the file can't be read or decoded. Doesn't touch
+    /// OpenGL and may be called from several threads at once.
+    ///
+    [[nodiscard]] auto load_image(std::string const& path, image_params const& params, image& result) -> bool;
+
+    ///
+    /// Texture for `path`, shared with every other live request for the same
+    /// contents and parameters. Returns `nullptr` and logs on failure.
+    ///
+    [[nodiscard]] auto load(std::string const& path, image_params const& params = {}) -> std::shared_ptr<texture>;
+
+    [[nodiscard]] auto stats() const noexcept -> statistics;
+};
+
+///
+/// Uploads `img` to a new `texture2d` with default parameters, generates its
+/// mipmaps and hands its texture over.
+///
+[[nodiscard]] auto upload_image(image const& img) noexcept -> texture;
+
+///
+/// Same as `upload_image` for tightly packed pixels at `pixels`, which is an
+/// offset instead of a pointer while a `GL_PIXEL_UNPACK_BUFFER` is bound.
+///
+[[nodiscard]] auto upload_pixels(int width, int height, int channels, void const* pixels) noexcept -> texture;
+
+#endif // !UTIL_TEXTURE_CACHE_HPP
@@ -0,0 +1,161 @@
+#ifndef UTIL_TEXTURE_RESIDENCY_HPP
+#define UTIL_TEXTURE_RESIDENCY_HPP
+#pragma once
+
+#include "util/baked_texture.hpp"
+#include "util/mapped_file.hpp"
+#include "util/texture.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+class worker_pool;
+
+///
+/// Keeps baked textures (see `baked_texture.hpp`) within a memory budget by
+/// only keeping the mip levels they need on screen resident.
+///
+/// The files stay mapped and act as the backing store: changing what is
+/// resident recreates the texture's (immutable) storage from another level of
+/// the file, without any decoding. Textures start from a small level and are
+/// streamed up as `request` asks for more detail. When the requested detail
+/// doesn't fit the budget, the least recently requested textures are
+/// downgraded first, down to a level of at most `floor_size` pixels, below
+/// which a texture counts as evicted.
+///
+/// Sizes are estimated from the bytes of every resident level, compressed
+/// levels included as stored.
+///
+/// Levels an upgrade needs are read once on `pool` first, so faulting them
+/// in from disk doesn't stall the GL thread, and uploaded by a later `update`.
+/// Files compressed in a format the driver can't sample are decoded on
+/// `pool`, keeping the placeholder until `update` picks the result up.
+///
+class texture_residency
+{
+public:
+    using handle = std::size_t;
+
+    struct statistics
+    {
+        std::size_t resident_bytes = 0;
+        std::size_t upgrades = 0;
+        std::size_t downgrades = 0;
+        std::size_t evictions = 0;
+        std::size_t uploaded_bytes = 0;
+    };
+
+private:
+    struct decode_job;
+    struct prefetch_job;
+
+    struct entry
+    {
+        std::string path{};
+        std::optional<mapped_file> file{};
+        baked_texture_view view{};
+        /// Whole chain decoded up front when the driver lacks its compression
+        std::vector<image> decoded{};
+        /// Set while `decoded` is being filled on the pool
+        std::shared_ptr<decode_job> decoding{};
+        /// Set while the levels of an upgrade are being read on the pool
+        std::shared_ptr<prefetch_job> prefetching{};
+        /// Bytes of the levels from `i` down, one more than there are levels
+        std::vector<std::size_t> bytes_from{};
+
+        texture tex{};
+        std::uint32_t first_level = 0;
+        std::uint32_t wanted_level = 0;
+        std::uint32_t floor_level = 0;
+        /// Finest level whose pages were read recently, uploading from it
+        /// shouldn't fault
+        std::uint32_t prefetched_level = 0;
+        /// Finest level `request`-ed this frame, `levels` if none
+        std::uint32_t requested_level = 0;
+        std::uint64_t last_used = 0;
+    };
+
+    worker_pool* m_pool;
+    std::vector<entry> m_entries{};
+    std::size_t m_budget;
+    std::size_t m_upload_budget;
+    std::uint64_t m_frame = 0;
+    texture m_placeholder{};
+    statistics m_stats{};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_job_finished{};
+    std::size_t m_in_flight = 0;
+
+    [[nodiscard]] static auto available(entry const& e) noexcept -> bool;
+
+    auto make_resident(entry& e, std::uint32_t level) -> void;
+    auto start(entry& e) -> void;
+    auto prefetch(entry& e, std::uint32_t level) -> void;
+    auto collect_decoded() -> void;
+    auto collect_prefetched() -> void;
+
+public:
+    static constexpr int floor_size = 16;
+    ///
+    /// Frames without a `request` after which a texture is only kept at its
+    /// floor level.
+    ///
+    static constexpr std::uint64_t idle_frames = 120;
+    static constexpr std::size_t default_upload_budget = 8 * 1024 * 1024;
+
+    texture_residency(texture_residency const&) = delete;
+    texture_residency(texture_residency&&) = delete;
+    ~texture_residency() noexcept;
+
+    ///
+    /// Must be created on the GL thread. `pool` must outlive the manager.
+    /// `upload_budget` caps the bytes uploaded for upgrades per `update`,
+    /// downgrades always go through.
+    ///
+    texture_residency(worker_pool& pool, std::size_t budget, std::size_t upload_budget = default_upload_budget);
+
+    auto operator=(texture_residency const&) -> texture_residency& = delete;
+    auto operator=(texture_residency&&) -> texture_residency& = delete;
+
+    ///
+    /// Maps the baked texture at `path` and uploads its floor level, or
+    /// starts decoding it. Failures are logged and get the placeholder.
+    ///
+    [[nodiscard]] auto add(std::string const& path) -> handle;
+
+    ///
+    /// Marks `h` as used this frame, covering about `screen_pixels` pixels
+    /// across, which decides the finest level worth having.
+    ///
+    auto request(handle h, float screen_pixels) noexcept -> void;
+
+    ///
+    /// Uploads the floor level of textures done decoding, plans what is
+    /// resident from this frame's requests, applies the downgrades and as
+    /// many prefetched upgrades as the upload budget allows, and starts
+    /// prefetching the rest. Call once per frame on the GL thread, after the
+    /// `request`s.
+    ///
+    auto update() -> void;
+
+    ///
+    /// The texture of `h`, with whatever levels are resident.
+    ///
+    [[nodiscard]] auto get(handle h) const noexcept -> texture const&;
+
+    ///
+    /// Level of the file that is the texture's level 0 right now.
+    ///
+    [[nodiscard]] auto resident_level(handle h) const noexcept -> std::uint32_t;
+    [[nodiscard]] auto budget() const noexcept -> std::size_t;
+    [[nodiscard]] auto stats() const noexcept -> statistics const&;
+};
+
+#endif // !UTIL_TEXTURE_RESIDENCY_HPP
@@ -0,0 +1,141 @@
+#ifndef UTIL_TEXTURE_STREAMER_HPP
+#define UTIL_TEXTURE_STREAMER_HPP
+#pragma once
+
+#include "util/texture.hpp"
+#include "util/texture_cache.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class worker_pool;
+
+///
+/// Loads textures in the background: files are decoded (or read back from
+/// the `texture_cache` directory) on `pool`, copied by the worker into a
+/// persistently mapped pixel unpack buffer, and turned into textures on the
+/// GL thread by `update`, which stops once its time budget is spent.
+///
+/// `get` returns a small grey placeholder until a texture has arrived, so
+/// callers can bind it every frame without caring.
+///
+/// Without `glBufferStorage` (GL 4.4 / ARB_buffer_storage), for images bigger
+/// than the staging buffer, or while it is full, pixels stay in worker memory
+/// and are uploaded from there.
+///
+/// Paths ending in `.btex` are baked textures (see `baked_texture.hpp`): the
+/// worker only maps and checks the file, the levels are uploaded from the
+/// mapping without decoding, staging or mipmap generation. Block compressed
+/// ones the driver can't sample are decoded on the worker instead.
+/// `image_params` don't apply to them, flipping, channels and compression
+/// are chosen when baking.
+///
+class texture_streamer
+{
+public:
+    using handle = std::size_t;
+
+    struct statistics
+    {
+        std::size_t requested = 0;
+        std::size_t uploaded = 0;
+        std::size_t failed = 0;
+        /// Uploads that went through the staging buffer
+        std::size_t staged = 0;
+    };
+
+private:
+    struct job;
+
+    ///
+    /// Staging buffer region, released in allocation order once the GPU is
+    /// done reading it.
+    ///
+    struct region
+    {
+        std::size_t begin;
+        std::size_t size;
+        GLsync fence;
+        bool uploaded;
+    };
+
+    worker_pool* m_pool;
+    texture_cache* m_cache;
+
+    texture m_placeholder{};
+    std::vector<std::shared_ptr<texture>> m_textures{};
+    std::unordered_map<std::string, handle> m_handles{};
+
+    unsigned int m_staging;
+    unsigned char* m_mapped;
+    std::size_t m_capacity;
+    std::size_t m_head;
+    std::deque<region> m_regions{};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_job_finished{};
+    std::vector<std::shared_ptr<job>> m_finished{};
+    std::size_t m_in_flight;
+
+    // Finished jobs waiting for their upload, only touched on the GL thread
+    std::deque<std::shared_ptr<job>> m_ready{};
+    statistics m_stats{};
+
+    [[nodiscard]] auto try_allocate(std::size_t size) -> std::size_t;
+    auto release_regions() -> void;
+    auto run(std::shared_ptr<job> const& j) -> void;
+
+public:
+    static constexpr std::size_t default_staging_bytes = 64 * 1024 * 1024;
+
+    texture_streamer(texture_streamer const&) = delete;
+    texture_streamer(texture_streamer&&) = delete;
+    ~texture_streamer() noexcept;
+
+    ///
+    /// Must be created on the GL thread. `pool` and `cache` must outlive the
+    /// streamer.
+    ///
+    texture_streamer(worker_pool& pool, texture_cache& cache, std::size_t staging_bytes = default_staging_bytes);
+
+    auto operator=(texture_streamer const&) -> texture_streamer& = delete;
+    auto operator=(texture_streamer&&) -> texture_streamer& = delete;
+
+    ///
+    /// Starts loading `path` unless it was already requested with the same
+    /// parameters, in which case the earlier handle is returned.
+    ///
+    [[nodiscard]] auto request(std::string const& path, image_params const& params = {}) -> handle;
+
+    ///
+    /// Uploads finished images until `budget` is spent (at least one per
+    /// call), and recycles staging memory the GPU is done with. Call once per
+    /// frame on the GL thread. `microseconds::max()` means no limit.
+    ///
+    auto update(std::chrono::microseconds budget = std::chrono::microseconds{ 2'000 }) -> void;
+
+    ///
+    /// Keeps calling `update` until every request is uploaded or failed.
+    ///
+    auto finish() -> void;
+
+    [[nodiscard]] auto ready(handle h) const noexcept -> bool;
+
+    ///
+    /// The texture of `h`, or the placeholder while it is loading or if it
+    /// failed to load.
+    ///
+    [[nodiscard]] auto get(handle h) const noexcept -> texture const&;
+
+    [[nodiscard]] auto pending() const noexcept -> std::size_t;
+    [[nodiscard]] auto stats() const noexcept -> statistics const&;
+};
+
+#endif // !UTIL_TEXTURE_STREAMER_HPP
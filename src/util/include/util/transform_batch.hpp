@@ -0,0 +1,91 @@
+#ifndef UTIL_TRANSFORM_BATCH_HPP
+#define UTIL_TRANSFORM_BATCH_HPP
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class worker_pool;
+
+///
+/// Objects spinning in place, stored as structure of arrays so model matrices
+/// can be computed several objects at a time.
+///
+/// The model matrix of object `i` at `time` is
+///
+///     translate(position[i]) * toMat4(angleAxis(speed[i] * time, axis[i]))
+///
+/// The axis is used as given, exactly like `glm::angleAxis` does, so pass a
+/// unit axis for a pure rotation.
+///
+class transform_batch
+{
+private:
+    std::vector<float> m_px{};
+    std::vector<float> m_py{};
+    std::vector<float> m_pz{};
+    std::vector<float> m_ax{};
+    std::vector<float> m_ay{};
+    std::vector<float> m_az{};
+    std::vector<float> m_speed{};
+
+public:
+    auto reserve(std::size_t count) -> void;
+    auto clear() noexcept -> void;
+
+    ///
+    /// `angular_speed` is in radians per second.
+    ///
+    auto add(glm::vec3 const& position, glm::vec3 const& axis, float angular_speed) -> void;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    ///
+    /// Number of objects processed per iteration by `compute_simd`: 8 with
+    /// AVX, 4 with SSE2, 1 otherwise.
+    ///
+    [[nodiscard]] static auto simd_width() noexcept -> std::size_t;
+
+    ///
+    /// Writes the model matrices of objects `[begin, end)` to `out[begin]`
+    /// onwards, one object at a time with `std::sin`/`std::cos`.
+    ///
+    auto compute_scalar(float time, glm::mat4* out, std::size_t begin, std::size_t end) const noexcept -> void;
+
+    ///
+    /// Same as `compute_scalar`, `simd_width()` objects at a time with a
+    /// polynomial sine/cosine. Matches `compute_scalar` to about 1e-7 while
+    /// `angular_speed * time` stays below ~16000 radians, past that the range
+    /// reduction loses precision (so does the float angle itself).
+    ///
+    auto compute_simd(float time, glm::mat4* out, std::size_t begin, std::size_t end) const noexcept -> void;
+
+    ///
+    /// Writes the matrix of object `indices[k]` to `out[k]` for every `k` in
+    /// `[begin, end)`, e.g. for the visible list of a `frustum_culler`.
+    ///
+    auto compute_simd(float time, std::uint32_t const* indices, glm::mat4* out, std::size_t begin, std::size_t end)
+        const noexcept -> void;
+
+    ///
+    /// Computes every matrix with `compute_simd`, split across `pool` if given.
+    /// `out` needs room for `size()` matrices and may point into a mapped
+    /// buffer.
+    ///
+    auto compute(float time, glm::mat4* out, worker_pool* pool = nullptr) const -> void;
+
+    ///
+    /// Computes the matrices of the `count` objects in `indices`, packed into
+    /// `out[0]` to `out[count - 1]`.
+    ///
+    auto compute(float time,
+                 std::uint32_t const* indices,
+                 std::size_t count,
+                 glm::mat4* out,
+                 worker_pool* pool = nullptr) const -> void;
+};
+
+#endif // !UTIL_TRANSFORM_BATCH_HPP
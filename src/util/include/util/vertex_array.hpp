@@ -0,0 +1,28 @@
+#ifndef UTIL_VERTEX_ARRAY_HPP
+#define UTIL_VERTEX_ARRAY_HPP
+#pragma once
+
+///
+/// Owning handle to a vertex array object, bound through `gl_state`.
+///
+class vertex_array
+{
+private:
+    unsigned int m_id;
+
+public:
+    vertex_array();
+    vertex_array(vertex_array const&) = delete;
+    vertex_array(vertex_array&& other) noexcept;
+    ~vertex_array() noexcept;
+
+    auto operator=(vertex_array const&) -> vertex_array& = delete;
+    auto operator=(vertex_array&& other) noexcept -> vertex_array&;
+
+    auto bind() const noexcept -> void;
+    static auto unbind() noexcept -> void;
+
+    [[nodiscard]] auto id() const noexcept -> unsigned int;
+};
+
+#endif // !UTIL_VERTEX_ARRAY_HPP
@@ -0,0 +1,185 @@
+#ifndef UTIL_VERTEX_LAYOUT_HPP
+#define UTIL_VERTEX_LAYOUT_HPP
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+class vertex_array;
+
+///
+/// Formats an attribute can be stored in. The shader always reads floats:
+/// normalized integers arrive in [-1, 1] (snorm) or [0, 1] (unorm).
+///
+namespace vertex_format {
+
+/// IEEE half float, 16 bits
+struct half
+{
+    std::uint16_t bits;
+};
+
+template<typename Component, int Components, bool Normalized = false>
+struct format
+{
+    using component_type = Component;
+
+    static constexpr int components = Components;
+    static constexpr bool normalized = Normalized;
+    static constexpr std::size_t size = sizeof(Component) * static_cast<std::size_t>(Components);
+};
+
+using vec2 = format<float, 2>;
+using vec3 = format<float, 3>;
+using vec4 = format<float, 4>;
+
+using half2 = format<half, 2>;
+using half4 = format<half, 4>;
+
+using snorm8x4 = format<std::int8_t, 4, true>;
+using unorm8x4 = format<std::uint8_t, 4, true>;
+using snorm16x2 = format<std::int16_t, 2, true>;
+using snorm16x4 = format<std::int16_t, 4, true>;
+using unorm16x2 = format<std::uint16_t, 2, true>;
+using unorm16x4 = format<std::uint16_t, 4, true>;
+
+template<typename Component>
+[[nodiscard]] constexpr auto gl_type() noexcept -> unsigned int
+{
+    if constexpr(std::is_same_v<Component, float>) {
+        return GL_FLOAT;
+    }
+    else if constexpr(std::is_same_v<Component, half>) {
+        return GL_HALF_FLOAT;
+    }
+    else if constexpr(std::is_same_v<Component, std::int8_t>) {
+        return GL_BYTE;
+    }
+    else if constexpr(std::is_same_v<Component, std::uint8_t>) {
+        return GL_UNSIGNED_BYTE;
+    }
+    else if constexpr(std::is_same_v<Component, std::int16_t>) {
+        return GL_SHORT;
+    }
+    else {
+        static_assert(std::is_same_v<Component, std::uint16_t>, "Unsupported vertex component type");
+        return GL_UNSIGNED_SHORT;
+    }
+}
+
+} // namespace vertex_format
+
+///
+/// One attribute of a `vertex_layout`, read by the shader as
+/// `layout(location = Location) in ...`.
+///
+template<unsigned int Location, typename Format>
+struct attr
+{
+    static constexpr unsigned int location = Location;
+    using format = Format;
+};
+
+///
+/// Attribute as `vertex_layout` hands it to GL, `offset` bytes into a vertex.
+///
+struct vertex_attribute
+{
+    unsigned int location = 0;
+    int components = 0;
+    unsigned int type = GL_FLOAT;
+    bool normalized = false;
+    std::size_t offset = 0;
+};
+
+///
+/// Points the attributes at `vbo` through `binding`. Uses
+/// `glVertexAttribFormat`/`glVertexAttribBinding` on GL 4.3 or with
+/// ARB_vertex_attrib_binding, `glVertexAttribPointer` otherwise.
+///
+auto apply_vertex_attributes(vertex_array const& vao,
+                             unsigned int vbo,
+                             std::size_t stride,
+                             vertex_attribute const* attributes,
+                             std::size_t count,
+                             unsigned int binding,
+                             unsigned int divisor) noexcept -> void;
+
+///
+/// Interleaved vertex format, with offsets and stride worked out at compile
+/// time from the attributes in order:
+///
+///     using cube_layout = vertex_layout<attr<0, vertex_format::vec3>, attr<1, vertex_format::vec2>>;
+///     cube_layout::apply(vao, vbo);
+///
+/// Storing an attribute more compactly is a matter of changing its format,
+/// e.g. `vertex_format::half2` texture coordinates. Every attribute has to
+/// keep 4 byte alignment, which is what GPUs fetch fastest.
+///
+template<typename... Attributes>
+class vertex_layout
+{
+private:
+    static constexpr std::size_t count = sizeof...(Attributes);
+
+    [[nodiscard]] static constexpr auto make_attributes() noexcept -> std::array<vertex_attribute, count>
+    {
+        std::array<vertex_attribute, count> result{ vertex_attribute{
+            Attributes::location,
+            Attributes::format::components,
+            vertex_format::gl_type<typename Attributes::format::component_type>(),
+            Attributes::format::normalized,
+            0 }... };
+
+        constexpr std::array<std::size_t, count> sizes{ Attributes::format::size... };
+        std::size_t offset = 0;
+
+        for(std::size_t i = 0; i < count; ++i) {
+            result[i].offset = offset;
+            offset += sizes[i];
+        }
+
+        return result;
+    }
+
+public:
+    static_assert(count > 0, "A vertex layout needs at least one attribute");
+
+    static constexpr std::array<vertex_attribute, count> attributes = make_attributes();
+    static constexpr std::size_t stride = (Attributes::format::size + ...);
+
+    static_assert(((Attributes::format::size % 4 == 0) && ...), "Vertex attributes have to be 4 byte aligned");
+
+    template<unsigned int Location>
+    [[nodiscard]] static constexpr auto offset_of() noexcept -> std::size_t
+    {
+        for(vertex_attribute const& attribute : attributes) {
+            if(attribute.location == Location) {
+                return attribute.offset;
+            }
+        }
+
+        return stride;
+    }
+
+    ///
+    /// Sets the layout up on `vao`, reading from `vbo`. `divisor` 1 advances
+    /// the attributes once per instance instead of once per vertex. The
+    /// binding defaults to the first attribute's location, which is the one
+    /// `glVertexAttribPointer` would use for it, so layouts and attributes set
+    /// up the old way can share a vertex array.
+    ///
+    static auto apply(vertex_array const& vao,
+                      unsigned int const vbo,
+                      unsigned int const divisor = 0,
+                      unsigned int const binding = attributes[0].location) noexcept -> void
+    {
+        apply_vertex_attributes(vao, vbo, stride, attributes.data(), count, binding, divisor);
+    }
+};
+
+#endif // !UTIL_VERTEX_LAYOUT_HPP
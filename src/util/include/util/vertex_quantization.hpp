@@ -0,0 +1,91 @@
+#ifndef UTIL_VERTEX_QUANTIZATION_HPP
+#define UTIL_VERTEX_QUANTIZATION_HPP
+#pragma once
+
+#include "util/mesh_optimizer.hpp"
+#include "util/vertex_layout.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+class shader;
+
+///
+/// Where the attributes of a float `mesh` vertex start, in floats. Positions
+/// are three floats, texture coordinates two and normals three.
+///
+struct quantize_attributes
+{
+    static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    std::size_t position = 0;
+    std::size_t uv = none;
+    std::size_t normal = none;
+};
+
+///
+/// Mesh with its vertices stored as
+///
+///   - position: snorm16x4, xyz relative to the mesh's bounds, w unused
+///   - uv: unorm16x2 relative to the bounds of the texture coordinates
+///   - normal: snorm16x2, octahedral encoded
+///
+/// in that order, leaving out the ones the source didn't have. The vertex
+/// shader undoes the bounds with the uniforms `set_quantization_uniforms`
+/// sets; the `QUANTIZED` blocks of the cube shaders show how, normals
+/// included (`decode_octahedral`).
+///
+struct quantized_mesh
+{
+    std::vector<std::uint8_t> vertices{};
+    /// Bytes per vertex
+    std::size_t stride = 0;
+    std::vector<std::uint32_t> indices{};
+
+    /// `position = decoded * position_scale + position_offset`
+    glm::vec4 position_scale{ 1.0F };
+    glm::vec4 position_offset{ 0.0F };
+    /// `uv = decoded * uv_transform.xy + uv_transform.zw`
+    glm::vec4 uv_transform{ 1.0F, 1.0F, 0.0F, 0.0F };
+
+    [[nodiscard]] auto vertex_count() const noexcept -> std::size_t;
+};
+
+template<unsigned int Position, unsigned int Uv>
+using quantized_layout = vertex_layout<attr<Position, vertex_format::snorm16x4>, attr<Uv, vertex_format::unorm16x2>>;
+
+template<unsigned int Position, unsigned int Uv, unsigned int Normal>
+using quantized_normal_layout = vertex_layout<attr<Position, vertex_format::snorm16x4>,
+                                              attr<Uv, vertex_format::unorm16x2>,
+                                              attr<Normal, vertex_format::snorm16x2>>;
+
+[[nodiscard]] auto quantize_snorm16(float value) noexcept -> std::int16_t;
+[[nodiscard]] auto quantize_unorm16(float value) noexcept -> std::uint16_t;
+
+///
+/// Maps a unit vector onto the octahedron unfolded into [-1, 1]², which
+/// keeps the error even over the sphere with just two components. A zero
+/// vector comes out as (0, 0), which decodes to +z.
+///
+[[nodiscard]] auto encode_octahedral(glm::vec3 const& normal) noexcept -> glm::vec2;
+[[nodiscard]] auto decode_octahedral(glm::vec2 const& encoded) noexcept -> glm::vec3;
+
+///
+/// Quantizes `source` and logs the bytes per vertex, vertex memory before
+/// and after and the largest position error under `name`.
+///
+[[nodiscard]] auto quantize_mesh(mesh const& source, quantize_attributes const& attributes, std::string const& name)
+    -> quantized_mesh;
+
+///
+/// Sets `quantized_position_scale`, `quantized_position_offset` and
+/// `quantized_uv_transform`. `program` must be in use.
+///
+auto set_quantization_uniforms(shader const& program, quantized_mesh const& m) noexcept -> void;
+
+#endif // !UTIL_VERTEX_QUANTIZATION_HPP
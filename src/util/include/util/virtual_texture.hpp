@@ -0,0 +1,243 @@
+#ifndef UTIL_VIRTUAL_TEXTURE_HPP
+#define UTIL_VIRTUAL_TEXTURE_HPP
+#pragma once
+
+#include "util/baked_texture.hpp"
+#include "util/mapped_file.hpp"
+#include "util/shader.hpp"
+#include "util/texture.hpp"
+#include "util/texture_cache.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class worker_pool;
+
+///
+/// Virtual texture file (`.vtex`), written by the TextureBaker tool with
+/// `--virtual`:
+///
+///     virtual_texture_header
+///     virtual_level[levels]    largest level first
+///     pages of every level     from a 16 byte aligned offset, row by row
+///
+/// Every level of the mip chain is cut into `page_size` squared RGBA8 pages,
+/// each stored with `border` extra texels on every side (clamped at the
+/// edges of the level) so bilinear filtering never reads a neighbouring page.
+/// Levels stop at the first one that fits a single page.
+///
+struct virtual_texture_header
+{
+    static constexpr std::uint32_t file_magic = 0x58455456; // "VTEX"
+    static constexpr std::uint32_t file_version = 1;
+
+    std::uint32_t magic = file_magic;
+    std::uint32_t version = file_version;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t levels = 0;
+    std::uint32_t page_size = 0;
+    std::uint32_t border = 0;
+    /// Sized format of the pages, e.g. `GL_RGBA8`
+    std::uint32_t internal_format = 0;
+};
+
+struct virtual_level
+{
+    /// Index of the level's first page among all pages of the file
+    std::uint64_t first_page = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t pages_x = 0;
+    std::uint32_t pages_y = 0;
+};
+
+static_assert(sizeof(virtual_texture_header) == 32, "virtual_texture_header has padding!");
+static_assert(sizeof(virtual_level) == 24, "virtual_level has padding!");
+
+///
+/// Checked view of a virtual texture in memory, pointing into the given bytes.
+///
+struct virtual_texture_view
+{
+    virtual_texture_header const* header = nullptr;
+    virtual_level const* levels = nullptr;
+    unsigned char const* pages = nullptr;
+
+    /// Bytes of one stored page, border included
+    [[nodiscard]] auto page_bytes() const noexcept -> std::size_t;
+    [[nodiscard]] auto page(std::uint32_t level, std::uint32_t x, std::uint32_t y) const noexcept
+        -> unsigned char const*;
+};
+
+///
+/// Mip chain of `source` (filtered like `bake_texture`) cut into pages, in the
+/// file layout above. `page_size` should be a power of two.
+///
+[[nodiscard]] auto bake_virtual_texture(image const& source,
+                                        std::uint32_t page_size,
+                                        std::uint32_t border,
+                                        bake_options const& options = {}) -> std::vector<unsigned char>;
+
+///
+/// Checks the header and that every page lies within `size` bytes. Returns
+/// `false` and logs with `name` otherwise.
+///
+[[nodiscard]] auto parse_virtual_texture(unsigned char const* data,
+                                         std::size_t size,
+                                         std::string const& name,
+                                         virtual_texture_view& view) -> bool;
+
+///
+/// Page of a virtual texture some pixel on screen wants, as read back by
+/// `page_feedback`.
+///
+struct page_request
+{
+    std::uint16_t x = 0;
+    std::uint16_t y = 0;
+    std::uint16_t level = 0;
+};
+
+///
+/// Software virtual texture: a huge image sampled through a fixed size page
+/// cache, so its memory is bounded by what is visible instead of by its size.
+///
+/// Two textures are involved:
+///
+///     - the cache, a `cache_side` squared grid of page slots (border
+///       included) that pages get copied into as they are needed
+///     - the indirection, one RGBA8UI texel per page of every level, holding
+///       the slot of the page in x/y and the level it really comes from in z.
+///       Pages that aren't resident point at their closest resident ancestor,
+///       the single page of the last level is always resident.
+///
+/// Pages get requested from a feedback pass (see `page_feedback`), copied out
+/// of the mapped file on the worker pool and uploaded by `update`, a few per
+/// frame. Slots not requested for a while are reused least recently used
+/// first. See VirtualTexturing's `floor.fs.glsl` for how shaders sample it
+/// and `set_uniforms` for what they need.
+///
+/// No ARB_sparse_texture involved, everything is plain GL 3.3.
+///
+class virtual_texture
+{
+public:
+    struct statistics
+    {
+        std::size_t requested = 0;
+        std::size_t uploaded = 0;
+        std::size_t evicted = 0;
+        /// Pages that arrived while every slot was in use this frame
+        std::size_t dropped = 0;
+    };
+
+private:
+    struct job
+    {
+        std::uint64_t key = 0;
+        std::vector<unsigned char> pixels{};
+    };
+
+    struct slot
+    {
+        /// `no_page` while free
+        std::uint64_t key = 0;
+        std::uint64_t last_used = 0;
+        bool pinned = false;
+    };
+
+    worker_pool* m_pool;
+    std::unique_ptr<mapped_file> m_file;
+    virtual_texture_view m_view{};
+    bool m_valid = false;
+
+    texture m_cache{};
+    texture m_indirection{};
+    std::uint32_t m_cache_side;
+    std::size_t m_uploads_per_frame;
+    std::uint32_t m_indirection_width = 0;
+    std::uint32_t m_indirection_height = 0;
+
+    std::vector<slot> m_slots{};
+    /// Page key to slot index of every resident page
+    std::unordered_map<std::uint64_t, std::size_t> m_resident{};
+    /// Requested pages not resident yet
+    std::unordered_set<std::uint64_t> m_loading{};
+    /// CPU copy of every indirection level, rebuilt when pages come and go
+    std::vector<std::vector<unsigned char>> m_entries{};
+    bool m_dirty = false;
+    std::uint64_t m_frame = 1;
+
+    std::mutex m_mutex{};
+    std::deque<std::unique_ptr<job>> m_finished{};
+    std::size_t m_in_flight = 0;
+    std::condition_variable m_job_finished{};
+
+    statistics m_stats{};
+
+    [[nodiscard]] auto key_of(std::uint32_t level, std::uint32_t x, std::uint32_t y) const noexcept -> std::uint64_t;
+    [[nodiscard]] auto take_slot() -> std::size_t;
+    auto upload_page(std::size_t slot_index, std::uint64_t key, unsigned char const* pixels) noexcept -> void;
+    auto rebuild_indirection() -> void;
+
+public:
+    static constexpr std::uint64_t no_page = ~std::uint64_t{ 0 };
+
+    virtual_texture() = delete;
+    virtual_texture(virtual_texture const&) = delete;
+    virtual_texture(virtual_texture&&) = delete;
+    ~virtual_texture() noexcept;
+
+    ///
+    /// Maps `path` and makes its last level resident. The cache holds
+    /// `cache_side * cache_side` pages, at most `uploads_per_frame` of which
+    /// are uploaded by each `update`. Check `valid()` afterwards.
+    ///
+    virtual_texture(worker_pool& pool,
+                    std::string const& path,
+                    std::uint32_t cache_side = 16,
+                    std::size_t uploads_per_frame = 8);
+
+    auto operator=(virtual_texture const&) -> virtual_texture& = delete;
+    auto operator=(virtual_texture&&) -> virtual_texture& = delete;
+
+    [[nodiscard]] auto valid() const noexcept -> bool;
+
+    ///
+    /// Marks the pages in `requests` as used this frame and starts loading
+    /// the ones that aren't resident, coarsest first so fallbacks arrive
+    /// early.
+    ///
+    auto request(std::vector<page_request> const& requests) -> void;
+
+    ///
+    /// Uploads pages the workers finished and refreshes the indirection if
+    /// anything changed. Meant to be called once per frame.
+    ///
+    auto update() -> void;
+
+    auto bind(unsigned int cache_unit, unsigned int indirection_unit) const noexcept -> void;
+
+    ///
+    /// Sets `vt_size` (width, height, last level, `level_bias`) and `vt_page`
+    /// (page size, border, slot size, cache size in texels). `level_bias` is
+    /// subtracted from the level a pixel wants, e.g. the log2 of how much
+    /// smaller a feedback pass is than the screen. `program` must be in use.
+    ///
+    auto set_uniforms(shader const& program, float level_bias = 0.0F) const noexcept -> void;
+
+    [[nodiscard]] auto resident_pages() const noexcept -> std::size_t;
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+    [[nodiscard]] auto stats() const noexcept -> statistics const&;
+};
+
+#endif // !UTIL_VIRTUAL_TEXTURE_HPP
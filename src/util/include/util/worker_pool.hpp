@@ -0,0 +1,65 @@
+#ifndef UTIL_WORKER_POOL_HPP
+#define UTIL_WORKER_POOL_HPP
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///
+/// Fixed set of worker threads pulling tasks from a shared FIFO queue.
+///
+/// Tasks must not touch OpenGL, the context is only current on the main
+/// thread.
+///
+class worker_pool
+{
+private:
+    std::vector<std::thread> m_threads{};
+    std::deque<std::function<void()>> m_tasks{};
+    std::mutex m_mutex{};
+    std::condition_variable m_task_ready{};
+    std::condition_variable m_idle{};
+    std::size_t m_busy = 0;
+    bool m_stop = false;
+
+    auto run() -> void;
+
+public:
+    worker_pool(worker_pool const&) = delete;
+    worker_pool(worker_pool&&) = delete;
+    ~worker_pool() noexcept;
+
+    ///
+    /// `num_threads == 0` picks one thread less than the hardware concurrency,
+    /// leaving a core for the thread that owns the pool.
+    ///
+    explicit worker_pool(std::size_t num_threads = 0);
+
+    auto operator=(worker_pool const&) -> worker_pool& = delete;
+    auto operator=(worker_pool&&) -> worker_pool& = delete;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    auto submit(std::function<void()> task) -> void;
+
+    ///
+    /// Blocks until the queue is empty and no task is running.
+    ///
+    auto wait_idle() -> void;
+
+    ///
+    /// Calls `fn(begin, end)` over `[0, count)` split into chunks of at least
+    /// `grain` elements. The calling thread works on chunks too and only
+    /// returns once all of them are done.
+    ///
+    auto parallel_for(std::size_t count,
+                      std::size_t grain,
+                      std::function<void(std::size_t, std::size_t)> const& fn) -> void;
+};
+
+#endif // !UTIL_WORKER_POOL_HPP
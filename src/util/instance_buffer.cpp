@@ -0,0 +1,129 @@
+#include "util/instance_buffer.hpp"
+#include "util/gl_state.hpp"
+#include "util/vertex_array.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+instance_buffer::instance_buffer(std::size_t const capacity)
+    : m_ring{ GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4) }
+    , m_capacity{ capacity }
+    , m_count{ 0 }
+    , m_vao{ 0 }
+    , m_location{ 0 }
+    , m_offset{ 0 }
+{
+}
+
+auto instance_buffer::reserve(std::size_t const count) -> void
+{
+    if(count <= m_capacity) {
+        return;
+    }
+
+    // Growing geometrically keeps a slowly rising count from reallocating every frame
+    m_capacity = std::max(count, m_capacity * 2);
+    m_ring = ring_buffer{ GL_ARRAY_BUFFER, m_capacity * sizeof(glm::mat4) };
+}
+
+auto instance_buffer::point_attributes() const noexcept -> void
+{
+    if(m_vao == 0) {
+        return;
+    }
+
+    // Attribute pointers are vertex array state, so `m_vao` has to be bound to
+    // change them. Whatever the caller had bound is put back afterwards
+    std::optional<unsigned int> const previous = gl_state::current().bound_vertex_array();
+
+    gl_state::current().bind_vertex_array(m_vao);
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, m_ring.id());
+
+    constexpr unsigned int num_columns = 4;
+    constexpr auto stride = static_cast<GLsizei>(sizeof(glm::mat4));
+
+    for(unsigned int i = 0; i < num_columns; ++i) {
+        auto const offset = m_offset + static_cast<std::size_t>(i) * sizeof(glm::vec4);
+        glVertexAttribPointer(
+            m_location + i, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void const*>(offset)); // NOLINT
+    }
+
+    if(previous.has_value()) {
+        gl_state::current().bind_vertex_array(*previous);
+    }
+}
+
+auto instance_buffer::attach(vertex_array const& vao, unsigned int const first_location) noexcept -> void
+{
+    m_vao = vao.id();
+    m_location = first_location;
+
+    vao.bind();
+
+    constexpr unsigned int num_columns = 4;
+
+    for(unsigned int i = 0; i < num_columns; ++i) {
+        glEnableVertexAttribArray(first_location + i);
+        glVertexAttribDivisor(first_location + i, 1);
+    }
+
+    this->point_attributes();
+}
+
+auto instance_buffer::upload(glm::mat4 const* const models, std::size_t const count) -> void
+{
+    glm::mat4* const mapped = this->map(count);
+
+    if(mapped != nullptr) {
+        std::memcpy(mapped, models, count * sizeof(glm::mat4));
+    }
+
+    this->unmap();
+}
+
+auto instance_buffer::map(std::size_t const count) -> glm::mat4*
+{
+    this->reserve(count);
+    m_ring.begin_frame();
+    m_count = count;
+
+    if(count == 0) {
+        return nullptr;
+    }
+
+    ring_buffer::allocation const slot = m_ring.allocate(count * sizeof(glm::mat4), sizeof(glm::vec4));
+
+    if(!slot.valid()) {
+        m_count = 0;
+        return nullptr;
+    }
+
+    m_offset = slot.offset;
+    return static_cast<glm::mat4*>(slot.data);
+}
+
+auto instance_buffer::unmap() noexcept -> bool
+{
+    bool const ok = m_ring.flush();
+
+    // Nothing was mapped this frame and `m_offset` still points into a region
+    // the ring may hand out again, keep the attributes where they are
+    if(m_count != 0) {
+        this->point_attributes();
+    }
+
+    return ok;
+}
+
+auto instance_buffer::count() const noexcept -> std::size_t
+{
+    return m_count;
+}
+
+auto instance_buffer::id() const noexcept -> unsigned int
+{
+    return m_ring.id();
+}
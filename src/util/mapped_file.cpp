@@ -0,0 +1,222 @@
+#include "util/mapped_file.hpp"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+namespace {
+
+[[nodiscard]] auto last_error() -> std::string
+{
+    char* message = nullptr;
+    FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+                   nullptr,
+                   GetLastError(),
+                   0,
+                   reinterpret_cast<char*>(&message), // NOLINT
+                   0,
+                   nullptr);
+
+    std::string result = message != nullptr ? message : "unknown error";
+    LocalFree(message);
+
+    while(!result.empty() && (result.back() == '\n' || result.back() == '\r')) {
+        result.pop_back();
+    }
+
+    return result;
+}
+
+} // namespace
+
+mapped_file::mapped_file(std::string const& path)
+    : m_data{ nullptr }
+    , m_size{ 0 }
+    , m_error{}
+    , m_file{ INVALID_HANDLE_VALUE }
+    , m_mapping{ nullptr }
+{
+    m_file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(m_file == INVALID_HANDLE_VALUE) {
+        m_error = last_error();
+        return;
+    }
+
+    LARGE_INTEGER size{};
+    if(GetFileSizeEx(m_file, &size) == 0) {
+        m_error = last_error();
+        this->close();
+        return;
+    }
+
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    if(m_size == 0) {
+        return;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(m_mapping != nullptr) {
+        m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    if(m_data == nullptr) {
+        m_error = last_error();
+        this->close();
+    }
+}
+
+auto mapped_file::close() noexcept -> void
+{
+    if(m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if(m_mapping != nullptr) {
+        CloseHandle(m_mapping);
+    }
+    if(m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : m_data{ std::exchange(other.m_data, nullptr) }
+    , m_size{ std::exchange(other.m_size, 0) }
+    , m_error{ std::move(other.m_error) }
+    , m_file{ std::exchange(other.m_file, INVALID_HANDLE_VALUE) }
+    , m_mapping{ std::exchange(other.m_mapping, nullptr) }
+{
+}
+
+auto mapped_file::operator=(mapped_file&& other) noexcept -> mapped_file&
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_error, other.m_error);
+    std::swap(m_file, other.m_file);
+    std::swap(m_mapping, other.m_mapping);
+    return *this;
+}
+
+#else
+
+namespace {
+
+/// `std::strerror` isn't thread-safe and files are mapped on worker threads
+[[nodiscard]] auto last_error() -> std::string
+{
+    return std::system_category().message(errno);
+}
+
+} // namespace
+
+mapped_file::mapped_file(std::string const& path)
+    : m_data{ nullptr }
+    , m_size{ 0 }
+    , m_error{}
+{
+    int const fd = ::open(path.c_str(), O_RDONLY); // NOLINT
+
+    if(fd < 0) {
+        m_error = last_error();
+        return;
+    }
+
+    struct stat info
+    {
+    };
+
+    if(::fstat(fd, &info) != 0) {
+        m_error = last_error();
+        ::close(fd);
+        return;
+    }
+
+    m_size = static_cast<std::size_t>(info.st_size);
+
+    if(m_size > 0) {
+        void* const data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(data == MAP_FAILED) { // NOLINT
+            m_error = last_error();
+            m_size = 0;
+        }
+        else {
+            m_data = data;
+        }
+    }
+
+    // The mapping keeps the file alive on its own
+    ::close(fd);
+}
+
+auto mapped_file::close() noexcept -> void
+{
+    if(m_data != nullptr) {
+        ::munmap(const_cast<void*>(m_data), m_size); // NOLINT
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : m_data{ std::exchange(other.m_data, nullptr) }
+    , m_size{ std::exchange(other.m_size, 0) }
+    , m_error{ std::move(other.m_error) }
+{
+}
+
+auto mapped_file::operator=(mapped_file&& other) noexcept -> mapped_file&
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_error, other.m_error);
+    return *this;
+}
+
+#endif
+
+mapped_file::~mapped_file() noexcept
+{
+    this->close();
+}
+
+auto mapped_file::valid() const noexcept -> bool
+{
+    return m_error.empty();
+}
+
+auto mapped_file::error() const noexcept -> std::string const&
+{
+    return m_error;
+}
+
+auto mapped_file::data() const noexcept -> unsigned char const*
+{
+    return static_cast<unsigned char const*>(m_data);
+}
+
+auto mapped_file::size() const noexcept -> std::size_t
+{
+    return m_size;
+}
@@ -0,0 +1,340 @@
+#include "util/mesh_optimizer.hpp"
+#include "util/hash.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::uint32_t unused = std::numeric_limits<std::uint32_t>::max();
+constexpr std::size_t no_triangle = std::numeric_limits<std::size_t>::max();
+
+/// Soups get the identity, so every function below can assume indices
+[[nodiscard]] auto indices_of(mesh const& m) -> std::vector<std::uint32_t>
+{
+    if(!m.indices.empty()) {
+        return m.indices;
+    }
+
+    std::vector<std::uint32_t> result(m.vertex_count());
+    std::iota(result.begin(), result.end(), std::uint32_t{ 0 });
+    return result;
+}
+
+///
+/// Score of a vertex from its LRU cache position and how many triangles still
+/// use it, with the constants from Forsyth's paper. The three most recent
+/// entries score a bit lower, since the triangle just emitted used them.
+///
+[[nodiscard]] auto vertex_score(int const cache_position, std::size_t const cache_size, std::size_t const remaining)
+    -> float
+{
+    if(remaining == 0) {
+        return -1.0F;
+    }
+
+    constexpr float last_triangle_score = 0.75F;
+    constexpr float cache_decay_power = 1.5F;
+    constexpr float valence_boost_scale = 2.0F;
+    constexpr float valence_boost_power = 0.5F;
+
+    float score = 0.0F;
+
+    if(cache_position >= 0) {
+        if(cache_position < 3) {
+            score = last_triangle_score;
+        }
+        else {
+            float const scaler = 1.0F / static_cast<float>(cache_size - 3);
+            score = std::pow(1.0F - static_cast<float>(cache_position - 3) * scaler, cache_decay_power);
+        }
+    }
+
+    return score + valence_boost_scale * std::pow(static_cast<float>(remaining), -valence_boost_power);
+}
+
+} // namespace
+
+auto mesh::vertex_count() const noexcept -> std::size_t
+{
+    return stride == 0 ? 0 : vertices.size() / stride;
+}
+
+auto mesh::index_count() const noexcept -> std::size_t
+{
+    return indices.empty() ? this->vertex_count() : indices.size();
+}
+
+auto weld_vertices(mesh const& source) -> mesh
+{
+    mesh result{};
+    result.stride = source.stride;
+
+    std::vector<std::uint32_t> const indices = indices_of(source);
+    std::vector<std::uint32_t> remap(source.vertex_count(), unused);
+    std::size_t const vertex_bytes = source.stride * sizeof(float);
+
+    // Keyed by content hash, buckets checked with memcmp for collisions
+    std::unordered_multimap<std::uint64_t, std::uint32_t> seen{};
+    seen.reserve(source.vertex_count());
+
+    for(std::size_t v = 0; v < source.vertex_count(); ++v) {
+        float const* const vertex = &source.vertices[v * source.stride];
+
+        hasher h{};
+        h.add(vertex, vertex_bytes);
+        std::uint64_t const key = h.value();
+
+        auto [begin, end] = seen.equal_range(key);
+        auto const match = std::find_if(begin, end, [&](auto const& entry) {
+            return std::memcmp(&result.vertices[entry.second * source.stride], vertex, vertex_bytes) == 0;
+        });
+
+        if(match != end) {
+            remap[v] = match->second;
+            continue;
+        }
+
+        auto const welded = static_cast<std::uint32_t>(result.vertex_count());
+        result.vertices.insert(result.vertices.end(), vertex, vertex + source.stride); // NOLINT
+        seen.emplace(key, welded);
+        remap[v] = welded;
+    }
+
+    result.indices.reserve(indices.size());
+    for(std::uint32_t const index : indices) {
+        result.indices.push_back(remap[index]);
+    }
+
+    return result;
+}
+
+auto optimize_vertex_cache(mesh& m, std::size_t const cache_size) -> void
+{
+    std::vector<std::uint32_t> const indices = indices_of(m);
+    std::size_t const vertex_count = m.vertex_count();
+    std::size_t const triangle_count = indices.size() / 3;
+
+    if(triangle_count == 0 || cache_size < 4) {
+        return;
+    }
+
+    // Degenerate triangles repeat a vertex, they count once for it
+    auto const first_use = [&indices](std::size_t const t, std::size_t const c) {
+        std::uint32_t const v = indices[t * 3 + c];
+        return (c < 1 || indices[t * 3] != v) && (c < 2 || indices[t * 3 + 1] != v);
+    };
+
+    // Triangles of every vertex, the first `remaining[v]` of them not emitted yet
+    std::vector<std::size_t> remaining(vertex_count, 0);
+    for(std::size_t t = 0; t < triangle_count; ++t) {
+        for(std::size_t c = 0; c < 3; ++c) {
+            if(first_use(t, c)) {
+                ++remaining[indices[t * 3 + c]];
+            }
+        }
+    }
+
+    std::vector<std::size_t> offsets(vertex_count + 1, 0);
+    std::partial_sum(remaining.begin(), remaining.end(), offsets.begin() + 1);
+
+    std::vector<std::size_t> adjacency(offsets.back());
+    std::vector<std::size_t> filled(vertex_count, 0);
+    for(std::size_t t = 0; t < triangle_count; ++t) {
+        for(std::size_t c = 0; c < 3; ++c) {
+            if(first_use(t, c)) {
+                std::uint32_t const v = indices[t * 3 + c];
+                adjacency[offsets[v] + filled[v]++] = t;
+            }
+        }
+    }
+
+    std::vector<float> vertex_scores(vertex_count, 0.0F);
+    for(std::size_t v = 0; v < vertex_count; ++v) {
+        vertex_scores[v] = vertex_score(-1, cache_size, remaining[v]);
+    }
+
+    std::vector<float> triangle_scores(triangle_count, 0.0F);
+    std::vector<bool> emitted(triangle_count, false);
+    for(std::size_t t = 0; t < triangle_count; ++t) {
+        for(std::size_t c = 0; c < 3; ++c) {
+            triangle_scores[t] += vertex_scores[indices[t * 3 + c]];
+        }
+    }
+
+    std::vector<std::uint32_t> cache{};
+    std::vector<std::uint32_t> next_cache{};
+    std::vector<std::uint32_t> result{};
+    result.reserve(indices.size());
+
+    std::size_t best = static_cast<std::size_t>(
+        std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+    std::size_t scan_from = 0;
+
+    for(std::size_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+        // Nothing in the cache left to continue from, take the next unemitted
+        // triangle. Good enough since it only happens between disjoint pieces
+        if(best == no_triangle) {
+            while(emitted[scan_from]) {
+                ++scan_from;
+            }
+            best = scan_from;
+        }
+
+        emitted[best] = true;
+        next_cache.clear();
+
+        for(std::size_t c = 0; c < 3; ++c) {
+            std::uint32_t const v = indices[best * 3 + c];
+            result.push_back(v);
+
+            if(!first_use(best, c)) {
+                continue;
+            }
+
+            next_cache.push_back(v);
+
+            // Move the triangle past the vertex's live ones
+            std::size_t* const first = &adjacency[offsets[v]];
+            std::size_t* const last = first + remaining[v];          // NOLINT
+            std::iter_swap(std::find(first, last, best), last - 1); // NOLINT
+            --remaining[v];
+        }
+
+        for(std::uint32_t const v : cache) {
+            if(std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) {
+                next_cache.push_back(v);
+            }
+        }
+
+        // Vertices pushed out of the cache still need their scores lowered
+        for(std::size_t i = cache_size; i < next_cache.size(); ++i) {
+            vertex_scores[next_cache[i]] = vertex_score(-1, cache_size, remaining[next_cache[i]]);
+        }
+
+        next_cache.resize(std::min(next_cache.size(), cache_size));
+        std::swap(cache, next_cache);
+
+        for(std::size_t i = 0; i < cache.size(); ++i) {
+            vertex_scores[cache[i]] = vertex_score(static_cast<int>(i), cache_size, remaining[cache[i]]);
+        }
+
+        // Only triangles touching the cache changed, the best one is among them
+        best = no_triangle;
+        float best_score = -1.0F;
+
+        for(std::uint32_t const v : cache) {
+            for(std::size_t i = 0; i < remaining[v]; ++i) {
+                std::size_t const t = adjacency[offsets[v] + i];
+                float const score = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] +
+                                    vertex_scores[indices[t * 3 + 2]];
+
+                if(score > best_score) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+    }
+
+    m.indices = std::move(result);
+}
+
+auto optimize_vertex_fetch(mesh& m) -> void
+{
+    std::vector<std::uint32_t> const indices = indices_of(m);
+    std::vector<std::uint32_t> remap(m.vertex_count(), unused);
+    std::vector<float> vertices{};
+    vertices.reserve(m.vertices.size());
+
+    m.indices.clear();
+    m.indices.reserve(indices.size());
+
+    for(std::uint32_t const index : indices) {
+        if(remap[index] == unused) {
+            remap[index] = static_cast<std::uint32_t>(vertices.size() / m.stride);
+            auto const first = m.vertices.begin() + static_cast<std::ptrdiff_t>(index * m.stride);
+            vertices.insert(vertices.end(), first, first + static_cast<std::ptrdiff_t>(m.stride));
+        }
+
+        m.indices.push_back(remap[index]);
+    }
+
+    m.vertices = std::move(vertices);
+}
+
+auto analyze_vertex_cache(mesh const& m, std::size_t const cache_size) -> vertex_cache_stats
+{
+    std::vector<std::uint32_t> const indices = indices_of(m);
+    std::deque<std::uint32_t> fifo{};
+    vertex_cache_stats stats{};
+
+    for(std::uint32_t const index : indices) {
+        if(std::find(fifo.begin(), fifo.end(), index) != fifo.end()) {
+            continue;
+        }
+
+        ++stats.transforms;
+        fifo.push_back(index);
+
+        if(fifo.size() > cache_size) {
+            fifo.pop_front();
+        }
+    }
+
+    auto const transforms = static_cast<double>(stats.transforms);
+    std::size_t const triangles = indices.size() / 3;
+    stats.acmr = triangles == 0 ? 0.0 : transforms / static_cast<double>(triangles);
+    stats.atvr = m.vertex_count() == 0 ? 0.0 : transforms / static_cast<double>(m.vertex_count());
+    return stats;
+}
+
+auto pack_indices(mesh const& m) -> packed_indices
+{
+    std::vector<std::uint32_t> const indices = indices_of(m);
+    packed_indices result{};
+    result.count = indices.size();
+
+    if(m.vertex_count() <= std::numeric_limits<std::uint16_t>::max()) {
+        std::vector<std::uint16_t> narrow(indices.begin(), indices.end());
+        result.type = GL_UNSIGNED_SHORT;
+        result.bytes.resize(narrow.size() * sizeof(std::uint16_t));
+        std::memcpy(result.bytes.data(), narrow.data(), result.bytes.size());
+        return result;
+    }
+
+    result.type = GL_UNSIGNED_INT;
+    result.bytes.resize(indices.size() * sizeof(std::uint32_t));
+    std::memcpy(result.bytes.data(), indices.data(), result.bytes.size());
+    return result;
+}
+
+auto optimize_mesh(mesh const& source, std::string const& name) -> mesh
+{
+    vertex_cache_stats const before = analyze_vertex_cache(source);
+
+    mesh result = weld_vertices(source);
+    optimize_vertex_cache(result);
+    optimize_vertex_fetch(result);
+
+    vertex_cache_stats const after = analyze_vertex_cache(result);
+
+    spdlog::info("[Mesh Optimizer] {}: {} -> {} vertices, ACMR {:.2f} -> {:.2f}, ATVR {:.2f} -> {:.2f}, {} bit indices",
+                 name,
+                 source.vertex_count(),
+                 result.vertex_count(),
+                 before.acmr,
+                 after.acmr,
+                 before.atvr,
+                 after.atvr,
+                 pack_indices(result).type == GL_UNSIGNED_SHORT ? 16 : 32);
+
+    return result;
+}
@@ -0,0 +1,158 @@
+#include "util/page_feedback.hpp"
+#include "util/gl_state.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+page_feedback::page_feedback(int const screen_width,
+                             int const screen_height,
+                             int const divisor,
+                             std::size_t const latency)
+    : m_divisor{ std::max(divisor, 1) }
+    , m_readbacks(std::max(latency, std::size_t{ 1 }))
+{
+    glGenFramebuffers(1, &m_framebuffer);
+    glGenRenderbuffers(1, &m_color);
+
+    for(readback& r : m_readbacks) {
+        glGenBuffers(1, &r.buffer);
+    }
+
+    this->resize(screen_width, screen_height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        spdlog::error("[Page Feedback] Framebuffer is incomplete, no pages will be requested!");
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+page_feedback::~page_feedback() noexcept
+{
+    for(readback& r : m_readbacks) {
+        if(r.fence != nullptr) {
+            glDeleteSync(r.fence);
+        }
+
+        gl_state::current().forget_buffer(r.buffer);
+        glDeleteBuffers(1, &r.buffer);
+    }
+
+    glDeleteRenderbuffers(1, &m_color);
+    glDeleteFramebuffers(1, &m_framebuffer);
+}
+
+auto page_feedback::resize(int const screen_width, int const screen_height) noexcept -> void
+{
+    m_width = std::max(screen_width / m_divisor, 1);
+    m_height = std::max(screen_height / m_divisor, 1);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+auto page_feedback::begin() const noexcept -> void
+{
+    constexpr std::array<GLuint, 4> nothing{ 0, 0, 0, 0 };
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+    glClearBufferuiv(GL_COLOR, 0, nothing.data());
+}
+
+auto page_feedback::end(int const screen_width, int const screen_height) noexcept -> void
+{
+    readback& r = m_readbacks[m_write];
+
+    if(r.fence == nullptr) {
+        auto const size = static_cast<GLsizeiptr>(m_width) * m_height * 4 * static_cast<GLsizeiptr>(sizeof(GLushort));
+
+        // Orphaned every time, the size changes with the window anyway
+        gl_state::current().bind_buffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, m_width, m_height, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+        gl_state::current().bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        r.width = m_width;
+        r.height = m_height;
+        m_write = (m_write + 1) % m_readbacks.size();
+    }
+    else {
+        ++m_skipped;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, screen_width, screen_height);
+}
+
+auto page_feedback::collect(std::vector<page_request>& requests) -> bool
+{
+    readback& r = m_readbacks[m_read];
+
+    if(r.fence == nullptr) {
+        return false;
+    }
+
+    GLenum const status = glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+
+    glDeleteSync(r.fence);
+    r.fence = nullptr;
+    m_read = (m_read + 1) % m_readbacks.size();
+
+    auto const count = static_cast<std::size_t>(r.width) * static_cast<std::size_t>(r.height);
+    m_keys.clear();
+
+    gl_state::current().bind_buffer(GL_PIXEL_PACK_BUFFER, r.buffer);
+    auto const size = static_cast<GLsizeiptr>(count * 4 * sizeof(GLushort));
+    auto const* const pixels =
+        static_cast<GLushort const*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+
+    if(pixels != nullptr) {
+        for(std::size_t i = 0; i < count; ++i) {
+            GLushort const* const p = pixels + i * 4; // NOLINT
+
+            if(p[3] != 0) { // NOLINT
+                m_keys.push_back((std::uint64_t{ p[2] } << 32U) | (std::uint64_t{ p[1] } << 16U) | p[0]); // NOLINT
+            }
+        }
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    gl_state::current().bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::sort(m_keys.begin(), m_keys.end());
+    m_keys.erase(std::unique(m_keys.begin(), m_keys.end()), m_keys.end());
+
+    requests.clear();
+    for(std::uint64_t const key : m_keys) {
+        requests.push_back(page_request{ static_cast<std::uint16_t>(key & 0xFFFFU),
+                                         static_cast<std::uint16_t>((key >> 16U) & 0xFFFFU),
+                                         static_cast<std::uint16_t>(key >> 32U) });
+    }
+
+    return true;
+}
+
+auto page_feedback::level_bias() const noexcept -> float
+{
+    return std::log2(static_cast<float>(m_divisor));
+}
+
+auto page_feedback::skipped() const noexcept -> std::size_t
+{
+    return m_skipped;
+}
@@ -0,0 +1,182 @@
+#include "util/program_cache.hpp"
+#include "util/hash.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+constexpr std::uint32_t cache_magic = 0x4C475043; // "CPGL"
+
+struct cache_header
+{
+    std::uint32_t magic = cache_magic;
+    std::uint32_t format = 0;
+    std::uint64_t key = 0;
+    std::uint64_t length = 0;
+};
+
+[[nodiscard]] auto gl_string(unsigned int const name) -> std::string
+{
+    auto const* const str = reinterpret_cast<char const*>(glGetString(name)); // NOLINT
+    return str == nullptr ? std::string{} : std::string{ str };
+}
+
+} // namespace
+
+program_cache::program_cache(std::string directory)
+    : m_directory{ std::move(directory) }
+    , m_driver{}
+    , m_supported{ false }
+{
+    m_driver = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION) + '\n' +
+               gl_string(GL_SHADING_LANGUAGE_VERSION);
+
+    if(GLAD_GL_VERSION_4_1 != 0 || GLAD_GL_ARB_get_program_binary != 0) {
+        int num_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+        m_supported = num_formats > 0;
+    }
+
+    if(!m_supported) {
+        spdlog::warn("[Program Cache] Driver doesn't support program binaries, every program will be compiled!");
+        return;
+    }
+
+    std::error_code ec{};
+    std::filesystem::create_directories(m_directory, ec);
+
+    if(ec) {
+        spdlog::warn("[Program Cache] Couldn't create directory {}: {}!", m_directory, ec.message());
+    }
+}
+
+auto program_cache::path_of(std::uint64_t const key) const -> std::string
+{
+    return fmt::format("{}/{:016x}.bin", m_directory, key);
+}
+
+auto program_cache::supported() const noexcept -> bool
+{
+    return m_supported;
+}
+
+auto program_cache::key(std::string_view const vs_source,
+                        std::string_view const fs_source,
+                        std::vector<std::string> const& defines) const noexcept -> std::uint64_t
+{
+    hasher h{};
+    h.add(m_driver);
+    h.add(vs_source);
+    h.add(fs_source);
+
+    for(auto const& define : defines) {
+        h.add(define);
+    }
+
+    return h.value();
+}
+
+auto program_cache::load(std::uint64_t const key) -> unsigned int
+{
+    if(!m_supported) {
+        ++m_stats.misses;
+        return 0;
+    }
+
+    std::string const path = this->path_of(key);
+    std::ifstream file{ path, std::ios::binary };
+
+    if(!file) {
+        ++m_stats.misses;
+        return 0;
+    }
+
+    cache_header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT
+
+    // A truncated or corrupted file can claim any length, only what the file
+    // really holds after the header is read
+    std::error_code ec{};
+    std::uintmax_t const file_size = std::filesystem::file_size(path, ec);
+    bool const fits = !ec && file_size >= sizeof(header) && header.length <= file_size - sizeof(header);
+
+    std::vector<char> binary{};
+    if(file && fits && header.magic == cache_magic && header.key == key) {
+        binary.resize(static_cast<std::size_t>(header.length));
+        file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    }
+
+    bool const complete = file && !binary.empty();
+    file.close();
+
+    unsigned int program = 0;
+    int success = 0;
+
+    if(complete) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<int>(binary.size()));
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+    }
+
+    if(success == 0) {
+        spdlog::info("[Program Cache] Binary {} was rejected, recompiling!", path);
+
+        if(program != 0) {
+            glDeleteProgram(program);
+        }
+
+        std::filesystem::remove(path, ec);
+
+        ++m_stats.rejected;
+        ++m_stats.misses;
+        return 0;
+    }
+
+    ++m_stats.hits;
+    return program;
+}
+
+auto program_cache::store(std::uint64_t const key, unsigned int const program) -> void
+{
+    if(!m_supported) {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if(length <= 0) {
+        return;
+    }
+
+    cache_header header{};
+    header.key = key;
+
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    int written = 0;
+    glGetProgramBinary(program, length, &written, &header.format, binary.data());
+    header.length = static_cast<std::uint64_t>(written);
+
+    std::string const path = this->path_of(key);
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header)); // NOLINT
+    file.write(binary.data(), written);
+
+    if(!file) {
+        spdlog::warn("[Program Cache] Couldn't write {}!", path);
+        return;
+    }
+
+    ++m_stats.stored;
+}
+
+auto program_cache::stats() const noexcept -> statistics const&
+{
+    return m_stats;
+}
@@ -0,0 +1,243 @@
+#include "util/ring_buffer.hpp"
+#include "util/gl_state.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t region_alignment = 256;
+
+[[nodiscard]] constexpr auto align_up(std::size_t const value, std::size_t const alignment) noexcept -> std::size_t
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+ring_buffer::ring_buffer(unsigned int const target, std::size_t const frame_bytes, std::size_t const frames)
+    : m_buffer{ 0 }
+    , m_target{ target }
+    , m_frame_bytes{ align_up(std::max(frame_bytes, std::size_t{ 1 }), region_alignment) }
+    , m_frames{ std::max(frames, std::size_t{ 1 }) }
+    , m_persistent{ nullptr }
+    , m_frame{ 0 }
+    , m_head{ 0 }
+    , m_in_frame{ false }
+    , m_mapped{ nullptr }
+    , m_mapped_from{ 0 }
+{
+    glGenBuffers(1, &m_buffer);
+    gl_state::current().bind_buffer(m_target, m_buffer);
+
+    if(GLAD_GL_VERSION_4_4 != 0 || GLAD_GL_ARB_buffer_storage != 0) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        auto const size = static_cast<GLsizeiptr>(m_frame_bytes * m_frames);
+
+        glBufferStorage(m_target, size, nullptr, flags);
+        m_persistent = static_cast<unsigned char*>(glMapBufferRange(m_target, 0, size, flags));
+
+        if(m_persistent != nullptr) {
+            m_fences.resize(m_frames, nullptr);
+            return;
+        }
+
+        // Storage is immutable, orphaning needs a fresh buffer
+        spdlog::warn("[Ring Buffer] Couldn't map the buffer persistently, orphaning it every frame instead!");
+        gl_state::current().forget_buffer(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+        glGenBuffers(1, &m_buffer);
+        gl_state::current().bind_buffer(m_target, m_buffer);
+    }
+
+    glBufferData(m_target, static_cast<GLsizeiptr>(m_frame_bytes), nullptr, GL_STREAM_DRAW);
+}
+
+ring_buffer::ring_buffer(ring_buffer&& other) noexcept
+    : m_buffer{ std::exchange(other.m_buffer, 0) }
+    , m_target{ other.m_target }
+    , m_frame_bytes{ other.m_frame_bytes }
+    , m_frames{ other.m_frames }
+    , m_persistent{ std::exchange(other.m_persistent, nullptr) }
+    , m_fences{ std::move(other.m_fences) }
+    , m_frame{ other.m_frame }
+    , m_head{ other.m_head }
+    , m_in_frame{ std::exchange(other.m_in_frame, false) }
+    , m_mapped{ std::exchange(other.m_mapped, nullptr) }
+    , m_mapped_from{ other.m_mapped_from }
+    , m_stats{ other.m_stats }
+{
+    other.m_fences.clear();
+}
+
+ring_buffer::~ring_buffer() noexcept
+{
+    this->release();
+}
+
+auto ring_buffer::operator=(ring_buffer&& other) noexcept -> ring_buffer&
+{
+    std::swap(m_buffer, other.m_buffer);
+    std::swap(m_target, other.m_target);
+    std::swap(m_frame_bytes, other.m_frame_bytes);
+    std::swap(m_frames, other.m_frames);
+    std::swap(m_persistent, other.m_persistent);
+    std::swap(m_fences, other.m_fences);
+    std::swap(m_frame, other.m_frame);
+    std::swap(m_head, other.m_head);
+    std::swap(m_in_frame, other.m_in_frame);
+    std::swap(m_mapped, other.m_mapped);
+    std::swap(m_mapped_from, other.m_mapped_from);
+    std::swap(m_stats, other.m_stats);
+    return *this;
+}
+
+auto ring_buffer::release() noexcept -> void
+{
+    for(GLsync const fence : m_fences) {
+        if(fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+
+    m_fences.clear();
+
+    if(m_buffer == 0) {
+        return;
+    }
+
+    if(m_persistent != nullptr || m_mapped != nullptr) {
+        gl_state::current().bind_buffer(m_target, m_buffer);
+        glUnmapBuffer(m_target);
+    }
+
+    gl_state::current().forget_buffer(m_buffer);
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+}
+
+auto ring_buffer::begin_frame() noexcept -> void
+{
+    this->end_frame();
+
+    m_frame = (m_frame + 1) % m_frames;
+    m_head = 0;
+    m_in_frame = true;
+    ++m_stats.frames;
+
+    if(m_persistent != nullptr) {
+        GLsync& fence = m_fences[m_frame];
+
+        if(fence == nullptr) {
+            return;
+        }
+
+        GLenum status = glClientWaitSync(fence, 0, 0);
+
+        if(status == GL_TIMEOUT_EXPIRED) {
+            ++m_stats.stalls;
+
+            constexpr GLuint64 timeout_ns = 1'000'000;
+            do {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+            } while(status == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+        return;
+    }
+
+    // The driver hands out fresh storage, the GPU keeps reading the old one
+    gl_state::current().bind_buffer(m_target, m_buffer);
+    glBufferData(m_target, static_cast<GLsizeiptr>(m_frame_bytes), nullptr, GL_STREAM_DRAW);
+}
+
+auto ring_buffer::allocate(std::size_t const size, std::size_t const alignment) noexcept -> allocation
+{
+    if(!m_in_frame || alignment == 0) {
+        return allocation{};
+    }
+
+    std::size_t const base = m_persistent != nullptr ? m_frame * m_frame_bytes : 0;
+    std::size_t const begin = align_up(base + m_head, alignment) - base;
+
+    if(begin + size > m_frame_bytes) {
+        ++m_stats.overflows;
+        return allocation{};
+    }
+
+    if(m_persistent != nullptr) {
+        m_head = begin + size;
+        return allocation{ m_persistent + base + begin, base + begin, size }; // NOLINT
+    }
+
+    // Only the untouched rest of this frame's storage gets mapped, so there
+    // is nothing to synchronise with
+    if(m_mapped == nullptr) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+
+        gl_state::current().bind_buffer(m_target, m_buffer);
+        void* const mapped = glMapBufferRange(
+            m_target, static_cast<GLintptr>(begin), static_cast<GLsizeiptr>(m_frame_bytes - begin), flags);
+
+        if(mapped == nullptr) {
+            return allocation{};
+        }
+
+        m_mapped = static_cast<unsigned char*>(mapped);
+        m_mapped_from = begin;
+    }
+
+    m_head = begin + size;
+    return allocation{ m_mapped + (begin - m_mapped_from), begin, size }; // NOLINT
+}
+
+auto ring_buffer::flush() noexcept -> bool
+{
+    if(m_mapped == nullptr) {
+        return true;
+    }
+
+    gl_state::current().bind_buffer(m_target, m_buffer);
+    m_mapped = nullptr;
+    return glUnmapBuffer(m_target) == GL_TRUE;
+}
+
+auto ring_buffer::end_frame() noexcept -> void
+{
+    if(!m_in_frame) {
+        return;
+    }
+
+    m_in_frame = false;
+
+    if(m_persistent != nullptr) {
+        m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return;
+    }
+
+    this->flush();
+}
+
+auto ring_buffer::persistent() const noexcept -> bool
+{
+    return m_persistent != nullptr;
+}
+
+auto ring_buffer::frame_bytes() const noexcept -> std::size_t
+{
+    return m_frame_bytes;
+}
+
+auto ring_buffer::stats() const noexcept -> statistics const&
+{
+    return m_stats;
+}
+
+auto ring_buffer::id() const noexcept -> unsigned int
+{
+    return m_buffer;
+}
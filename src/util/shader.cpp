@@ -1,18 +1,97 @@
 #include "util/shader.hpp"
+#include "util/frame_constants.hpp"
+#include "util/gl_state.hpp"
+#include "util/mapped_file.hpp"
+#include "util/program_cache.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 #include <spdlog/spdlog.h>
 
-#include <fstream>
+#include <algorithm>
 #include <memory>
-#include <sstream>
+#include <string_view>
 
-auto shader::create_shader(shader_type const type, char const* const source) -> unsigned int
+namespace {
+
+[[nodiscard]] auto is_sampler(unsigned int const type) noexcept -> bool
+{
+    switch(type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_1D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_RECT_SHADOW:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: {
+        return true;
+    }
+    default: {
+        return false;
+    }
+    }
+}
+
+///
+/// Copy of `source` with `#define`s inserted after the `#version` directive,
+/// which has to stay the first statement of the source. Built with a single
+/// allocation.
+///
+[[nodiscard]] auto inject_defines(std::string_view const source, std::vector<std::string> const& defines)
+    -> std::string
+{
+    std::string block{};
+    for(auto const& define : defines) {
+        block += "#define ";
+        block += define;
+        block += '\n';
+    }
+
+    std::size_t insert_at = 0;
+    std::size_t const version = defines.empty() ? std::string_view::npos : source.find("#version");
+
+    if(version != std::string_view::npos) {
+        std::size_t const line_end = source.find('\n', version);
+        insert_at = line_end == std::string_view::npos ? source.size() : line_end + 1;
+
+        if(line_end == std::string_view::npos) {
+            block.insert(block.begin(), '\n');
+        }
+    }
+
+    std::string result{};
+    result.reserve(source.size() + block.size());
+    result.append(source.substr(0, insert_at));
+    result.append(block);
+    result.append(source.substr(insert_at));
+    return result;
+}
+
+} // namespace
+
+auto shader::compile_shader(shader_type const type, char const* const source) -> unsigned int
 {
     unsigned int shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, nullptr);
     glCompileShader(shader);
 
+    return shader;
+}
+
+auto shader::check_shader(unsigned int const shader, shader_type const type) -> bool
+{
     int success = 0;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 
@@ -31,16 +110,26 @@ auto shader::create_shader(shader_type const type, char const* const source) ->
         }
     }
 
-    return shader;
+    return success != 0;
 }
 
-auto shader::create_program(unsigned int const vs, unsigned int const fs) -> unsigned int
+auto shader::link_program(unsigned int const vs, unsigned int const fs, bool const retrievable) -> unsigned int
 {
     unsigned int shader_program = glCreateProgram();
     glAttachShader(shader_program, vs);
     glAttachShader(shader_program, fs);
+
+    if(retrievable) {
+        glProgramParameteri(shader_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(shader_program);
 
+    return shader_program;
+}
+
+auto shader::check_program(unsigned int const shader_program) -> bool
+{
     int success = 0;
     glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
 
@@ -52,61 +141,248 @@ auto shader::create_program(unsigned int const vs, unsigned int const fs) -> uns
         spdlog::error("[Shader Linking] Error linking shaders: {}!", program_log.get());
     }
 
-    return shader_program;
+    return success != 0;
+}
+
+auto shader::load_source(std::string const& path, std::vector<std::string> const& defines, std::string& source)
+    -> bool
+{
+    mapped_file const file{ path };
+
+    if(!file.valid()) {
+        spdlog::error("[Shader] Couldn't read {}: {}!", path, file.error());
+        return false;
+    }
+
+    if(file.size() == 0) {
+        spdlog::error("[Shader] {} is empty!", path);
+        return false;
+    }
+
+    // Straight from the mapping into the string handed to the driver
+    source = inject_defines(
+        std::string_view{ reinterpret_cast<char const*>(file.data()), file.size() }, defines); // NOLINT
+    return true;
+}
+
+shader::shader(unsigned int const program)
+    : m_id{ program }
+{
+    // 0 is the invalid program, there's nothing to query
+    if(m_id == 0) {
+        return;
+    }
+
+    this->cache_uniforms();
+    this->bind_uniform_blocks();
+}
+
+shader::shader(std::string const& vs_path, std::string const& fs_path, std::vector<std::string> const& defines)
+    : shader(nullptr, vs_path, fs_path, defines)
+{
+}
+
+shader::shader(program_cache& cache,
+               std::string const& vs_path,
+               std::string const& fs_path,
+               std::vector<std::string> const& defines)
+    : shader(&cache, vs_path, fs_path, defines)
+{
 }
 
-shader::shader(std::string const& vs_path, std::string const& fs_path)
+shader::shader(program_cache* const cache,
+               std::string const& vs_path,
+               std::string const& fs_path,
+               std::vector<std::string> const& defines)
     : m_id{ 0 }
 {
-    std::ifstream vs_file{ vs_path };
-    std::ifstream fs_file{ fs_path };
+    std::string vs_source{};
+    std::string fs_source{};
+
+    // Leaves an invalid program, like a failed compile would
+    if(!shader::load_source(vs_path, defines, vs_source) || !shader::load_source(fs_path, defines, fs_source)) {
+        return;
+    }
+
+    bool const use_cache = cache != nullptr && cache->supported();
+    std::uint64_t const key = use_cache ? cache->key(vs_source, fs_source, defines) : 0;
+
+    if(use_cache) {
+        m_id = cache->load(key);
+    }
+
+    if(m_id == 0) {
+        unsigned int vs = shader::compile_shader(shader_type::vertex, vs_source.c_str());
+        unsigned int fs = shader::compile_shader(shader_type::fragment, fs_source.c_str());
+
+        bool const compiled = shader::check_shader(vs, shader_type::vertex);
+        bool const compiled_fs = shader::check_shader(fs, shader_type::fragment);
+
+        m_id = shader::link_program(vs, fs, use_cache);
+
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+
+        bool const linked = shader::check_program(m_id);
+
+        if(use_cache && compiled && compiled_fs && linked) {
+            cache->store(key, m_id);
+        }
+    }
+
+    this->cache_uniforms();
+    this->bind_uniform_blocks();
+}
+
+auto shader::cache_uniforms() -> void
+{
+    int num_uniforms = 0;
+    int max_name_length = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &num_uniforms);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    m_uniforms.clear();
+    m_uniforms.reserve(static_cast<std::size_t>(num_uniforms));
+
+    std::string name(static_cast<std::size_t>(max_name_length), '\0');
+
+    for(int i = 0; i < num_uniforms; ++i) {
+        int name_length = 0;
+        int size = 0;
+        unsigned int type = 0;
+        glGetActiveUniform(
+            m_id, static_cast<unsigned int>(i), max_name_length, &name_length, &size, &type, name.data());
+
+        std::string_view active_name{ name.data(), static_cast<std::size_t>(name_length) };
+        int const location = glGetUniformLocation(m_id, name.c_str());
+
+        // Uniforms living in a uniform block don't have a location
+        if(location < 0) {
+            continue;
+        }
+
+        // Arrays are reported as "name[0]", but they're set through "name"
+        constexpr std::string_view array_suffix = "[0]";
+        if(active_name.size() > array_suffix.size() &&
+           active_name.substr(active_name.size() - array_suffix.size()) == array_suffix) {
+            active_name.remove_suffix(array_suffix.size());
+        }
+
+        m_uniforms.push_back(uniform_info{ hasher::of(active_name), location, type, std::string{ active_name } });
+    }
+
+    std::sort(m_uniforms.begin(), m_uniforms.end(), [](uniform_info const& a, uniform_info const& b) noexcept {
+        return a.hash < b.hash;
+    });
+}
+
+auto shader::bind_uniform_blocks() const noexcept -> void
+{
+    unsigned int const frame_block = glGetUniformBlockIndex(m_id, "frame_constants");
+
+    if(frame_block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_id, frame_block, frame_constants_binding);
+    }
+}
+
+auto shader::find_uniform(uniform_name const name) const noexcept -> uniform_info const*
+{
+    auto const by_hash = [](uniform_info const& info, std::uint64_t const hash) noexcept { return info.hash < hash; };
+    auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), name.hash(), by_hash);
+
+    // Usually a single entry, more only if names collide
+    for(; it != m_uniforms.end() && it->hash == name.hash(); ++it) {
+        if(it->name == name.name()) {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
 
-    std::ostringstream vss{};
-    std::ostringstream fss{};
+auto shader::bind_uniform(uniform_name const name, unsigned int const type) const noexcept -> int
+{
+    uniform_info const* const info = this->find_uniform(name);
 
-    vss << vs_file.rdbuf();
-    fss << fs_file.rdbuf();
+    if(info == nullptr) {
+        spdlog::error("[Shader Uniforms] No active uniform named '{}'!", name.name());
+        return -1;
+    }
 
-    std::string const vs_source = vss.str();
-    std::string const fs_source = fss.str();
+    // Samplers are set through glUniform1i just like plain integers
+    bool const matches = info->type == type || (type == GL_INT && is_sampler(info->type));
 
-    unsigned int vs = this->create_shader(shader_type::vertex, vs_source.c_str());
-    unsigned int fs = this->create_shader(shader_type::fragment, fs_source.c_str());
+    if(!matches) {
+        spdlog::error(
+            "[Shader Uniforms] Uniform '{}' has type {:#x}, but was bound as {:#x}!", name.name(), info->type, type);
+        return -1;
+    }
 
-    m_id = this->create_program(vs, fs);
+    return info->location;
 }
 
 auto shader::use() const noexcept -> void
 {
-    glUseProgram(m_id);
+    gl_state::current().use_program(m_id);
+}
+
+auto shader::location(uniform_name const name) const noexcept -> int
+{
+    uniform_info const* const info = this->find_uniform(name);
+    return info == nullptr ? -1 : info->location;
+}
+
+auto shader::set_bool(uniform_name const name, bool const value) const noexcept -> void
+{
+    shader::set_bool(this->location(name), value);
+}
+
+auto shader::set_int(uniform_name const name, int const value) const noexcept -> void
+{
+    shader::set_int(this->location(name), value);
+}
+
+auto shader::set_float(uniform_name const name, float const value) const noexcept -> void
+{
+    shader::set_float(this->location(name), value);
+}
+
+auto shader::set_vec4(uniform_name const name, glm::vec4 const& value) const noexcept -> void
+{
+    shader::set_vec4(this->location(name), value);
+}
+
+auto shader::set_mat4(uniform_name const name, glm::mat4 const& value) const noexcept -> void
+{
+    shader::set_mat4(this->location(name), value);
 }
 
-auto shader::set_bool(std::string const& id, bool const value) const noexcept -> void
+auto shader::set_bool(int const location, bool const value) noexcept -> void
 {
-    glUniform1i(glGetUniformLocation(m_id, id.c_str()), static_cast<int>(value));
+    glUniform1i(location, static_cast<int>(value));
 }
 
-auto shader::set_int(std::string const& id, int const value) const noexcept -> void
+auto shader::set_int(int const location, int const value) noexcept -> void
 {
-    glUniform1i(glGetUniformLocation(m_id, id.c_str()), value);
+    glUniform1i(location, value);
 }
 
-auto shader::set_float(std::string const& id, float const value) const noexcept -> void
+auto shader::set_float(int const location, float const value) noexcept -> void
 {
-    glUniform1f(glGetUniformLocation(m_id, id.c_str()), value);
+    glUniform1f(location, value);
 }
 
-auto shader::set_vec4(std::string const& id, glm::vec4 const& value) const noexcept -> void
+auto shader::set_vec4(int const location, glm::vec4 const& value) noexcept -> void
 {
-    glUniform4f(glGetUniformLocation(m_id, id.c_str()), value.x, value.y, value.z, value.w);
+    glUniform4f(location, value.x, value.y, value.z, value.w);
 }
 
-auto shader::set_mat4(std::string const& id, glm::mat4 const& value) const noexcept -> void
+auto shader::set_mat4(int const location, glm::mat4 const& value) noexcept -> void
 {
-    glUniformMatrix4fv(glGetUniformLocation(m_id, id.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 auto shader::unbind() noexcept -> void
 {
-    glUseProgram(0);
+    gl_state::current().use_program(0);
 }
@@ -0,0 +1,202 @@
+#include "util/shader_compiler.hpp"
+#include "util/program_cache.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <utility>
+
+shader_compiler::shader_compiler(program_cache* const cache)
+    : m_cache{ cache }
+    , m_parallel{ false }
+    , m_pending{ 0 }
+    , m_invalid{ 0U }
+{
+    // 0xFFFFFFFF lets the driver pick how many threads it wants to use
+    constexpr unsigned int driver_threads = 0xFFFFFFFFU;
+
+    if(GLAD_GL_KHR_parallel_shader_compile != 0) {
+        glMaxShaderCompilerThreadsKHR(driver_threads);
+        m_parallel = true;
+    }
+    else if(GLAD_GL_ARB_parallel_shader_compile != 0) {
+        glMaxShaderCompilerThreadsARB(driver_threads);
+        m_parallel = true;
+    }
+
+    spdlog::info("[Shader Compiler] Parallel shader compilation {}", m_parallel ? "enabled" : "not available");
+}
+
+shader_compiler::~shader_compiler() noexcept
+{
+    this->release();
+}
+
+auto shader_compiler::operator=(shader_compiler&& other) noexcept -> shader_compiler&
+{
+    std::swap(m_cache, other.m_cache);
+    std::swap(m_parallel, other.m_parallel);
+    std::swap(m_pending, other.m_pending);
+    std::swap(m_jobs, other.m_jobs);
+    std::swap(m_fallback, other.m_fallback);
+    return *this;
+}
+
+auto shader_compiler::release() noexcept -> void
+{
+    for(auto& j : m_jobs) {
+        if(j.state != status::pending) {
+            continue;
+        }
+
+        glDeleteShader(j.vs);
+        glDeleteShader(j.fs);
+        glDeleteProgram(j.program);
+    }
+
+    m_jobs.clear();
+    m_pending = 0;
+}
+
+auto shader_compiler::parallel() const noexcept -> bool
+{
+    return m_parallel;
+}
+
+auto shader_compiler::submit(std::string const& vs_path,
+                             std::string const& fs_path,
+                             std::vector<std::string> const& defines) -> handle
+{
+    std::string vs_source{};
+    std::string fs_source{};
+    job j{};
+
+    if(!shader::load_source(vs_path, defines, vs_source) || !shader::load_source(fs_path, defines, fs_source)) {
+        j.state = status::failed;
+        m_jobs.push_back(std::move(j));
+        return m_jobs.size() - 1;
+    }
+
+    bool const use_cache = m_cache != nullptr && m_cache->supported();
+
+    if(use_cache) {
+        j.key = m_cache->key(vs_source, fs_source, defines);
+        unsigned int const program = m_cache->load(j.key);
+
+        if(program != 0) {
+            j.program = program;
+            j.state = status::ready;
+            j.result = shader{ program };
+
+            m_jobs.push_back(std::move(j));
+            return m_jobs.size() - 1;
+        }
+    }
+
+    j.vs = shader::compile_shader(shader::shader_type::vertex, vs_source.c_str());
+    j.fs = shader::compile_shader(shader::shader_type::fragment, fs_source.c_str());
+    j.program = shader::link_program(j.vs, j.fs, use_cache);
+
+    m_jobs.push_back(std::move(j));
+    ++m_pending;
+
+    return m_jobs.size() - 1;
+}
+
+auto shader_compiler::set_fallback(shader fallback) -> void
+{
+    m_fallback = std::move(fallback);
+}
+
+auto shader_compiler::completed(job const& j) const noexcept -> bool
+{
+    if(!m_parallel) {
+        return true;
+    }
+
+    // GL_COMPLETION_STATUS_KHR and GL_COMPLETION_STATUS_ARB share the same value
+    int done = 0;
+    glGetProgramiv(j.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != 0;
+}
+
+auto shader_compiler::finalize(job& j) -> void
+{
+    bool const vs_ok = shader::check_shader(j.vs, shader::shader_type::vertex);
+    bool const fs_ok = shader::check_shader(j.fs, shader::shader_type::fragment);
+    bool const linked = shader::check_program(j.program);
+
+    glDeleteShader(j.vs);
+    glDeleteShader(j.fs);
+    j.vs = 0;
+    j.fs = 0;
+
+    --m_pending;
+
+    if(!vs_ok || !fs_ok || !linked) {
+        glDeleteProgram(j.program);
+        j.program = 0;
+        j.state = status::failed;
+        return;
+    }
+
+    if(m_cache != nullptr && m_cache->supported()) {
+        m_cache->store(j.key, j.program);
+    }
+
+    j.state = status::ready;
+    j.result = shader{ j.program };
+}
+
+auto shader_compiler::poll() -> std::size_t
+{
+    for(auto& j : m_jobs) {
+        if(j.state != status::pending || !this->completed(j)) {
+            continue;
+        }
+
+        this->finalize(j);
+
+        // Without the extension every status query may block on the compiler
+        if(!m_parallel) {
+            break;
+        }
+    }
+
+    return m_pending;
+}
+
+auto shader_compiler::wait_all() -> void
+{
+    for(auto& j : m_jobs) {
+        if(j.state == status::pending) {
+            this->finalize(j);
+        }
+    }
+}
+
+auto shader_compiler::state(handle const h) const noexcept -> status
+{
+    return m_jobs[h].state;
+}
+
+auto shader_compiler::ready(handle const h) const noexcept -> bool
+{
+    return m_jobs[h].state == status::ready;
+}
+
+auto shader_compiler::pending() const noexcept -> std::size_t
+{
+    return m_pending;
+}
+
+auto shader_compiler::get(handle const h) const -> shader const&
+{
+    job const& j = m_jobs[h];
+
+    if(j.result.has_value()) {
+        return *j.result;
+    }
+
+    return m_fallback.has_value() ? *m_fallback : m_invalid;
+}
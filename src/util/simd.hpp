@@ -0,0 +1,200 @@
+#ifndef UTIL_SIMD_HPP
+#define UTIL_SIMD_HPP
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define UTIL_SIMD_AVX 1
+#define UTIL_SIMD 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTIL_SIMD_SSE 1
+#define UTIL_SIMD 1
+#endif
+
+#if defined(UTIL_SIMD)
+
+///
+/// Thin wrapper over 4 (SSE2) or 8 (AVX, with `ENABLE_AVX`) floats shared by
+/// the util kernels. Private to util: every util source is built with the
+/// same instruction set, which wouldn't hold for code including it from
+/// elsewhere. `UTIL_SIMD` is only defined when one of them is available.
+///
+namespace simd {
+
+#if defined(UTIL_SIMD_AVX)
+
+struct simd_float
+{
+    static constexpr std::size_t width = 8;
+    __m256 v;
+
+    [[nodiscard]] static auto load(float const* const p) noexcept -> simd_float
+    {
+        return { _mm256_loadu_ps(p) };
+    }
+    [[nodiscard]] static auto set(float const x) noexcept -> simd_float
+    {
+        return { _mm256_set1_ps(x) };
+    }
+    /// `p` must be aligned to the vector size.
+    auto store(float* const p) const noexcept -> void
+    {
+        _mm256_store_ps(p, v);
+    }
+};
+
+inline auto operator+(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_add_ps(a.v, b.v) };
+}
+inline auto operator-(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_sub_ps(a.v, b.v) };
+}
+inline auto operator*(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_mul_ps(a.v, b.v) };
+}
+inline auto floor_positive(simd_float const a) noexcept -> simd_float
+{
+    return { _mm256_floor_ps(a.v) };
+}
+inline auto less(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) };
+}
+inline auto equal(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) };
+}
+inline auto mask_xor(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_xor_ps(a.v, b.v) };
+}
+inline auto select(simd_float const mask, simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_blendv_ps(b.v, a.v, mask.v) };
+}
+inline auto abs(simd_float const a) noexcept -> simd_float
+{
+    return { _mm256_andnot_ps(_mm256_set1_ps(-0.0F), a.v) };
+}
+inline auto negate(simd_float const a) noexcept -> simd_float
+{
+    return { _mm256_xor_ps(_mm256_set1_ps(-0.0F), a.v) };
+}
+
+inline auto min(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_min_ps(a.v, b.v) };
+}
+inline auto max(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_max_ps(a.v, b.v) };
+}
+inline auto mask_or(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm256_or_ps(a.v, b.v) };
+}
+///
+/// One bit per lane, set where the lane's sign bit (all comparison results) is set.
+///
+inline auto mask_bits(simd_float const mask) noexcept -> unsigned int
+{
+    return static_cast<unsigned int>(_mm256_movemask_ps(mask.v));
+}
+
+#else
+
+struct simd_float
+{
+    static constexpr std::size_t width = 4;
+    __m128 v;
+
+    [[nodiscard]] static auto load(float const* const p) noexcept -> simd_float
+    {
+        return { _mm_loadu_ps(p) };
+    }
+    [[nodiscard]] static auto set(float const x) noexcept -> simd_float
+    {
+        return { _mm_set1_ps(x) };
+    }
+    /// `p` must be aligned to the vector size.
+    auto store(float* const p) const noexcept -> void
+    {
+        _mm_store_ps(p, v);
+    }
+};
+
+inline auto operator+(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_add_ps(a.v, b.v) };
+}
+inline auto operator-(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_sub_ps(a.v, b.v) };
+}
+inline auto operator*(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_mul_ps(a.v, b.v) };
+}
+inline auto floor_positive(simd_float const a) noexcept -> simd_float
+{
+    // SSE2 has no floor, truncation is the same for positive numbers
+    return { _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)) };
+}
+inline auto less(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_cmplt_ps(a.v, b.v) };
+}
+inline auto equal(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_cmpeq_ps(a.v, b.v) };
+}
+inline auto mask_xor(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_xor_ps(a.v, b.v) };
+}
+inline auto select(simd_float const mask, simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+}
+inline auto abs(simd_float const a) noexcept -> simd_float
+{
+    return { _mm_andnot_ps(_mm_set1_ps(-0.0F), a.v) };
+}
+inline auto negate(simd_float const a) noexcept -> simd_float
+{
+    return { _mm_xor_ps(_mm_set1_ps(-0.0F), a.v) };
+}
+
+inline auto min(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_min_ps(a.v, b.v) };
+}
+inline auto max(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_max_ps(a.v, b.v) };
+}
+inline auto mask_or(simd_float const a, simd_float const b) noexcept -> simd_float
+{
+    return { _mm_or_ps(a.v, b.v) };
+}
+///
+/// One bit per lane, set where the lane's sign bit (all comparison results) is set.
+///
+inline auto mask_bits(simd_float const mask) noexcept -> unsigned int
+{
+    return static_cast<unsigned int>(_mm_movemask_ps(mask.v));
+}
+
+#endif
+
+} // namespace simd
+
+#endif
+
+#endif // !UTIL_SIMD_HPP
@@ -0,0 +1,3 @@
+// The one stb_image implementation, shared by util and every example
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
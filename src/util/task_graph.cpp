@@ -0,0 +1,152 @@
+#include "util/task_graph.hpp"
+#include "util/worker_pool.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+[[nodiscard]] auto to_ms(task_graph::clock_type::duration const d) noexcept -> double
+{
+    return std::chrono::duration<double, std::milli>{ d }.count();
+}
+
+} // namespace
+
+task_graph::task_graph()
+    : m_created{ clock_type::now() }
+{
+}
+
+auto task_graph::add(std::string name,
+                     runs_on const where,
+                     std::function<void()> fn,
+                     std::vector<task_id> const& dependencies) -> task_id
+{
+    task_id const id = m_tasks.size();
+
+    task t{};
+    t.name = std::move(name);
+    t.where = where;
+    t.fn = std::move(fn);
+    t.dependencies = dependencies;
+    t.remaining = dependencies.size();
+    m_tasks.push_back(std::move(t));
+
+    for(task_id const dependency : dependencies) {
+        m_tasks[dependency].dependents.push_back(id);
+    }
+
+    return id;
+}
+
+auto task_graph::dispatch(task_id const id) -> void
+{
+    m_tasks[id].ready = clock_type::now();
+
+    if(m_tasks[id].where == runs_on::gl) {
+        m_gl_ready.push_back(id);
+        m_changed.notify_all();
+        return;
+    }
+
+    m_pool->submit([this, id] { this->run(id); });
+}
+
+auto task_graph::run(task_id const id) -> void
+{
+    task& t = m_tasks[id];
+    t.started = clock_type::now();
+    t.fn();
+    t.finished = clock_type::now();
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    for(task_id const dependent : t.dependents) {
+        if(--m_tasks[dependent].remaining == 0) {
+            this->dispatch(dependent);
+        }
+    }
+
+    ++m_done;
+    m_changed.notify_all();
+}
+
+auto task_graph::start(worker_pool& pool) -> void
+{
+    m_pool = &pool;
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    for(task_id id = 0; id < m_tasks.size(); ++id) {
+        if(m_tasks[id].dependencies.empty()) {
+            this->dispatch(id);
+        }
+    }
+}
+
+auto task_graph::finish() -> void
+{
+    std::unique_lock<std::mutex> lock{ m_mutex };
+
+    while(m_done < m_tasks.size()) {
+        m_changed.wait(lock, [this] { return !m_gl_ready.empty() || m_done == m_tasks.size(); });
+
+        while(!m_gl_ready.empty()) {
+            task_id const id = m_gl_ready.front();
+            m_gl_ready.pop_front();
+
+            lock.unlock();
+            this->run(id);
+            lock.lock();
+        }
+    }
+}
+
+auto task_graph::report(clock_type::time_point const first_frame) const -> void
+{
+    if(m_tasks.empty()) {
+        return;
+    }
+
+    clock_type::duration busy{};
+    for(task const& t : m_tasks) {
+        busy += t.finished - t.started;
+    }
+
+    spdlog::info("[Startup] First frame after {:.1f} ms, {} task(s) took {:.1f} ms in total",
+                 to_ms(first_frame - m_created),
+                 m_tasks.size(),
+                 to_ms(busy));
+
+    auto const by_finish = [this](task_id const a, task_id const b) {
+        return m_tasks[a].finished < m_tasks[b].finished;
+    };
+
+    // Walk back from the last task through whichever dependency held it up longest
+    std::vector<task_id> path{};
+    std::vector<task_id> all(m_tasks.size());
+    std::iota(all.begin(), all.end(), task_id{ 0 });
+    path.push_back(*std::max_element(all.begin(), all.end(), by_finish));
+
+    while(!m_tasks[path.back()].dependencies.empty()) {
+        std::vector<task_id> const& dependencies = m_tasks[path.back()].dependencies;
+        path.push_back(*std::max_element(dependencies.begin(), dependencies.end(), by_finish));
+    }
+
+    std::reverse(path.begin(), path.end());
+
+    spdlog::info("[Startup] Critical path:");
+    for(task_id const id : path) {
+        task const& t = m_tasks[id];
+        spdlog::info("[Startup]     {}: {:.1f} ms to {:.1f} ms ({:.1f} ms, waited {:.1f} ms for a thread)",
+                     t.name,
+                     to_ms(t.started - m_created),
+                     to_ms(t.finished - m_created),
+                     to_ms(t.finished - t.started),
+                     to_ms(t.started - t.ready));
+    }
+}
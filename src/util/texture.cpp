@@ -0,0 +1,47 @@
+#include "util/texture.hpp"
+#include "util/gl_state.hpp"
+
+#include <utility>
+
+texture::texture(unsigned int const target)
+    : m_id{ 0 }
+    , m_target{ target }
+{
+    glGenTextures(1, &m_id);
+}
+
+texture::texture(texture&& other) noexcept
+    : m_id{ std::exchange(other.m_id, 0) }
+    , m_target{ other.m_target }
+{
+}
+
+texture::~texture() noexcept
+{
+    if(m_id != 0) {
+        gl_state::current().forget_texture(m_id);
+        glDeleteTextures(1, &m_id);
+    }
+}
+
+auto texture::operator=(texture&& other) noexcept -> texture&
+{
+    std::swap(m_id, other.m_id);
+    std::swap(m_target, other.m_target);
+    return *this;
+}
+
+auto texture::bind(unsigned int const unit) const noexcept -> void
+{
+    gl_state::current().bind_texture(unit, m_target, m_id);
+}
+
+auto texture::id() const noexcept -> unsigned int
+{
+    return m_id;
+}
+
+auto texture::target() const noexcept -> unsigned int
+{
+    return m_target;
+}
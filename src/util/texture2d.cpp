@@ -0,0 +1,165 @@
+#include "util/texture2d.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+texture2d::texture2d(int const width, int const height, int const channels, texture2d_params const& params)
+    : m_width{ width }
+    , m_height{ height }
+    , m_channels{ channels }
+    , m_levels{ params.mipmaps ? mip_levels(width, height) : 1 }
+{
+    allocate_texture_storage(m_texture, m_levels, internal_format_of(channels), width, height);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(params.mag_filter));
+
+    // Mipmapped filtering on a single level would leave the texture incomplete
+    GLenum const min_filter = params.mipmaps ? params.min_filter : params.mag_filter;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(min_filter));
+
+    set_channel_swizzle(GL_TEXTURE_2D, channels);
+}
+
+auto texture2d::upload(void const* const pixels) const noexcept -> void
+{
+    m_texture.bind();
+
+    auto const row_bytes = static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_channels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_of(row_bytes));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, format_of(m_channels), GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if(m_levels > 1) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+auto texture2d::bind(unsigned int const unit) const noexcept -> void
+{
+    m_texture.bind(unit);
+}
+
+auto texture2d::release() && noexcept -> texture
+{
+    return std::move(m_texture);
+}
+
+auto texture2d::handle() const noexcept -> texture const&
+{
+    return m_texture;
+}
+
+auto texture2d::width() const noexcept -> int
+{
+    return m_width;
+}
+
+auto texture2d::height() const noexcept -> int
+{
+    return m_height;
+}
+
+auto texture2d::channels() const noexcept -> int
+{
+    return m_channels;
+}
+
+auto texture2d::levels() const noexcept -> int
+{
+    return m_levels;
+}
+
+auto mip_levels(int width, int height) noexcept -> int
+{
+    int levels = 1;
+
+    for(int size = std::max(width, height); size > 1; size /= 2) {
+        ++levels;
+    }
+
+    return levels;
+}
+
+auto internal_format_of(int const channels) noexcept -> unsigned int
+{
+    switch(channels) {
+    case 1:
+        return GL_R8;
+    case 2:
+        return GL_RG8;
+    case 3:
+        return GL_RGB8;
+    default:
+        return GL_RGBA8;
+    }
+}
+
+auto format_of(int const channels) noexcept -> unsigned int
+{
+    switch(channels) {
+    case 1:
+        return GL_RED;
+    case 2:
+        return GL_RG;
+    case 3:
+        return GL_RGB;
+    default:
+        return GL_RGBA;
+    }
+}
+
+auto unpack_alignment_of(std::size_t const row_bytes) noexcept -> int
+{
+    for(int alignment = 8; alignment > 1; alignment /= 2) {
+        if(row_bytes % static_cast<std::size_t>(alignment) == 0) {
+            return alignment;
+        }
+    }
+
+    return 1;
+}
+
+auto set_channel_swizzle(unsigned int const target, int const channels) noexcept -> void
+{
+    if(channels == 1) {
+        std::array<GLint, 4> const swizzle{ GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle.data());
+    }
+    else if(channels == 2) {
+        std::array<GLint, 4> const swizzle{ GL_RED, GL_RED, GL_RED, GL_GREEN };
+        glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle.data());
+    }
+}
+
+auto allocate_texture_storage(texture const& tex,
+                              int const levels,
+                              unsigned int const internal_format,
+                              int const width,
+                              int const height) noexcept -> void
+{
+    GLenum const target = tex.target();
+
+    tex.bind();
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    if(GLAD_GL_VERSION_4_2 != 0 || GLAD_GL_ARB_texture_storage != 0) {
+        glTexStorage2D(target, levels, internal_format, width, height);
+        return;
+    }
+
+    // No pixels are passed, so the transfer format only has to be valid
+    for(int i = 0; i < levels; ++i) {
+        glTexImage2D(target,
+                     i,
+                     static_cast<GLint>(internal_format),
+                     std::max(width >> i, 1),
+                     std::max(height >> i, 1),
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+    }
+}
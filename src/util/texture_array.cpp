@@ -0,0 +1,218 @@
+#include "util/texture_array.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+///
+/// Pixel `(x, y)` of `source` expanded to `channels` channels into `out`.
+///
+auto expand_pixel(image const& source, int const x, int const y, int const channels, unsigned char* const out) noexcept
+    -> void
+{
+    auto const offset = (static_cast<std::size_t>(y) * static_cast<std::size_t>(source.width) +
+                         static_cast<std::size_t>(x)) *
+                        static_cast<std::size_t>(source.channels);
+    unsigned char const* const in = source.pixels.data() + offset; // NOLINT
+
+    // Grey (and grey-alpha) images fill every color channel, like GL_LUMINANCE did
+    bool const grey = source.channels < 3;
+    bool const alpha = source.channels == 2 || source.channels == 4;
+    constexpr unsigned char opaque = 255;
+
+    int const alpha_channel = channels == 2 ? 1 : 3;
+
+    for(int c = 0; c < channels; ++c) {
+        if(c == alpha_channel) {
+            out[c] = alpha ? in[source.channels - 1] : opaque; // NOLINT
+        }
+        else {
+            out[c] = in[grey ? 0 : c]; // NOLINT
+        }
+    }
+}
+
+} // namespace
+
+texture_array::texture_array(int const width,
+                             int const height,
+                             int const channels,
+                             int const layers,
+                             texture2d_params const& params)
+    : m_width{ width }
+    , m_height{ height }
+    , m_channels{ channels }
+    , m_layers{ layers }
+    , m_levels{ params.mipmaps ? mip_levels(width, height) : 1 }
+{
+    m_texture.bind();
+
+    unsigned int const internal_format = internal_format_of(channels);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+
+    if(GLAD_GL_VERSION_4_2 != 0 || GLAD_GL_ARB_texture_storage != 0) {
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_levels, internal_format, width, height, layers);
+    }
+    else {
+        // No pixels are passed, so the transfer format only has to be valid
+        for(int i = 0; i < m_levels; ++i) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                         i,
+                         static_cast<GLint>(internal_format),
+                         std::max(width >> i, 1),
+                         std::max(height >> i, 1),
+                         layers,
+                         0,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         nullptr);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, static_cast<GLint>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, static_cast<GLint>(params.wrap));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(params.mag_filter));
+
+    GLenum const min_filter = params.mipmaps ? params.min_filter : params.mag_filter;
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(min_filter));
+    set_channel_swizzle(GL_TEXTURE_2D_ARRAY, channels);
+}
+
+auto texture_array::upload(int const layer, void const* const pixels) const noexcept -> void
+{
+    m_texture.bind();
+
+    auto const row_bytes = static_cast<std::size_t>(m_width) * static_cast<std::size_t>(m_channels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment_of(row_bytes));
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                    0,
+                    0,
+                    0,
+                    layer,
+                    m_width,
+                    m_height,
+                    1,
+                    format_of(m_channels),
+                    GL_UNSIGNED_BYTE,
+                    pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+auto texture_array::generate_mipmaps() const noexcept -> void
+{
+    if(m_levels > 1) {
+        m_texture.bind();
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+}
+
+auto texture_array::bind(unsigned int const unit) const noexcept -> void
+{
+    m_texture.bind(unit);
+}
+
+auto texture_array::handle() const noexcept -> texture const&
+{
+    return m_texture;
+}
+
+auto texture_array::width() const noexcept -> int
+{
+    return m_width;
+}
+
+auto texture_array::height() const noexcept -> int
+{
+    return m_height;
+}
+
+auto texture_array::channels() const noexcept -> int
+{
+    return m_channels;
+}
+
+auto texture_array::layers() const noexcept -> int
+{
+    return m_layers;
+}
+
+auto texture_array::levels() const noexcept -> int
+{
+    return m_levels;
+}
+
+auto texture_array_builder::add(image img) -> std::size_t
+{
+    m_width = std::max(m_width, img.width);
+    m_height = std::max(m_height, img.height);
+    m_channels = std::max(m_channels, img.channels);
+
+    // Color plus a grey-alpha image needs RGBA to keep the alpha
+    if(m_channels == 3 && (img.channels == 2 || m_has_alpha)) {
+        m_channels = 4;
+    }
+
+    m_has_alpha = m_has_alpha || img.channels == 2 || img.channels == 4;
+    m_images.push_back(std::move(img));
+
+    return m_images.size() - 1;
+}
+
+auto texture_array_builder::layer(std::size_t const layer) const noexcept -> array_layer
+{
+    image const& img = m_images[layer];
+
+    return array_layer{ glm::vec2{ static_cast<float>(img.width) / static_cast<float>(m_width),
+                                   static_cast<float>(img.height) / static_cast<float>(m_height) },
+                        static_cast<float>(layer) };
+}
+
+auto texture_array_builder::size() const noexcept -> std::size_t
+{
+    return m_images.size();
+}
+
+auto texture_array_builder::build(texture2d_params const& params) const -> texture_array
+{
+    int max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+
+    if(m_images.size() > static_cast<std::size_t>(max_layers)) {
+        spdlog::error("[Texture Array] {} layers but the driver only supports {}!", m_images.size(), max_layers);
+    }
+
+    texture_array result{ m_width, m_height, m_channels, static_cast<int>(m_images.size()), params };
+
+    auto const pixel_bytes = static_cast<std::size_t>(m_channels);
+    auto const row_bytes = static_cast<std::size_t>(m_width) * pixel_bytes;
+    std::vector<unsigned char> layer(row_bytes * static_cast<std::size_t>(m_height));
+
+    for(std::size_t i = 0; i < m_images.size(); ++i) {
+        image const& img = m_images[i];
+
+        if(img.width == m_width && img.height == m_height && img.channels == m_channels) {
+            result.upload(static_cast<int>(i), img.pixels.data());
+            continue;
+        }
+
+        // Clamping the source coordinate repeats the last row and column into the padding
+        for(int y = 0; y < m_height; ++y) {
+            int const source_y = std::min(y, img.height - 1);
+
+            for(int x = 0; x < m_width; ++x) {
+                int const source_x = std::min(x, img.width - 1);
+                std::size_t const offset = static_cast<std::size_t>(y) * row_bytes + static_cast<std::size_t>(x) * pixel_bytes;
+                expand_pixel(img, source_x, source_y, m_channels, layer.data() + offset); // NOLINT
+            }
+        }
+
+        result.upload(static_cast<int>(i), layer.data());
+    }
+
+    result.generate_mipmaps();
+    return result;
+}
@@ -0,0 +1,247 @@
+#include "util/texture_cache.hpp"
+#include "util/hash.hpp"
+#include "util/mapped_file.hpp"
+#include "util/texture2d.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifndef UTIL_TEXTURE_CACHE_DIR
+#define UTIL_TEXTURE_CACHE_DIR "texture_cache"
+#endif
+
+namespace {
+
+constexpr std::uint32_t pixels_magic = 0x50435854; // "TXCP"
+constexpr std::uint32_t pixels_version = 1;
+
+struct pixels_header
+{
+    std::uint32_t magic = pixels_magic;
+    std::uint32_t version = pixels_version;
+    std::uint64_t key = 0;
+    std::int32_t width = 0;
+    std::int32_t height = 0;
+    std::int32_t channels = 0;
+    std::int32_t reserved = 0;
+};
+
+auto flip_rows(image& img) noexcept -> void
+{
+    auto const row = static_cast<std::size_t>(img.width) * static_cast<std::size_t>(img.channels);
+    auto* const pixels = img.pixels.data();
+
+    for(std::size_t top = 0, bottom = static_cast<std::size_t>(img.height) - 1; top < bottom; ++top, --bottom) {
+        std::swap_ranges(pixels + top * row, pixels + (top + 1) * row, pixels + bottom * row); // NOLINT
+    }
+}
+
+} // namespace
+
+texture_cache::texture_cache(std::string directory)
+    : m_directory{ std::move(directory) }
+{
+    std::error_code ec{};
+    std::filesystem::create_directories(m_directory, ec);
+
+    if(ec) {
+        spdlog::warn("[Texture Cache] Couldn't create directory {}: {}!", m_directory, ec.message());
+    }
+}
+
+auto texture_cache::default_directory() -> std::string
+{
+    return UTIL_TEXTURE_CACHE_DIR;
+}
+
+auto texture_cache::path_of(std::uint64_t const key) const -> std::string
+{
+    return fmt::format("{}/{:016x}.pixels", m_directory, key);
+}
+
+auto texture_cache::read_pixels(std::uint64_t const key, image& result) const -> bool
+{
+    // Not being there is the usual miss, so no logging
+    mapped_file const file{ this->path_of(key) };
+
+    if(!file.valid() || file.size() < sizeof(pixels_header)) {
+        return false;
+    }
+
+    pixels_header header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if(header.magic != pixels_magic || header.version != pixels_version || header.key != key || header.width <= 0 ||
+       header.height <= 0 || header.channels < 1 || header.channels > 4) {
+        return false;
+    }
+
+    std::size_t const size = static_cast<std::size_t>(header.width) * static_cast<std::size_t>(header.height) *
+                             static_cast<std::size_t>(header.channels);
+
+    if(file.size() - sizeof(header) < size) {
+        return false;
+    }
+
+    result.width = header.width;
+    result.height = header.height;
+    result.channels = header.channels;
+    result.pixels.assign(file.data() + sizeof(header), file.data() + sizeof(header) + size); // NOLINT
+    return true;
+}
+
+auto texture_cache::write_pixels(std::uint64_t const key, image const& decoded) const -> void
+{
+    pixels_header header{};
+    header.key = key;
+    header.width = decoded.width;
+    header.height = decoded.height;
+    header.channels = decoded.channels;
+
+    // Written next to the final name and renamed, so other threads and
+    // processes sharing the directory never see half a file
+    std::string const path = this->path_of(key);
+    std::string const temporary =
+        fmt::format("{}.{:x}.tmp", path, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    {
+        std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));                    // NOLINT
+        file.write(reinterpret_cast<char const*>(decoded.pixels.data()),                       // NOLINT
+                   static_cast<std::streamsize>(decoded.pixels.size()));
+
+        if(!file) {
+            spdlog::warn("[Texture Cache] Couldn't write {}!", temporary);
+            return;
+        }
+    }
+
+    std::error_code ec{};
+    std::filesystem::rename(temporary, path, ec);
+
+    if(ec) {
+        spdlog::warn("[Texture Cache] Couldn't move {} to {}: {}!", temporary, path, ec.message());
+        std::filesystem::remove(temporary, ec);
+    }
+}
+
+auto texture_cache::key_of(mapped_file const& contents, image_params const& params) noexcept -> std::uint64_t
+{
+    hasher h{};
+    h.add(contents.data(), contents.size());
+    h.add(&params.flip_vertically, sizeof(params.flip_vertically));
+    h.add(&params.channels, sizeof(params.channels));
+    return h.value();
+}
+
+auto texture_cache::decode(std::string const& path,
+                           mapped_file const& contents,
+                           std::uint64_t const key,
+                           image_params const& params,
+                           image& result) -> bool
+{
+    if(this->read_pixels(key, result)) {
+        ++m_stats.disk_hits;
+        return true;
+    }
+
+    int width = 0;
+    int height = 0;
+    int file_channels = 0;
+    unsigned char* const pixels = stbi_load_from_memory(
+        contents.data(), static_cast<int>(contents.size()), &width, &height, &file_channels, params.channels);
+
+    if(pixels == nullptr) {
+        spdlog::error("[STB_Image] Couldn't load file: {} ({})!", path, stbi_failure_reason());
+        ++m_stats.failures;
+        return false;
+    }
+
+    result.width = width;
+    result.height = height;
+    result.channels = params.channels != 0 ? params.channels : file_channels;
+
+    std::size_t const size =
+        static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * static_cast<std::size_t>(result.channels);
+    result.pixels.assign(pixels, pixels + size); // NOLINT
+    stbi_image_free(pixels);
+
+    if(params.flip_vertically) {
+        flip_rows(result);
+    }
+
+    ++m_stats.decodes;
+    this->write_pixels(key, result);
+
+    return true;
+}
+
+auto texture_cache::load_image(std::string const& path, image_params const& params, image& result) -> bool
+{
+    mapped_file const contents{ path };
+
+    if(!contents.valid()) {
+        spdlog::error("[Texture Cache] Couldn't read file: {} ({})!", path, contents.error());
+        ++m_stats.failures;
+        return false;
+    }
+
+    return this->decode(path, contents, key_of(contents, params), params, result);
+}
+
+auto texture_cache::load(std::string const& path, image_params const& params) -> std::shared_ptr<texture>
+{
+    mapped_file const contents{ path };
+
+    if(!contents.valid()) {
+        spdlog::error("[Texture Cache] Couldn't read file: {} ({})!", path, contents.error());
+        ++m_stats.failures;
+        return nullptr;
+    }
+
+    std::uint64_t const key = key_of(contents, params);
+
+    if(auto it = m_textures.find(key); it != m_textures.end()) {
+        if(auto shared = it->second.lock(); shared != nullptr) {
+            ++m_stats.memory_hits;
+            return shared;
+        }
+    }
+
+    image img{};
+    if(!this->decode(path, contents, key, params, img)) {
+        return nullptr;
+    }
+
+    auto result = std::make_shared<texture>(upload_image(img));
+    m_textures[key] = result;
+
+    return result;
+}
+
+auto texture_cache::stats() const noexcept -> statistics
+{
+    return statistics{ m_stats.memory_hits, m_stats.disk_hits, m_stats.decodes, m_stats.failures };
+}
+
+auto upload_image(image const& img) noexcept -> texture
+{
+    return upload_pixels(img.width, img.height, img.channels, img.pixels.data());
+}
+
+auto upload_pixels(int const width, int const height, int const channels, void const* const pixels) noexcept -> texture
+{
+    texture2d result{ width, height, channels };
+    result.upload(pixels);
+    return std::move(result).release();
+}
@@ -0,0 +1,342 @@
+#include "util/texture_residency.hpp"
+#include "util/texture_cache.hpp"
+#include "util/worker_pool.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+struct texture_residency::decode_job
+{
+    baked_texture_view view{};
+    std::vector<image> levels{};
+    bool ok = false;
+    bool done = false;
+};
+
+struct texture_residency::prefetch_job
+{
+    std::uint32_t level = 0;
+    bool done = false;
+};
+
+texture_residency::texture_residency(worker_pool& pool, std::size_t const budget, std::size_t const upload_budget)
+    : m_pool{ &pool }
+    , m_budget{ budget }
+    , m_upload_budget{ upload_budget }
+{
+    constexpr std::array<unsigned char, 4> grey{ 128, 128, 128, 255 };
+    m_placeholder = upload_pixels(1, 1, 4, grey.data());
+}
+
+texture_residency::~texture_residency() noexcept
+{
+    // Decode and prefetch jobs read from the files the entries keep mapped
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_job_finished.wait(lock, [this] { return m_in_flight == 0; });
+}
+
+auto texture_residency::available(entry const& e) noexcept -> bool
+{
+    return e.file.has_value() && e.decoding == nullptr;
+}
+
+auto texture_residency::make_resident(entry& e, std::uint32_t const level) -> void
+{
+    // Immutable storage can't shrink or grow, so the texture is created anew
+    e.tex = texture{};
+
+    if(e.decoded.empty()) {
+        upload_baked_texture(e.tex, e.view, level);
+    }
+    else {
+        upload_mip_chain(e.tex, e.decoded, level);
+    }
+
+    m_stats.uploaded_bytes += e.bytes_from[level];
+    e.first_level = level;
+}
+
+auto texture_residency::add(std::string const& path) -> handle
+{
+    handle const h = m_entries.size();
+    entry& e = m_entries.emplace_back();
+    e.path = path;
+
+    mapped_file file{ path };
+    if(!file.valid()) {
+        spdlog::error("[Residency] Couldn't map {}: {}!", path, file.error());
+        return h;
+    }
+
+    if(!parse_baked_texture(file.data(), file.size(), path, e.view)) {
+        return h;
+    }
+
+    // The view points into the mapping, which doesn't move with the file
+    e.file.emplace(std::move(file));
+
+    if(baked_texture_supported(e.view)) {
+        this->start(e);
+        return h;
+    }
+
+    spdlog::info("[Residency] {} is compressed in a format the driver lacks, decoding it", path);
+
+    auto job = std::make_shared<decode_job>();
+    job->view = e.view;
+    e.decoding = job;
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        ++m_in_flight;
+    }
+
+    m_pool->submit([this, job, path] {
+        bool const ok = decompress_baked_texture(job->view, job->levels);
+        if(!ok) {
+            spdlog::error("[Residency] {} has blocks that can't be decoded!", path);
+        }
+
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        job->ok = ok;
+        job->done = true;
+        --m_in_flight;
+        m_job_finished.notify_all();
+    });
+
+    return h;
+}
+
+auto texture_residency::start(entry& e) -> void
+{
+    std::uint32_t const levels = e.view.header->levels;
+
+    e.bytes_from.assign(levels + 1, 0);
+    for(std::uint32_t i = levels; i > 0; --i) {
+        std::size_t const size = e.decoded.empty() ? static_cast<std::size_t>(e.view.levels[i - 1].size) // NOLINT
+                                                   : e.decoded[i - 1].pixels.size();
+        e.bytes_from[i - 1] = e.bytes_from[i] + size;
+    }
+
+    // First level no bigger than floor_size either way
+    e.floor_level = levels - 1;
+    while(e.floor_level > 0) {
+        baked_level const& level = e.view.levels[e.floor_level - 1]; // NOLINT
+        if(std::max(level.width, level.height) > static_cast<std::uint32_t>(floor_size)) {
+            break;
+        }
+        --e.floor_level;
+    }
+
+    e.wanted_level = e.floor_level;
+    e.requested_level = levels;
+    e.prefetched_level = e.floor_level;
+    this->make_resident(e, e.floor_level);
+
+    m_stats.resident_bytes += e.bytes_from[e.floor_level];
+}
+
+auto texture_residency::prefetch(entry& e, std::uint32_t const level) -> void
+{
+    auto job = std::make_shared<prefetch_job>();
+    job->level = level;
+    e.prefetching = job;
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        ++m_in_flight;
+    }
+
+    baked_level const& last = e.view.levels[e.prefetched_level - 1]; // NOLINT
+    unsigned char const* const begin = e.view.data + e.view.levels[level].offset; // NOLINT
+    unsigned char const* const end = e.view.data + last.offset + last.size; // NOLINT
+
+    // Reading a byte of every page is what faults them in from disk
+    m_pool->submit([this, job, begin, end] {
+        constexpr std::ptrdiff_t page_size = 4096;
+
+        for(unsigned char const* p = begin; p < end; p += std::min(page_size, end - p)) { // NOLINT
+            static_cast<void>(*static_cast<unsigned char const volatile*>(p));
+        }
+
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        job->done = true;
+        --m_in_flight;
+        m_job_finished.notify_all();
+    });
+}
+
+auto texture_residency::collect_decoded() -> void
+{
+    for(entry& e : m_entries) {
+        if(e.decoding == nullptr) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            if(!e.decoding->done) {
+                continue;
+            }
+        }
+
+        std::shared_ptr<decode_job> const job = std::move(e.decoding);
+
+        if(!job->ok) {
+            e.file.reset();
+            continue;
+        }
+
+        e.decoded = std::move(job->levels);
+        this->start(e);
+    }
+}
+
+auto texture_residency::collect_prefetched() -> void
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    for(entry& e : m_entries) {
+        if(e.prefetching != nullptr && e.prefetching->done) {
+            e.prefetched_level = std::min(e.prefetched_level, e.prefetching->level);
+            e.prefetching = nullptr;
+        }
+    }
+}
+
+auto texture_residency::request(handle const h, float const screen_pixels) noexcept -> void
+{
+    entry& e = m_entries[h];
+
+    if(!available(e)) {
+        return;
+    }
+
+    // Level whose texels are about as big as the pixels they cover
+    auto const size = static_cast<float>(std::max(e.view.header->width, e.view.header->height));
+    float const ratio = size / std::max(screen_pixels, 1.0F);
+    auto const level = ratio <= 1.0F ? 0U : static_cast<std::uint32_t>(std::floor(std::log2(ratio)));
+
+    e.requested_level = std::min({ e.requested_level, level, e.floor_level });
+    e.last_used = m_frame;
+}
+
+auto texture_residency::update() -> void
+{
+    this->collect_decoded();
+    this->collect_prefetched();
+
+    std::vector<std::size_t> order{};
+    std::size_t planned = 0;
+
+    for(std::size_t i = 0; i < m_entries.size(); ++i) {
+        entry& e = m_entries[i];
+
+        if(!available(e)) {
+            continue;
+        }
+
+        if(e.requested_level <= e.floor_level) {
+            e.wanted_level = e.requested_level;
+        }
+        else if(m_frame - e.last_used > idle_frames) {
+            e.wanted_level = e.floor_level;
+        }
+
+        e.requested_level = e.view.header->levels;
+        planned += e.bytes_from[e.wanted_level];
+        order.push_back(i);
+    }
+
+    // Least recently used first, bigger textures first among equals
+    std::sort(order.begin(), order.end(), [this](std::size_t const a, std::size_t const b) {
+        entry const& ea = m_entries[a];
+        entry const& eb = m_entries[b];
+        if(ea.last_used != eb.last_used) {
+            return ea.last_used < eb.last_used;
+        }
+        return ea.bytes_from[ea.wanted_level] > eb.bytes_from[eb.wanted_level];
+    });
+
+    for(std::size_t i : order) {
+        entry& e = m_entries[i];
+
+        while(planned > m_budget && e.wanted_level < e.floor_level) {
+            planned -= e.bytes_from[e.wanted_level] - e.bytes_from[e.wanted_level + 1];
+            ++e.wanted_level;
+        }
+    }
+
+    // Downgrades free memory, so they all happen now
+    for(std::size_t i : order) {
+        entry& e = m_entries[i];
+
+        if(e.wanted_level > e.first_level) {
+            ++(e.wanted_level == e.floor_level ? m_stats.evictions : m_stats.downgrades);
+            this->make_resident(e, e.wanted_level);
+            // The dropped levels' pages may leave the page cache from now on
+            e.prefetched_level = std::max(e.prefetched_level, e.wanted_level);
+        }
+    }
+
+    // Upgrades for the most recently used first, at least one per frame
+    std::size_t uploaded = 0;
+    for(auto it = order.rbegin(); it != order.rend(); ++it) {
+        entry& e = m_entries[*it];
+
+        if(e.wanted_level >= e.first_level) {
+            continue;
+        }
+
+        // Decoded chains are already in memory, mapped levels are read on the
+        // pool before uploading them
+        if(e.decoded.empty() && e.wanted_level < e.prefetched_level) {
+            if(e.prefetching == nullptr) {
+                this->prefetch(e, e.wanted_level);
+            }
+            continue;
+        }
+
+        std::size_t const size = e.bytes_from[e.wanted_level];
+        if(uploaded > 0 && uploaded + size > m_upload_budget) {
+            break;
+        }
+
+        uploaded += size;
+        ++m_stats.upgrades;
+        this->make_resident(e, e.wanted_level);
+    }
+
+    m_stats.resident_bytes = 0;
+    for(entry const& e : m_entries) {
+        if(available(e)) {
+            m_stats.resident_bytes += e.bytes_from[e.first_level];
+        }
+    }
+
+    ++m_frame;
+}
+
+auto texture_residency::get(handle const h) const noexcept -> texture const&
+{
+    return available(m_entries[h]) ? m_entries[h].tex : m_placeholder;
+}
+
+auto texture_residency::resident_level(handle const h) const noexcept -> std::uint32_t
+{
+    return m_entries[h].first_level;
+}
+
+auto texture_residency::budget() const noexcept -> std::size_t
+{
+    return m_budget;
+}
+
+auto texture_residency::stats() const noexcept -> statistics const&
+{
+    return m_stats;
+}
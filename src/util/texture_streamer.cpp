@@ -0,0 +1,340 @@
+#include "util/texture_streamer.hpp"
+#include "util/baked_texture.hpp"
+#include "util/gl_state.hpp"
+#include "util/mapped_file.hpp"
+#include "util/worker_pool.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t no_region = std::numeric_limits<std::size_t>::max();
+constexpr std::size_t region_alignment = 16;
+
+[[nodiscard]] constexpr auto align_region(std::size_t const size) noexcept -> std::size_t
+{
+    return (size + region_alignment - 1) / region_alignment * region_alignment;
+}
+
+using clock_type = std::chrono::steady_clock;
+
+[[nodiscard]] auto is_baked(std::string const& path) -> bool
+{
+    constexpr std::string_view extension{ ".btex" };
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+} // namespace
+
+struct texture_streamer::job
+{
+    handle target = 0;
+    std::string path{};
+    image_params params{};
+    image img{};
+    /// Baked textures are uploaded straight from the mapped file, or from
+    /// `levels` if their compression had to be decoded
+    std::unique_ptr<mapped_file> baked{};
+    baked_texture_view view{};
+    std::vector<image> levels{};
+    std::size_t offset = no_region;
+    /// Regions are only pushed and popped at the ends of the deque, so this
+    /// stays valid until the region is released after its upload
+    region* staged = nullptr;
+    bool ok = false;
+};
+
+texture_streamer::texture_streamer(worker_pool& pool, texture_cache& cache, std::size_t const staging_bytes)
+    : m_pool{ &pool }
+    , m_cache{ &cache }
+    , m_staging{ 0 }
+    , m_mapped{ nullptr }
+    , m_capacity{ 0 }
+    , m_head{ 0 }
+    , m_in_flight{ 0 }
+{
+    constexpr std::array<unsigned char, 4> grey{ 128, 128, 128, 255 };
+    m_placeholder = upload_pixels(1, 1, 4, grey.data());
+
+    if((GLAD_GL_VERSION_4_4 == 0 && GLAD_GL_ARB_buffer_storage == 0) || staging_bytes == 0) {
+        spdlog::info("[Texture Streamer] No persistent mapping, uploading from worker memory");
+        return;
+    }
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    auto const size = static_cast<GLsizeiptr>(staging_bytes);
+
+    glGenBuffers(1, &m_staging);
+    gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, m_staging);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+    m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(m_mapped == nullptr) {
+        spdlog::warn("[Texture Streamer] Couldn't map the staging buffer, uploading from worker memory!");
+        gl_state::current().forget_buffer(m_staging);
+        glDeleteBuffers(1, &m_staging);
+        m_staging = 0;
+        return;
+    }
+
+    m_capacity = staging_bytes;
+}
+
+texture_streamer::~texture_streamer() noexcept
+{
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        m_job_finished.wait(lock, [this] { return m_in_flight == 0; });
+    }
+
+    for(auto const& r : m_regions) {
+        if(r.fence != nullptr) {
+            glDeleteSync(r.fence);
+        }
+    }
+
+    if(m_staging != 0) {
+        gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, m_staging);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        gl_state::current().forget_buffer(m_staging);
+        glDeleteBuffers(1, &m_staging);
+    }
+}
+
+auto texture_streamer::try_allocate(std::size_t const size) -> std::size_t
+{
+    std::size_t const aligned = align_region(size);
+    std::size_t begin = no_region;
+
+    // Head and tail only meet when the buffer is empty, so every check below
+    // leaves at least one byte between them
+    if(m_regions.empty()) {
+        m_head = 0;
+        begin = aligned <= m_capacity ? 0 : no_region;
+    }
+    else {
+        std::size_t const tail = m_regions.front().begin;
+
+        if(m_head >= tail) {
+            if(m_head + aligned <= m_capacity) {
+                begin = m_head;
+            }
+            else if(aligned < tail) {
+                begin = 0;
+            }
+        }
+        else if(m_head + aligned < tail) {
+            begin = m_head;
+        }
+    }
+
+    if(begin != no_region) {
+        m_regions.push_back(region{ begin, aligned, nullptr, false });
+        m_head = begin + aligned;
+    }
+
+    return begin;
+}
+
+auto texture_streamer::release_regions() -> void
+{
+    while(!m_regions.empty() && m_regions.front().uploaded) {
+        region const& r = m_regions.front();
+        GLenum const status = glClientWaitSync(r.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        glDeleteSync(r.fence);
+        m_regions.pop_front();
+    }
+}
+
+auto texture_streamer::run(std::shared_ptr<job> const& j) -> void
+{
+    if(is_baked(j->path)) {
+        j->baked = std::make_unique<mapped_file>(j->path);
+
+        if(!j->baked->valid()) {
+            spdlog::error("[Texture Streamer] Couldn't map {}: {}!", j->path, j->baked->error());
+        }
+
+        j->ok = j->baked->valid() && parse_baked_texture(j->baked->data(), j->baked->size(), j->path, j->view);
+
+        if(j->ok && !baked_texture_supported(j->view)) {
+            spdlog::info("[Texture Streamer] {} is compressed in a format the driver lacks, decoding it", j->path);
+
+            if(!decompress_baked_texture(j->view, j->levels)) {
+                spdlog::error("[Texture Streamer] {} has blocks that can't be decoded!", j->path);
+                j->ok = false;
+            }
+
+            j->baked = nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_finished.push_back(j);
+        --m_in_flight;
+        m_job_finished.notify_all();
+        return;
+    }
+
+    j->ok = m_cache->load_image(j->path, j->params, j->img);
+    std::size_t const size = j->img.pixels.size();
+
+    std::unique_lock<std::mutex> lock{ m_mutex };
+
+    // Pool threads never wait for the GL thread to free staging memory, images
+    // that don't fit right now are uploaded from worker memory instead
+    if(j->ok && m_mapped != nullptr && align_region(size) < m_capacity) {
+        j->offset = this->try_allocate(size);
+
+        if(j->offset != no_region) {
+            j->staged = &m_regions.back();
+            lock.unlock();
+            std::memcpy(m_mapped + j->offset, j->img.pixels.data(), size); // NOLINT
+            j->img.pixels = std::vector<unsigned char>{};
+            lock.lock();
+        }
+    }
+
+    m_finished.push_back(j);
+    --m_in_flight;
+    m_job_finished.notify_all();
+}
+
+auto texture_streamer::request(std::string const& path, image_params const& params) -> handle
+{
+    std::string const key = fmt::format("{}\n{}\n{}", path, params.flip_vertically, params.channels);
+
+    if(auto it = m_handles.find(key); it != m_handles.end()) {
+        return it->second;
+    }
+
+    handle const h = m_textures.size();
+    m_textures.emplace_back(nullptr);
+    m_handles.emplace(key, h);
+    ++m_stats.requested;
+
+    auto j = std::make_shared<job>();
+    j->target = h;
+    j->path = path;
+    j->params = params;
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        ++m_in_flight;
+    }
+
+    m_pool->submit([this, j] { this->run(j); });
+    return h;
+}
+
+auto texture_streamer::update(std::chrono::microseconds const budget) -> void
+{
+    auto const start = clock_type::now();
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        this->release_regions();
+
+        std::move(m_finished.begin(), m_finished.end(), std::back_inserter(m_ready));
+        m_finished.clear();
+    }
+
+    // Elapsed time is compared in microseconds, converting `budget` up to the
+    // clock's period would overflow for `microseconds::max()`
+    auto const within_budget = [&] {
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - start) < budget;
+    };
+
+    // At least one upload per call, so a tight budget still makes progress
+    for(bool first = true; !m_ready.empty() && (first || within_budget()); first = false) {
+        std::shared_ptr<job> const j = std::move(m_ready.front());
+        m_ready.pop_front();
+
+        if(!j->ok) {
+            ++m_stats.failed;
+            continue;
+        }
+
+        std::shared_ptr<texture> tex{};
+
+        if(!j->levels.empty()) {
+            tex = std::make_shared<texture>();
+            upload_mip_chain(*tex, j->levels);
+        }
+        else if(j->baked != nullptr) {
+            tex = std::make_shared<texture>();
+            upload_baked_texture(*tex, j->view);
+        }
+        else if(j->offset != no_region) {
+            gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, m_staging);
+            tex = std::make_shared<texture>(upload_pixels(j->img.width,
+                                                          j->img.height,
+                                                          j->img.channels,
+                                                          reinterpret_cast<void const*>(j->offset))); // NOLINT
+            gl_state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            GLsync const fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            j->staged->fence = fence;
+            j->staged->uploaded = true;
+
+            ++m_stats.staged;
+        }
+        else {
+            tex = std::make_shared<texture>(upload_image(j->img));
+        }
+
+        m_textures[j->target] = std::move(tex);
+        ++m_stats.uploaded;
+    }
+}
+
+auto texture_streamer::finish() -> void
+{
+    while(true) {
+        this->update(std::chrono::microseconds::max());
+
+        if(this->pending() == 0) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        m_job_finished.wait_for(lock, std::chrono::milliseconds{ 1 }, [this] { return !m_finished.empty(); });
+    }
+}
+
+auto texture_streamer::ready(handle const h) const noexcept -> bool
+{
+    return m_textures[h] != nullptr;
+}
+
+auto texture_streamer::get(handle const h) const noexcept -> texture const&
+{
+    return m_textures[h] != nullptr ? *m_textures[h] : m_placeholder;
+}
+
+auto texture_streamer::pending() const noexcept -> std::size_t
+{
+    return m_stats.requested - m_stats.uploaded - m_stats.failed;
+}
+
+auto texture_streamer::stats() const noexcept -> statistics const&
+{
+    return m_stats;
+}
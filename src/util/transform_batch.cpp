@@ -0,0 +1,337 @@
+#include "util/transform_batch.hpp"
+#include "util/worker_pool.hpp"
+
+#include "simd.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+///
+/// Matrix entries of one object, column major, same layout as `glm::mat4`.
+///
+constexpr std::size_t mat4_floats = 16;
+
+auto write_matrix(float const q[4], float const p[3], float* const m) noexcept -> void // NOLINT
+{
+    float const x = q[0];
+    float const y = q[1];
+    float const z = q[2];
+    float const w = q[3];
+
+    // glm::mat3_cast
+    m[0] = 1.0F - 2.0F * (y * y + z * z);
+    m[1] = 2.0F * (x * y + w * z);
+    m[2] = 2.0F * (x * z - w * y);
+    m[3] = 0.0F;
+
+    m[4] = 2.0F * (x * y - w * z);
+    m[5] = 1.0F - 2.0F * (x * x + z * z);
+    m[6] = 2.0F * (y * z + w * x);
+    m[7] = 0.0F;
+
+    m[8] = 2.0F * (x * z + w * y);
+    m[9] = 2.0F * (y * z - w * x);
+    m[10] = 1.0F - 2.0F * (x * x + y * y);
+    m[11] = 0.0F;
+
+    m[12] = p[0];
+    m[13] = p[1];
+    m[14] = p[2];
+    m[15] = 1.0F;
+}
+
+struct soa_view
+{
+    float const* px;
+    float const* py;
+    float const* pz;
+    float const* ax;
+    float const* ay;
+    float const* az;
+    float const* speed;
+    /// Object of each output matrix, `nullptr` for `out[i]` being object `i`
+    std::uint32_t const* indices;
+
+    [[nodiscard]] auto object(std::size_t const i) const noexcept -> std::size_t
+    {
+        return indices == nullptr ? i : indices[i];
+    }
+};
+
+auto compute_narrow(soa_view const& data,
+                    float const time,
+                    glm::mat4* const out,
+                    std::size_t const begin,
+                    std::size_t const end) noexcept -> void
+{
+    for(std::size_t i = begin; i < end; ++i) {
+        std::size_t const j = data.object(i);
+        float const half_angle = 0.5F * data.speed[j] * time;
+        float const s = std::sin(half_angle);
+
+        float const q[4] = { data.ax[j] * s, data.ay[j] * s, data.az[j] * s, std::cos(half_angle) }; // NOLINT
+        float const p[3] = { data.px[j], data.py[j], data.pz[j] };                                   // NOLINT
+
+        write_matrix(q, p, &out[i][0][0]);
+    }
+}
+
+#if defined(UTIL_SIMD)
+
+using simd::simd_float;
+
+///
+/// `x` is odd, for non-negative integer valued `x`.
+///
+inline auto is_odd(simd_float const x) noexcept -> simd_float
+{
+    simd_float const half = simd_float::set(0.5F);
+    simd_float const h = floor_positive(x * half);
+    return equal(x - (h + h), simd_float::set(1.0F));
+}
+
+///
+/// Cephes' single precision sine and cosine, computed together: reduce to
+/// [-pi/4, pi/4] around the nearest multiple of pi/2, evaluate both
+/// polynomials, then pick and negate based on the octant.
+///
+inline auto sincos(simd_float const a, simd_float& s, simd_float& c) noexcept -> void
+{
+    simd_float const one = simd_float::set(1.0F);
+    simd_float const half = simd_float::set(0.5F);
+
+    simd_float const sign_negative = less(a, simd_float::set(0.0F));
+    simd_float x = abs(a);
+
+    // k: index of the nearest multiple of pi/2, j = 2k in Cephes' terms
+    constexpr float four_over_pi = 1.27323954473516F;
+    simd_float const k = floor_positive((floor_positive(x * simd_float::set(four_over_pi)) + one) * half);
+    simd_float const j = k + k;
+
+    constexpr float dp1 = 0.78515625F;
+    constexpr float dp2 = 2.4187564849853515625e-4F;
+    constexpr float dp3 = 3.77489497744594108e-8F;
+    x = ((x - j * simd_float::set(dp1)) - j * simd_float::set(dp2)) - j * simd_float::set(dp3);
+
+    simd_float const swap = is_odd(k);
+    simd_float const flip_sin = mask_xor(sign_negative, is_odd(floor_positive(k * half)));
+    simd_float const flip_cos = is_odd(floor_positive((k + one) * half));
+
+    simd_float const z = x * x;
+
+    constexpr float c0 = 2.443315711809948E-005F;
+    constexpr float c1 = -1.388731625493765E-003F;
+    constexpr float c2 = 4.166664568298827E-002F;
+    simd_float const cos_poly =
+        ((simd_float::set(c0) * z + simd_float::set(c1)) * z + simd_float::set(c2)) * z * z - half * z + one;
+
+    constexpr float s0 = -1.9515295891E-4F;
+    constexpr float s1 = 8.3321608736E-3F;
+    constexpr float s2 = -1.6666654611E-1F;
+    simd_float const sin_poly = ((simd_float::set(s0) * z + simd_float::set(s1)) * z + simd_float::set(s2)) * z * x + x;
+
+    simd_float const sin_value = select(swap, cos_poly, sin_poly);
+    simd_float const cos_value = select(swap, sin_poly, cos_poly);
+
+    s = select(flip_sin, negate(sin_value), sin_value);
+    c = select(flip_cos, negate(cos_value), cos_value);
+}
+
+///
+/// Lanes `[begin, begin + width)` of `src`, gathered through the indices if
+/// there are any.
+///
+[[nodiscard]] auto load_lanes(float const* const src, soa_view const& data, std::size_t const begin) noexcept
+    -> simd_float
+{
+    if(data.indices == nullptr) {
+        return simd_float::load(src + begin);
+    }
+
+    alignas(32) float lanes[simd_float::width]; // NOLINT
+    for(std::size_t lane = 0; lane < simd_float::width; ++lane) {
+        lanes[lane] = src[data.indices[begin + lane]];
+    }
+
+    return simd_float::load(lanes);
+}
+
+///
+/// Processes whole batches of `simd_float::width` objects starting at `begin`,
+/// returns the first object that didn't fit in a batch.
+///
+auto compute_wide(soa_view const& data, float const time, glm::mat4* const out, std::size_t begin, std::size_t const end)
+    -> std::size_t
+{
+    constexpr std::size_t w = simd_float::width;
+
+    simd_float const one = simd_float::set(1.0F);
+    simd_float const two = simd_float::set(2.0F);
+    simd_float const half_time = simd_float::set(0.5F * time);
+
+    alignas(32) float entries[mat4_floats][w]; // NOLINT
+
+    for(; begin + w <= end; begin += w) {
+        simd_float s{};
+        simd_float c{};
+        sincos(load_lanes(data.speed, data, begin) * half_time, s, c);
+
+        simd_float const x = load_lanes(data.ax, data, begin) * s;
+        simd_float const y = load_lanes(data.ay, data, begin) * s;
+        simd_float const z = load_lanes(data.az, data, begin) * s;
+        simd_float const qw = c;
+
+        simd_float const xx = x * x;
+        simd_float const yy = y * y;
+        simd_float const zz = z * z;
+        simd_float const xy = x * y;
+        simd_float const xz = x * z;
+        simd_float const yz = y * z;
+        simd_float const wx = qw * x;
+        simd_float const wy = qw * y;
+        simd_float const wz = qw * z;
+
+        (one - two * (yy + zz)).store(entries[0]);
+        (two * (xy + wz)).store(entries[1]);
+        (two * (xz - wy)).store(entries[2]);
+        (two * (xy - wz)).store(entries[4]);
+        (one - two * (xx + zz)).store(entries[5]);
+        (two * (yz + wx)).store(entries[6]);
+        (two * (xz + wy)).store(entries[8]);
+        (two * (yz - wx)).store(entries[9]);
+        (one - two * (xx + yy)).store(entries[10]);
+        load_lanes(data.px, data, begin).store(entries[12]);
+        load_lanes(data.py, data, begin).store(entries[13]);
+        load_lanes(data.pz, data, begin).store(entries[14]);
+
+        // Transpose into one contiguous matrix per object
+        for(std::size_t lane = 0; lane < w; ++lane) {
+            float* const m = &out[begin + lane][0][0];
+
+            m[0] = entries[0][lane];
+            m[1] = entries[1][lane];
+            m[2] = entries[2][lane];
+            m[3] = 0.0F;
+            m[4] = entries[4][lane];
+            m[5] = entries[5][lane];
+            m[6] = entries[6][lane];
+            m[7] = 0.0F;
+            m[8] = entries[8][lane];
+            m[9] = entries[9][lane];
+            m[10] = entries[10][lane];
+            m[11] = 0.0F;
+            m[12] = entries[12][lane];
+            m[13] = entries[13][lane];
+            m[14] = entries[14][lane];
+            m[15] = 1.0F;
+        }
+    }
+
+    return begin;
+}
+
+#endif
+
+} // namespace
+
+auto transform_batch::reserve(std::size_t const count) -> void
+{
+    for(auto* v : { &m_px, &m_py, &m_pz, &m_ax, &m_ay, &m_az, &m_speed }) {
+        v->reserve(count);
+    }
+}
+
+auto transform_batch::clear() noexcept -> void
+{
+    for(auto* v : { &m_px, &m_py, &m_pz, &m_ax, &m_ay, &m_az, &m_speed }) {
+        v->clear();
+    }
+}
+
+auto transform_batch::add(glm::vec3 const& position, glm::vec3 const& axis, float const angular_speed) -> void
+{
+    m_px.push_back(position.x);
+    m_py.push_back(position.y);
+    m_pz.push_back(position.z);
+    m_ax.push_back(axis.x);
+    m_ay.push_back(axis.y);
+    m_az.push_back(axis.z);
+    m_speed.push_back(angular_speed);
+}
+
+auto transform_batch::size() const noexcept -> std::size_t
+{
+    return m_speed.size();
+}
+
+auto transform_batch::simd_width() noexcept -> std::size_t
+{
+#if defined(UTIL_SIMD)
+    return simd_float::width;
+#else
+    return 1;
+#endif
+}
+
+auto transform_batch::compute_scalar(float const time,
+                                     glm::mat4* const out,
+                                     std::size_t const begin,
+                                     std::size_t const end) const noexcept -> void
+{
+    soa_view const data{
+        m_px.data(), m_py.data(), m_pz.data(), m_ax.data(), m_ay.data(), m_az.data(), m_speed.data(), nullptr
+    };
+    compute_narrow(data, time, out, begin, end);
+}
+
+auto transform_batch::compute_simd(float const time,
+                                   glm::mat4* const out,
+                                   std::size_t const begin,
+                                   std::size_t const end) const noexcept -> void
+{
+    this->compute_simd(time, nullptr, out, begin, end);
+}
+
+auto transform_batch::compute_simd(float const time,
+                                   std::uint32_t const* const indices,
+                                   glm::mat4* const out,
+                                   std::size_t const begin,
+                                   std::size_t const end) const noexcept -> void
+{
+    soa_view const data{
+        m_px.data(), m_py.data(), m_pz.data(), m_ax.data(), m_ay.data(), m_az.data(), m_speed.data(), indices
+    };
+
+#if defined(UTIL_SIMD)
+    std::size_t const rest = compute_wide(data, time, out, begin, end);
+    compute_narrow(data, time, out, rest, end);
+#else
+    compute_narrow(data, time, out, begin, end);
+#endif
+}
+
+auto transform_batch::compute(float const time, glm::mat4* const out, worker_pool* const pool) const -> void
+{
+    this->compute(time, nullptr, this->size(), out, pool);
+}
+
+auto transform_batch::compute(float const time,
+                              std::uint32_t const* const indices,
+                              std::size_t const count,
+                              glm::mat4* const out,
+                              worker_pool* const pool) const -> void
+{
+    // Below this many objects per chunk the hand-off costs more than it saves
+    constexpr std::size_t grain = 4096;
+
+    if(pool == nullptr || count <= grain) {
+        this->compute_simd(time, indices, out, 0, count);
+        return;
+    }
+
+    pool->parallel_for(count, grain, [this, time, indices, out](std::size_t const begin, std::size_t const end) {
+        this->compute_simd(time, indices, out, begin, end);
+    });
+}
@@ -0,0 +1,46 @@
+#include "util/vertex_array.hpp"
+#include "util/gl_state.hpp"
+
+#include <glad/glad.h>
+
+#include <utility>
+
+vertex_array::vertex_array()
+    : m_id{ 0 }
+{
+    glGenVertexArrays(1, &m_id);
+}
+
+vertex_array::vertex_array(vertex_array&& other) noexcept
+    : m_id{ std::exchange(other.m_id, 0) }
+{
+}
+
+vertex_array::~vertex_array() noexcept
+{
+    if(m_id != 0) {
+        gl_state::current().forget_vertex_array(m_id);
+        glDeleteVertexArrays(1, &m_id);
+    }
+}
+
+auto vertex_array::operator=(vertex_array&& other) noexcept -> vertex_array&
+{
+    std::swap(m_id, other.m_id);
+    return *this;
+}
+
+auto vertex_array::bind() const noexcept -> void
+{
+    gl_state::current().bind_vertex_array(m_id);
+}
+
+auto vertex_array::unbind() noexcept -> void
+{
+    gl_state::current().bind_vertex_array(0);
+}
+
+auto vertex_array::id() const noexcept -> unsigned int
+{
+    return m_id;
+}
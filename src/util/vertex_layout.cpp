@@ -0,0 +1,50 @@
+#include "util/vertex_layout.hpp"
+#include "util/gl_state.hpp"
+#include "util/vertex_array.hpp"
+
+auto apply_vertex_attributes(vertex_array const& vao,
+                             unsigned int const vbo,
+                             std::size_t const stride,
+                             vertex_attribute const* const attributes,
+                             std::size_t const count,
+                             unsigned int const binding,
+                             unsigned int const divisor) noexcept -> void
+{
+    vao.bind();
+
+    // Separate formats don't touch GL_ARRAY_BUFFER and let a vertex array
+    // switch buffers with a single glBindVertexBuffer
+    if(GLAD_GL_VERSION_4_3 != 0 || GLAD_GL_ARB_vertex_attrib_binding != 0) {
+        glBindVertexBuffer(binding, vbo, 0, static_cast<GLsizei>(stride));
+        glVertexBindingDivisor(binding, divisor);
+
+        for(std::size_t i = 0; i < count; ++i) {
+            vertex_attribute const& attribute = attributes[i]; // NOLINT
+
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribFormat(attribute.location,
+                                 attribute.components,
+                                 attribute.type,
+                                 attribute.normalized ? GL_TRUE : GL_FALSE,
+                                 static_cast<GLuint>(attribute.offset));
+            glVertexAttribBinding(attribute.location, binding);
+        }
+
+        return;
+    }
+
+    gl_state::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        vertex_attribute const& attribute = attributes[i]; // NOLINT
+
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribPointer(attribute.location,
+                              attribute.components,
+                              attribute.type,
+                              attribute.normalized ? GL_TRUE : GL_FALSE,
+                              static_cast<GLsizei>(stride),
+                              reinterpret_cast<void const*>(attribute.offset)); // NOLINT
+        glVertexAttribDivisor(attribute.location, divisor);
+    }
+}
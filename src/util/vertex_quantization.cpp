@@ -0,0 +1,188 @@
+#include "util/vertex_quantization.hpp"
+#include "util/shader.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr float snorm16_max = 32767.0F;
+constexpr float unorm16_max = 65535.0F;
+
+struct bounds
+{
+    std::array<float, 3> min{};
+    std::array<float, 3> max{};
+};
+
+[[nodiscard]] auto bounds_of(mesh const& source, std::size_t const offset, std::size_t const components) -> bounds
+{
+    bounds result{};
+    result.min.fill(std::numeric_limits<float>::max());
+    result.max.fill(std::numeric_limits<float>::lowest());
+
+    for(std::size_t v = 0; v < source.vertex_count(); ++v) {
+        for(std::size_t c = 0; c < components; ++c) {
+            float const value = source.vertices[v * source.stride + offset + c];
+            result.min[c] = std::min(result.min[c], value);
+            result.max[c] = std::max(result.max[c], value);
+        }
+    }
+
+    return result;
+}
+
+/// Half the extent, so [-1, 1] covers it. Flat axes keep a scale of 1
+[[nodiscard]] auto half_extent(bounds const& b, std::size_t const axis) noexcept -> float
+{
+    float const extent = (b.max[axis] - b.min[axis]) * 0.5F;
+    return extent > 0.0F ? extent : 1.0F;
+}
+
+template<typename T>
+auto append(std::vector<std::uint8_t>& out, T const value) -> void
+{
+    std::array<std::uint8_t, sizeof(T)> bytes{};
+    std::memcpy(bytes.data(), &value, sizeof(T));
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+} // namespace
+
+auto quantized_mesh::vertex_count() const noexcept -> std::size_t
+{
+    return stride == 0 ? 0 : vertices.size() / stride;
+}
+
+auto quantize_snorm16(float const value) noexcept -> std::int16_t
+{
+    return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0F, 1.0F) * snorm16_max));
+}
+
+auto quantize_unorm16(float const value) noexcept -> std::uint16_t
+{
+    return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * unorm16_max));
+}
+
+auto encode_octahedral(glm::vec3 const& normal) noexcept -> glm::vec2
+{
+    float const sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+    // Also catches NaN, which would be undefined once converted to snorm16
+    if(!(sum > 0.0F)) {
+        return glm::vec2{ 0.0F, 0.0F };
+    }
+
+    glm::vec2 result{ normal.x / sum, normal.y / sum };
+
+    // Fold the lower half over the diagonals
+    if(normal.z < 0.0F) {
+        float const x = result.x;
+        result.x = (1.0F - std::abs(result.y)) * (x >= 0.0F ? 1.0F : -1.0F);
+        result.y = (1.0F - std::abs(x)) * (result.y >= 0.0F ? 1.0F : -1.0F);
+    }
+
+    return result;
+}
+
+auto decode_octahedral(glm::vec2 const& encoded) noexcept -> glm::vec3
+{
+    glm::vec3 n{ encoded.x, encoded.y, 1.0F - std::abs(encoded.x) - std::abs(encoded.y) };
+    float const t = std::max(-n.z, 0.0F);
+    n.x += n.x >= 0.0F ? -t : t;
+    n.y += n.y >= 0.0F ? -t : t;
+
+    float const length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    return glm::vec3{ n.x / length, n.y / length, n.z / length };
+}
+
+auto quantize_mesh(mesh const& source, quantize_attributes const& attributes, std::string const& name)
+    -> quantized_mesh
+{
+    bool const has_uv = attributes.uv != quantize_attributes::none;
+    bool const has_normal = attributes.normal != quantize_attributes::none;
+
+    quantized_mesh result{};
+    result.indices = source.indices;
+    result.stride = 4 * sizeof(std::int16_t) + (has_uv ? 2 * sizeof(std::uint16_t) : 0) +
+                    (has_normal ? 2 * sizeof(std::int16_t) : 0);
+    result.vertices.reserve(source.vertex_count() * result.stride);
+
+    bounds const positions = bounds_of(source, attributes.position, 3);
+    for(std::size_t axis = 0; axis < 3; ++axis) {
+        result.position_scale[static_cast<int>(axis)] = half_extent(positions, axis);
+        result.position_offset[static_cast<int>(axis)] = (positions.min[axis] + positions.max[axis]) * 0.5F;
+    }
+
+    if(has_uv) {
+        bounds const uvs = bounds_of(source, attributes.uv, 2);
+        for(std::size_t axis = 0; axis < 2; ++axis) {
+            float const extent = uvs.max[axis] - uvs.min[axis];
+            result.uv_transform[static_cast<int>(axis)] = extent > 0.0F ? extent : 1.0F;
+            result.uv_transform[static_cast<int>(axis) + 2] = uvs.min[axis];
+        }
+    }
+
+    float max_error = 0.0F;
+
+    for(std::size_t v = 0; v < source.vertex_count(); ++v) {
+        float const* const vertex = &source.vertices[v * source.stride];
+
+        for(std::size_t axis = 0; axis < 3; ++axis) {
+            auto const i = static_cast<int>(axis);
+            float const value = vertex[attributes.position + axis]; // NOLINT
+            std::int16_t const q = quantize_snorm16((value - result.position_offset[i]) / result.position_scale[i]);
+            append(result.vertices, q);
+
+            float const decoded = static_cast<float>(q) / snorm16_max * result.position_scale[i] +
+                                  result.position_offset[i];
+            max_error = std::max(max_error, std::abs(decoded - value));
+        }
+
+        append(result.vertices, std::int16_t{ 0 });
+
+        if(has_uv) {
+            for(std::size_t axis = 0; axis < 2; ++axis) {
+                auto const i = static_cast<int>(axis);
+                float const value = vertex[attributes.uv + axis]; // NOLINT
+                float const normalized = (value - result.uv_transform[i + 2]) / result.uv_transform[i];
+                append(result.vertices, quantize_unorm16(normalized));
+            }
+        }
+
+        if(has_normal) {
+            float const* const n = vertex + attributes.normal; // NOLINT
+            glm::vec2 const encoded = encode_octahedral(glm::vec3{ n[0], n[1], n[2] }); // NOLINT
+            append(result.vertices, quantize_snorm16(encoded.x));
+            append(result.vertices, quantize_snorm16(encoded.y));
+        }
+    }
+
+    std::size_t const source_stride = source.stride * sizeof(float);
+    std::size_t const source_bytes = source.vertex_count() * source_stride;
+    double const ratio =
+        source_bytes == 0 ? 1.0 : static_cast<double>(result.vertices.size()) / static_cast<double>(source_bytes);
+
+    spdlog::info("[Mesh Quantizer] {}: {} -> {} bytes per vertex, {} -> {} bytes of vertices ({:.0f}% less to fetch), "
+                 "max position error {:.2g}",
+                 name,
+                 source_stride,
+                 result.stride,
+                 source_bytes,
+                 result.vertices.size(),
+                 100.0 * (1.0 - ratio),
+                 max_error);
+
+    return result;
+}
+
+auto set_quantization_uniforms(shader const& program, quantized_mesh const& m) noexcept -> void
+{
+    program.set_vec4("quantized_position_scale", m.position_scale);
+    program.set_vec4("quantized_position_offset", m.position_offset);
+    program.set_vec4("quantized_uv_transform", m.uv_transform);
+}
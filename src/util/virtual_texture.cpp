@@ -0,0 +1,537 @@
+#include "util/virtual_texture.hpp"
+#include "util/gl_state.hpp"
+#include "util/texture2d.hpp"
+#include "util/worker_pool.hpp"
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace {
+
+constexpr std::size_t page_alignment = 16;
+constexpr std::size_t no_slot = ~std::size_t{ 0 };
+
+[[nodiscard]] auto align(std::size_t const value) noexcept -> std::size_t
+{
+    return (value + page_alignment - 1) / page_alignment * page_alignment;
+}
+
+[[nodiscard]] auto pages_offset(std::uint32_t const levels) noexcept -> std::size_t
+{
+    return align(sizeof(virtual_texture_header) + levels * sizeof(virtual_level));
+}
+
+[[nodiscard]] auto next_power_of_two(std::uint32_t const value) noexcept -> std::uint32_t
+{
+    std::uint32_t result = 1;
+    while(result < value) {
+        result *= 2;
+    }
+    return result;
+}
+
+[[nodiscard]] auto level_extent(std::uint32_t const size, std::uint32_t const level) noexcept -> std::uint32_t
+{
+    return std::max(size >> level, std::uint32_t{ 1 });
+}
+
+[[nodiscard]] auto to_rgba(image const& source) -> image
+{
+    if(source.channels == 4) {
+        return source;
+    }
+
+    image result{};
+    result.width = source.width;
+    result.height = source.height;
+    result.channels = 4;
+
+    auto const count = static_cast<std::size_t>(source.width) * static_cast<std::size_t>(source.height);
+    auto const channels = static_cast<std::size_t>(source.channels);
+    bool const grey = source.channels < 3;
+    bool const alpha = source.channels == 2;
+    result.pixels.resize(count * 4);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        unsigned char const* const in = &source.pixels[i * channels];
+        unsigned char* const out = &result.pixels[i * 4];
+
+        for(std::size_t c = 0; c < 3; ++c) {
+            out[c] = grey ? in[0] : in[c]; // NOLINT
+        }
+        out[3] = alpha ? in[1] : 255; // NOLINT
+    }
+
+    return result;
+}
+
+} // namespace
+
+auto virtual_texture_view::page_bytes() const noexcept -> std::size_t
+{
+    std::size_t const side = header->page_size + 2 * header->border;
+    return side * side * 4;
+}
+
+auto virtual_texture_view::page(std::uint32_t const level, std::uint32_t const x, std::uint32_t const y) const noexcept
+    -> unsigned char const*
+{
+    virtual_level const& l = levels[level]; // NOLINT
+    std::size_t const index = l.first_page + static_cast<std::size_t>(y) * l.pages_x + x;
+    return pages + index * this->page_bytes(); // NOLINT
+}
+
+auto bake_virtual_texture(image const& source,
+                          std::uint32_t const page_size,
+                          std::uint32_t const border,
+                          bake_options const& options) -> std::vector<unsigned char>
+{
+    // Pages come out of a regular baked mip chain, always uncompressed since
+    // they get filtered across page edges
+    std::vector<unsigned char> const chain = bake_texture(to_rgba(source), bake_options{ options.srgb, std::nullopt });
+    baked_texture_view chain_view{};
+
+    if(page_size == 0 || !parse_baked_texture(chain.data(), chain.size(), "virtual texture mip chain", chain_view)) {
+        return {};
+    }
+
+    virtual_texture_header header{};
+    header.width = chain_view.header->width;
+    header.height = chain_view.header->height;
+    header.page_size = page_size;
+    header.border = border;
+    header.internal_format = chain_view.header->internal_format;
+
+    std::vector<virtual_level> levels{};
+    std::uint64_t total_pages = 0;
+
+    for(std::uint32_t i = 0; i < chain_view.header->levels; ++i) {
+        baked_level const& level = chain_view.levels[i]; // NOLINT
+
+        virtual_level l{};
+        l.first_page = total_pages;
+        l.width = level.width;
+        l.height = level.height;
+        l.pages_x = (level.width + page_size - 1) / page_size;
+        l.pages_y = (level.height + page_size - 1) / page_size;
+        levels.push_back(l);
+        total_pages += static_cast<std::uint64_t>(l.pages_x) * l.pages_y;
+
+        if(l.pages_x == 1 && l.pages_y == 1) {
+            break;
+        }
+    }
+
+    header.levels = static_cast<std::uint32_t>(levels.size());
+
+    std::size_t const offset = pages_offset(header.levels);
+    std::size_t const side = page_size + 2 * border;
+    std::size_t const page_bytes = side * side * 4;
+    std::vector<unsigned char> result(offset + total_pages * page_bytes, 0);
+
+    std::memcpy(result.data(), &header, sizeof(header));
+    std::memcpy(result.data() + sizeof(header), levels.data(), levels.size() * sizeof(virtual_level));
+
+    unsigned char* out = result.data() + offset;
+
+    for(std::size_t i = 0; i < levels.size(); ++i) {
+        virtual_level const& l = levels[i];
+        unsigned char const* const pixels = chain.data() + chain_view.levels[i].offset; // NOLINT
+        auto const last_x = static_cast<long>(l.width) - 1;
+        auto const last_y = static_cast<long>(l.height) - 1;
+
+        for(std::uint32_t py = 0; py < l.pages_y; ++py) {
+            for(std::uint32_t px = 0; px < l.pages_x; ++px) {
+                // Borders and the part of edge pages past the level repeat its edge texels
+                for(std::size_t y = 0; y < side; ++y) {
+                    long const sy =
+                        std::clamp(static_cast<long>(py * page_size + y) - static_cast<long>(border), 0L, last_y);
+
+                    for(std::size_t x = 0; x < side; ++x) {
+                        long const sx =
+                            std::clamp(static_cast<long>(px * page_size + x) - static_cast<long>(border), 0L, last_x);
+                        std::size_t const texel = static_cast<std::size_t>(sy) * l.width + static_cast<std::size_t>(sx);
+                        std::memcpy(out, pixels + texel * 4, 4); // NOLINT
+                        out += 4; // NOLINT
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+auto parse_virtual_texture(unsigned char const* const data,
+                           std::size_t const size,
+                           std::string const& name,
+                           virtual_texture_view& view) -> bool
+{
+    if(data == nullptr || size < sizeof(virtual_texture_header)) {
+        spdlog::error("[Virtual Texture] {} is too small to be a virtual texture!", name);
+        return false;
+    }
+
+    auto const* const header = reinterpret_cast<virtual_texture_header const*>(data); // NOLINT
+
+    if(header->magic != virtual_texture_header::file_magic || header->version != virtual_texture_header::file_version) {
+        spdlog::error(
+            "[Virtual Texture] {} isn't a virtual texture of version {}!", name, virtual_texture_header::file_version);
+        return false;
+    }
+
+    if(header->levels == 0 || header->levels > 32 || header->page_size == 0 || size < pages_offset(header->levels)) {
+        spdlog::error("[Virtual Texture] {} has a broken header!", name);
+        return false;
+    }
+
+    auto const* const levels = reinterpret_cast<virtual_level const*>(data + sizeof(virtual_texture_header)); // NOLINT
+    std::uint64_t total_pages = 0;
+
+    for(std::uint32_t i = 0; i < header->levels; ++i) {
+        virtual_level const& level = levels[i]; // NOLINT
+        bool const sized =
+            level.width == level_extent(header->width, i) && level.height == level_extent(header->height, i);
+
+        if(!sized || level.first_page != total_pages ||
+           level.pages_x != (level.width + header->page_size - 1) / header->page_size ||
+           level.pages_y != (level.height + header->page_size - 1) / header->page_size) {
+            spdlog::error("[Virtual Texture] {} has a broken level {}!", name, i);
+            return false;
+        }
+
+        total_pages += static_cast<std::uint64_t>(level.pages_x) * level.pages_y;
+    }
+
+    view.header = header;
+    view.levels = levels;
+    view.pages = data + pages_offset(header->levels); // NOLINT
+
+    if(total_pages > (size - pages_offset(header->levels)) / view.page_bytes()) {
+        spdlog::error("[Virtual Texture] {} is truncated!", name);
+        return false;
+    }
+
+    return true;
+}
+
+virtual_texture::virtual_texture(worker_pool& pool,
+                                 std::string const& path,
+                                 std::uint32_t const cache_side,
+                                 std::size_t const uploads_per_frame)
+    : m_pool{ &pool }
+    , m_file{ std::make_unique<mapped_file>(path) }
+    , m_cache_side{ std::clamp(cache_side, std::uint32_t{ 1 }, std::uint32_t{ 256 }) }
+    , m_uploads_per_frame{ std::max(uploads_per_frame, std::size_t{ 1 }) }
+{
+    if(!m_file->valid()) {
+        spdlog::error("[Virtual Texture] Couldn't map {}: {}!", path, m_file->error());
+        return;
+    }
+
+    if(!parse_virtual_texture(m_file->data(), m_file->size(), path, m_view)) {
+        return;
+    }
+
+    virtual_texture_header const& header = *m_view.header;
+    std::uint32_t const slot_size = header.page_size + 2 * header.border;
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+    if(m_cache_side * slot_size > static_cast<std::uint32_t>(max_size)) {
+        m_cache_side = std::max(static_cast<std::uint32_t>(max_size) / slot_size, std::uint32_t{ 1 });
+        spdlog::warn(
+            "[Virtual Texture] Page cache limited to {}x{} pages by the max texture size!", m_cache_side, m_cache_side);
+    }
+
+    auto const cache_size = static_cast<int>(m_cache_side * slot_size);
+    allocate_texture_storage(m_cache, 1, header.internal_format, cache_size, cache_size);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // A power of two grid, so every level of it is exactly half the one above
+    // and covers the pages of the matching texture level
+    m_indirection_width = next_power_of_two(m_view.levels[0].pages_x);
+    m_indirection_height = next_power_of_two(m_view.levels[0].pages_y);
+    m_entries.resize(header.levels);
+
+    m_indirection.bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header.levels - 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    for(std::uint32_t i = 0; i < header.levels; ++i) {
+        std::uint32_t const width = level_extent(m_indirection_width, i);
+        std::uint32_t const height = level_extent(m_indirection_height, i);
+        m_entries[i].assign(static_cast<std::size_t>(width) * height * 4, 0);
+
+        glTexImage2D(GL_TEXTURE_2D,
+                     static_cast<GLint>(i),
+                     GL_RGBA8UI,
+                     static_cast<GLsizei>(width),
+                     static_cast<GLsizei>(height),
+                     0,
+                     GL_RGBA_INTEGER,
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+    }
+
+    m_slots.resize(static_cast<std::size_t>(m_cache_side) * m_cache_side, slot{ no_page, 0, false });
+
+    // Whatever isn't resident falls back to the last level, so it never leaves
+    std::uint32_t const last = header.levels - 1;
+    this->upload_page(0, this->key_of(last, 0, 0), m_view.page(last, 0, 0));
+    m_slots[0].pinned = true;
+    this->rebuild_indirection();
+
+    m_valid = true;
+}
+
+virtual_texture::~virtual_texture() noexcept
+{
+    // Jobs read from the mapping, which has to outlive them
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_job_finished.wait(lock, [this] { return m_in_flight == 0; });
+}
+
+auto virtual_texture::key_of(std::uint32_t const level, std::uint32_t const x, std::uint32_t const y) const noexcept
+    -> std::uint64_t
+{
+    return (static_cast<std::uint64_t>(level) << 48U) | (static_cast<std::uint64_t>(y) << 24U) | x;
+}
+
+auto virtual_texture::take_slot() -> std::size_t
+{
+    std::size_t oldest = no_slot;
+
+    for(std::size_t i = 0; i < m_slots.size(); ++i) {
+        slot const& s = m_slots[i];
+
+        if(s.key == no_page) {
+            return i;
+        }
+
+        // Pages used this frame are on screen, evicting them would only bring them back
+        if(!s.pinned && s.last_used < m_frame && (oldest == no_slot || s.last_used < m_slots[oldest].last_used)) {
+            oldest = i;
+        }
+    }
+
+    if(oldest != no_slot) {
+        m_resident.erase(m_slots[oldest].key);
+        m_slots[oldest].key = no_page;
+        m_dirty = true;
+        ++m_stats.evicted;
+    }
+
+    return oldest;
+}
+
+auto virtual_texture::upload_page(std::size_t const slot_index,
+                                  std::uint64_t const key,
+                                  unsigned char const* const pixels) noexcept -> void
+{
+    auto const slot_size = static_cast<GLsizei>(m_view.header->page_size + 2 * m_view.header->border);
+    auto const x = static_cast<GLint>(slot_index % m_cache_side) * slot_size;
+    auto const y = static_cast<GLint>(slot_index / m_cache_side) * slot_size;
+
+    m_cache.bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, slot_size, slot_size, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    m_slots[slot_index] = slot{ key, m_frame, false };
+    m_resident[key] = slot_index;
+    m_dirty = true;
+}
+
+auto virtual_texture::rebuild_indirection() -> void
+{
+    std::uint32_t const levels = m_view.header->levels;
+    m_indirection.bind();
+
+    // Coarsest first, so a missing page can copy the entry of its parent
+    for(std::uint32_t i = levels; i-- > 0;) {
+        std::uint32_t const width = level_extent(m_indirection_width, i);
+        std::uint32_t const height = level_extent(m_indirection_height, i);
+        std::uint32_t const parent_width = level_extent(m_indirection_width, i + 1);
+        std::vector<unsigned char>& entries = m_entries[i];
+
+        for(std::uint32_t y = 0; y < height; ++y) {
+            for(std::uint32_t x = 0; x < width; ++x) {
+                unsigned char* const entry = &entries[(static_cast<std::size_t>(y) * width + x) * 4];
+
+                if(auto const it = m_resident.find(this->key_of(i, x, y)); it != m_resident.end()) {
+                    entry[0] = static_cast<unsigned char>(it->second % m_cache_side); // NOLINT
+                    entry[1] = static_cast<unsigned char>(it->second / m_cache_side); // NOLINT
+                    entry[2] = static_cast<unsigned char>(i);                         // NOLINT
+                    entry[3] = 255;                                                   // NOLINT
+                }
+                else if(i + 1 < levels) {
+                    std::size_t const parent = (static_cast<std::size_t>(y / 2) * parent_width + x / 2) * 4;
+                    std::memcpy(entry, &m_entries[i + 1][parent], 4);
+                }
+            }
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        static_cast<GLint>(i),
+                        0,
+                        0,
+                        static_cast<GLsizei>(width),
+                        static_cast<GLsizei>(height),
+                        GL_RGBA_INTEGER,
+                        GL_UNSIGNED_BYTE,
+                        entries.data());
+    }
+
+    m_dirty = false;
+}
+
+auto virtual_texture::valid() const noexcept -> bool
+{
+    return m_valid;
+}
+
+auto virtual_texture::request(std::vector<page_request> const& requests) -> void
+{
+    if(!m_valid) {
+        return;
+    }
+
+    std::vector<page_request> sorted = requests;
+    std::sort(
+        sorted.begin(), sorted.end(), [](page_request const& a, page_request const& b) { return a.level > b.level; });
+
+    // More than a few frames worth of uploads in flight would only go stale
+    std::size_t const max_loading = m_uploads_per_frame * 4;
+    std::uint32_t const levels = m_view.header->levels;
+
+    for(page_request const& r : sorted) {
+        if(r.level >= levels || r.x >= m_view.levels[r.level].pages_x || r.y >= m_view.levels[r.level].pages_y) {
+            continue;
+        }
+
+        // The pages it falls back to are in use too while it streams in
+        for(std::uint32_t level = r.level, x = r.x, y = r.y; level < levels; ++level, x /= 2, y /= 2) {
+            if(auto const it = m_resident.find(this->key_of(level, x, y)); it != m_resident.end()) {
+                m_slots[it->second].last_used = m_frame;
+            }
+        }
+
+        std::uint64_t const key = this->key_of(r.level, r.x, r.y);
+
+        if(m_resident.count(key) != 0 || m_loading.count(key) != 0 || m_loading.size() >= max_loading) {
+            continue;
+        }
+
+        m_loading.insert(key);
+        ++m_stats.requested;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            ++m_in_flight;
+        }
+
+        unsigned char const* const source = m_view.page(r.level, r.x, r.y);
+        std::size_t const bytes = m_view.page_bytes();
+
+        // Reading the page is what faults it in from disk, so it happens here
+        // rather than on the GL thread
+        m_pool->submit([this, key, source, bytes] {
+            auto j = std::make_unique<job>();
+            j->key = key;
+            j->pixels.assign(source, source + bytes); // NOLINT
+
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_finished.push_back(std::move(j));
+            --m_in_flight;
+            m_job_finished.notify_all();
+        });
+    }
+}
+
+auto virtual_texture::update() -> void
+{
+    if(!m_valid) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<job>> ready{};
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        while(!m_finished.empty() && ready.size() < m_uploads_per_frame) {
+            ready.push_back(std::move(m_finished.front()));
+            m_finished.pop_front();
+        }
+    }
+
+    for(auto const& j : ready) {
+        m_loading.erase(j->key);
+
+        // Dropped pages are requested again by the next feedback that still wants them
+        std::size_t const slot_index = this->take_slot();
+        if(slot_index == no_slot) {
+            ++m_stats.dropped;
+            continue;
+        }
+
+        this->upload_page(slot_index, j->key, j->pixels.data());
+        ++m_stats.uploaded;
+    }
+
+    if(m_dirty) {
+        this->rebuild_indirection();
+    }
+
+    ++m_frame;
+}
+
+auto virtual_texture::bind(unsigned int const cache_unit, unsigned int const indirection_unit) const noexcept -> void
+{
+    m_cache.bind(cache_unit);
+    m_indirection.bind(indirection_unit);
+}
+
+auto virtual_texture::set_uniforms(shader const& program, float const level_bias) const noexcept -> void
+{
+    if(!m_valid) {
+        return;
+    }
+
+    virtual_texture_header const& header = *m_view.header;
+    auto const slot_size = static_cast<float>(header.page_size + 2 * header.border);
+
+    program.set_vec4("vt_size",
+                     glm::vec4{ static_cast<float>(header.width),
+                                static_cast<float>(header.height),
+                                static_cast<float>(header.levels - 1),
+                                level_bias });
+    program.set_vec4("vt_page",
+                     glm::vec4{ static_cast<float>(header.page_size),
+                                static_cast<float>(header.border),
+                                slot_size,
+                                slot_size * static_cast<float>(m_cache_side) });
+}
+
+auto virtual_texture::resident_pages() const noexcept -> std::size_t
+{
+    return m_resident.size();
+}
+
+auto virtual_texture::capacity() const noexcept -> std::size_t
+{
+    return m_slots.size();
+}
+
+auto virtual_texture::stats() const noexcept -> statistics const&
+{
+    return m_stats;
+}
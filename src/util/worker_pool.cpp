@@ -0,0 +1,144 @@
+#include "util/worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+worker_pool::worker_pool(std::size_t num_threads)
+{
+    if(num_threads == 0) {
+        std::size_t const hardware = std::thread::hardware_concurrency();
+        num_threads = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    m_threads.reserve(num_threads);
+    for(std::size_t i = 0; i < num_threads; ++i) {
+        m_threads.emplace_back([this] { this->run(); });
+    }
+}
+
+worker_pool::~worker_pool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stop = true;
+    }
+    m_task_ready.notify_all();
+
+    for(auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+auto worker_pool::run() -> void
+{
+    while(true) {
+        std::function<void()> task{};
+
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_task_ready.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+
+            if(m_tasks.empty()) {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_busy;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            --m_busy;
+
+            if(m_busy == 0 && m_tasks.empty()) {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
+
+auto worker_pool::size() const noexcept -> std::size_t
+{
+    return m_threads.size();
+}
+
+auto worker_pool::submit(std::function<void()> task) -> void
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_tasks.push_back(std::move(task));
+    }
+    m_task_ready.notify_one();
+}
+
+auto worker_pool::wait_idle() -> void
+{
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_idle.wait(lock, [this] { return m_busy == 0 && m_tasks.empty(); });
+}
+
+auto worker_pool::parallel_for(std::size_t const count,
+                               std::size_t const grain,
+                               std::function<void(std::size_t, std::size_t)> const& fn) -> void
+{
+    if(count == 0) {
+        return;
+    }
+
+    std::size_t const num_workers = m_threads.size() + 1;
+    std::size_t const chunk = std::max(std::max(grain, std::size_t{ 1 }), (count + num_workers - 1) / num_workers);
+    std::size_t const num_chunks = (count + chunk - 1) / chunk;
+
+    if(num_chunks == 1) {
+        fn(0, count);
+        return;
+    }
+
+    // Chunks are claimed from a shared counter, so the calling thread keeps
+    // working instead of waiting for a worker to pick its chunk up. The state
+    // is shared because a helper may only get scheduled after everything is
+    // done, it then finds no chunk left and must not touch our stack.
+    struct shared_state
+    {
+        std::atomic<std::size_t> next{ 0 };
+        std::size_t finished = 0;
+        std::mutex mutex{};
+        std::condition_variable done{};
+    };
+
+    auto state = std::make_shared<shared_state>();
+    auto const* const body = &fn;
+
+    auto worker = [state, body, chunk, count, num_chunks] {
+        std::size_t processed = 0;
+
+        for(std::size_t c = state->next++; c < num_chunks; c = state->next++) {
+            std::size_t const begin = c * chunk;
+            (*body)(begin, std::min(begin + chunk, count));
+            ++processed;
+        }
+
+        if(processed == 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{ state->mutex };
+        state->finished += processed;
+        if(state->finished == num_chunks) {
+            state->done.notify_all();
+        }
+    };
+
+    for(std::size_t i = 1; i < std::min(num_chunks, num_workers); ++i) {
+        this->submit(worker);
+    }
+    worker();
+
+    std::unique_lock<std::mutex> lock{ state->mutex };
+    state->done.wait(lock, [&] { return state->finished == num_chunks; });
+}